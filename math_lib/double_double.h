@@ -0,0 +1,224 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef double_double_h
+#define double_double_h
+
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <Eigen/Core>
+
+// Double-double floating point number: an unevaluated sum hi + lo of two doubles with |lo| <= ulp(hi)/2,
+// giving ~106 bits of mantissa (~32 significant digits) with the exponent range of a double.
+// Arithmetic is built from the error free transformations of Dekker and Knuth (see Hida, Li and Bailey,
+// "Library for double-double and quad-double arithmetic", 2007) and runs on hardware floating point,
+// so it is much cheaper than mpf_class. Header only; usable as an Eigen scalar.
+// NOTE: relies on strict IEEE double evaluation - do not compile with -ffast-math or /fp:fast.
+// The type and its math functions live in a namespace so the functions are only found through argument
+// dependent lookup and never compete (through the implicit constructors) with the double overloads.
+namespace dd {
+
+class double_double {
+public:
+	double hi;
+	double lo;
+
+	double_double() : hi(0.0), lo(0.0) {}
+	double_double(const double &d) : hi(d), lo(0.0) {}
+	double_double(const int &i) : hi((double)i), lo(0.0) {}
+	double_double(const double &h, const double &l) : hi(h), lo(l) {}
+
+	// same accessor as mpf_class so the two can be swapped
+	double get_d() const { return hi; }
+
+	// error free transformations
+	// s + e = a + b exactly, requires |a| >= |b|
+	static double_double quick_two_sum(const double &a, const double &b)
+	{
+		double s = a + b;
+		return double_double(s, b - (s - a));
+	}
+	// s + e = a + b exactly
+	static double_double two_sum(const double &a, const double &b)
+	{
+		double s = a + b;
+		double bb = s - a;
+		return double_double(s, (a - (s - bb)) + (b - bb));
+	}
+	// p + e = a * b exactly
+	static double_double two_prod(const double &a, const double &b)
+	{
+		double p = a*b;
+#ifdef FP_FAST_FMA
+		return double_double(p, std::fma(a, b, -p));
+#else
+		double a_hi, a_lo, b_hi, b_lo;
+		_split(a, a_hi, a_lo);
+		_split(b, b_hi, b_lo);
+		return double_double(p, ((a_hi*b_hi - p) + a_hi*b_lo + a_lo*b_hi) + a_lo*b_lo);
+#endif
+	}
+
+	double_double operator-() const { return double_double(-hi, -lo); }
+
+	double_double &operator+=(const double_double &b)
+	{
+		double_double s = two_sum(hi, b.hi);
+		double_double t = two_sum(lo, b.lo);
+		s.lo += t.hi;
+		s = quick_two_sum(s.hi, s.lo);
+		s.lo += t.lo;
+		*this = quick_two_sum(s.hi, s.lo);
+		return *this;
+	}
+	double_double &operator-=(const double_double &b) { return *this += -b; }
+	double_double &operator*=(const double_double &b)
+	{
+		double_double p = two_prod(hi, b.hi);
+		p.lo += hi*b.lo + lo*b.hi;
+		*this = quick_two_sum(p.hi, p.lo);
+		return *this;
+	}
+	double_double &operator/=(const double_double &b)
+	{
+		// long division, three quotient digits
+		double q1 = hi / b.hi;
+		double_double r = *this;
+		double_double qb = b;
+		qb *= double_double(q1);
+		r -= qb;
+		double q2 = r.hi / b.hi;
+		qb = b;
+		qb *= double_double(q2);
+		r -= qb;
+		double q3 = r.hi / b.hi;
+		double_double q = quick_two_sum(q1, q2);
+		q += double_double(q3);
+		*this = q;
+		return *this;
+	}
+private:
+	// Dekker's split of a into two 26 bit halves
+	static void _split(const double &a, double &a_hi, double &a_lo)
+	{
+		const double splitter = 134217729.0; // 2^27 + 1
+		double t = splitter*a;
+		a_hi = t - (t - a);
+		a_lo = a - a_hi;
+	}
+};
+
+inline double_double operator+(double_double a, const double_double &b) { return a += b; }
+inline double_double operator-(double_double a, const double_double &b) { return a -= b; }
+inline double_double operator*(double_double a, const double_double &b) { return a *= b; }
+inline double_double operator/(double_double a, const double_double &b) { return a /= b; }
+
+inline bool operator==(const double_double &a, const double_double &b) { return a.hi == b.hi && a.lo == b.lo; }
+inline bool operator!=(const double_double &a, const double_double &b) { return !(a == b); }
+inline bool operator<(const double_double &a, const double_double &b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+inline bool operator>(const double_double &a, const double_double &b) { return b < a; }
+inline bool operator<=(const double_double &a, const double_double &b) { return !(b < a); }
+inline bool operator>=(const double_double &a, const double_double &b) { return !(a < b); }
+
+// math functions found through argument dependent lookup (Eigen calls them unqualified)
+inline double_double abs(const double_double &a) { return a.hi < 0.0 ? -a : a; }
+inline double_double fabs(const double_double &a) { return abs(a); }
+inline double_double sqrt(const double_double &a)
+{
+	// one Newton step on the double precision estimate (Karp's trick)
+	if (a.hi <= 0.0) return double_double(a.hi < 0.0 ? std::numeric_limits<double>::quiet_NaN() : 0.0);
+	double x = 1.0 / std::sqrt(a.hi);
+	double ax = a.hi*x;
+	double_double r = a - double_double::two_prod(ax, ax);
+	return double_double::two_sum(ax, r.hi*x*0.5);
+}
+inline double_double pow(const double_double &a, const int &n)
+{
+	double_double r(1.0);
+	double_double b = a;
+	int m = n < 0 ? -n : n;
+	while (m > 0){
+		if (m & 1) r *= b;
+		b *= b;
+		m >>= 1;
+	}
+	return n < 0 ? double_double(1.0) / r : r;
+}
+inline bool isfinite(const double_double &a) { return std::isfinite(a.hi) && std::isfinite(a.lo); }
+inline bool isnan(const double_double &a) { return std::isnan(a.hi) || std::isnan(a.lo); }
+inline bool isinf(const double_double &a) { return std::isinf(a.hi); }
+
+inline std::ostream &operator<<(std::ostream &os, const double_double &a) { return os << a.hi; }
+
+}
+
+using dd::double_double;
+
+namespace Eigen {
+	template<> struct NumTraits<double_double> : GenericNumTraits<double_double>
+	{
+		typedef double_double Real;
+		typedef double_double NonInteger;
+		typedef double_double Nested;
+		typedef double_double Literal;
+		enum {
+			IsComplex = 0,
+			IsInteger = 0,
+			IsSigned = 1,
+			RequireInitialization = 1,
+			ReadCost = 2,
+			AddCost = 20,
+			MulCost = 10
+		};
+		static inline double_double epsilon() { return double_double(4.93038065763132e-32); } // 2^-104
+		static inline double_double dummy_precision() { return double_double(1e-28); }
+		static inline double_double highest() { return double_double((std::numeric_limits<double>::max)()); }
+		static inline double_double lowest() { return double_double(-(std::numeric_limits<double>::max)()); }
+		static inline double_double infinity() { return double_double(std::numeric_limits<double>::infinity()); }
+		static inline double_double quiet_NaN() { return double_double(std::numeric_limits<double>::quiet_NaN()); }
+		static inline int digits10() { return 31; }
+		static inline int digits() { return 106; }
+	};
+
+	namespace internal {
+		template<> struct cast_impl<double_double, double> {
+			static inline double run(const double_double &x) { return x.get_d(); }
+		};
+		template<> struct cast_impl<double_double, float> {
+			static inline float run(const double_double &x) { return (float)x.get_d(); }
+		};
+	}
+}
+
+#endif
@@ -33,6 +33,8 @@
 
 #include <math_methods.h>
 #include <cstdlib>
+#include <cfloat>
+#include <limits>
 
 double Math_methods::_find_step( const VectorXd &da, const VectorXd &a )
 {
@@ -69,7 +71,63 @@ double Math_methods::RandomDouble( const double &min, const double&max )
 	return min + f*(max - min);
 }
 
+bool Reduced_KKT_Solver::factor( const MatrixXd &H, const MatrixXd &A, const VectorXd &d, const VectorXd &e )
+{
+	_A = &A;
+	_e_inv = e.cwiseInverse();
+
+	// reduced matrix M = H + D + AT*E^(-1)*A
+	// E^(-1) is strictly positive so the AT*E^(-1)*A term is formed as a symmetric rank update
+	// of the lower triangle only, which is all that the Cholesky/LDLT factorizations read
+	MatrixXd B = _e_inv.cwiseSqrt().asDiagonal()*A;
+	MatrixXd M = H;
+	M.diagonal() += d;
+	M.selfadjointView<Lower>().rankUpdate(B.transpose());
+
+	_llt.compute(M);
+	if (_llt.info() == Success)
+	{
+		_use_llt = true;
+		return true;
+	}
+
+	// H is only positive semi-definite in finite precision, fall back to a pivoted LDLT
+	_use_llt = false;
+	_ldlt.compute(M);
+	if (_ldlt.info() != Success) return false;
+
+	return true;
+}
+
+bool Reduced_KKT_Solver::solve( const VectorXd &r1, const VectorXd &r2, VectorXd &dx, VectorXd &dy ) const
+{
+	if (_A == NULL) return false;
+
+	VectorXd rhs = _A->transpose()*_e_inv.cwiseProduct(r2) - r1;
+	if (_use_llt) dx = _llt.solve(rhs);
+	else dx = _ldlt.solve(rhs);
+	dy = _e_inv.cwiseProduct(r2 - (*_A)*dx);
+
+	if (!dx.allFinite() || !dy.allFinite()) return false;
+
+	return true;
+}
+
 bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues )
+{
+	LOQO_Iterate iterate;
+	return quadratic_solver_loqo(H,A,b,r,fvalues,iterate,false);
+}
+
+bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues,
+	LOQO_Iterate &iterate, const bool &warm_start )
+{
+	QP_Result result;
+	return quadratic_solver_loqo(H,A,b,r,fvalues,iterate,warm_start,QP_Parameters(),result);
+}
+
+bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues,
+	LOQO_Iterate &iterate, const bool &warm_start, const QP_Parameters &parameters, QP_Result &result )
 {
 	// minimize f = 1/2 xT H x
 	// s.t. b <= Ax <= b + r
@@ -77,24 +135,20 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 
 	//double max_ele = H.maxCoeff();
 
-	MatrixXd KKT(2*n,2*n);
+	// The Newton system solved for both the predictor and corrector steps is
+	// | -(H + D)  AT || dx |   | r1 |
+	// |     A     E  || dy | = | r2 |
+	// D and E are diagonal so the system is solved in its reduced n x n form (see Reduced_KKT_Solver)
+	// and the factorization is shared by the predictor and corrector right hand sides.
+	Reduced_KKT_Solver KKT;
 	VectorXd c(n);
 	c.setZero();
-	VectorXd rhs(2*n);
-	rhs << c, b;
-	//std::cout<<" rhs:\n"<< rhs << std::endl;
-	
-	KKT << -(H + MatrixXd::Identity(n,n)), A.transpose(), A, MatrixXd::Identity(n,n);
-	//std::cout<<" Initial KKT matrix:\n"<< KKT << std::endl;
+	VectorXd ones(n);
+	ones.setOnes();
 
-	VectorXd soln(2*n);
-	soln = KKT.partialPivLu().solve(rhs);
-	//std::cout<<" Soln from Initial KKT matrix:\n"<< soln << std::endl;
 	VectorXd x(n);
-	x = soln.head(n);
 	VectorXd y(n);
-	y = soln.tail(n);
-    VectorXd g(n);
+	VectorXd g(n);
 	VectorXd z(n);
 	VectorXd t(n);
 	VectorXd s(n);
@@ -102,46 +156,68 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 	VectorXd w(n);
 	VectorXd p(n);
 	VectorXd q(n);
-	for (int j = 0; j < n; j++ ){
-		g(j) = std::max(abs(x(j)),100.0);
-		z(j) = g(j);
-		t(j) = g(j);
-		s(j) = g(j);
-		v(j) = std::max(abs(y(j)),100.0);
-		w(j) = v(j);
-		p(j) = std::max(abs(r(j) - w(j)),100.0);
-		q(j) = v(j);
+	result = QP_Result();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (warm_start)
+	{
+		if (iterate.x.rows() != n || iterate.y.rows() != n ||
+			iterate.g.rows() != n || iterate.z.rows() != n || iterate.t.rows() != n || iterate.s.rows() != n ||
+			iterate.v.rows() != n || iterate.w.rows() != n || iterate.p.rows() != n || iterate.q.rows() != n) return false;
+		// start from the supplied iterate, only the variables that have to stay positive and are at (or near)
+		// the boundary, e.g. those of newly added constraints, are moved inside it: by a fraction of the
+		// previous mean complementarity, or by the primal residual of the new problem if that is larger
+		double interior = 0.1*(iterate.z.dot(iterate.g) + iterate.v.dot(iterate.w) + iterate.s.dot(iterate.t) + iterate.p.dot(iterate.q))/(4*n);
+		if (!(interior > 0.0)) interior = 1e-8;
+		double violation = std::max((b - A*iterate.x + iterate.w).cwiseAbs().maxCoeff(),
+			std::max((r - iterate.w - iterate.p).cwiseAbs().maxCoeff(), (iterate.g - iterate.x - iterate.t).cwiseAbs().maxCoeff()));
+		if (violation > interior) interior = violation;
+		x = iterate.x;
+		y = iterate.y;
+		g = iterate.g.cwiseMax(interior);
+		z = iterate.z.cwiseMax(interior);
+		t = iterate.t.cwiseMax(interior);
+		s = iterate.s.cwiseMax(interior);
+		v = iterate.v.cwiseMax(interior);
+		w = iterate.w.cwiseMax(interior);
+		p = iterate.p.cwiseMax(interior);
+		q = iterate.q.cwiseMax(interior);
+	}
+	else
+	{
+		// initial system: D = I, E = I
+		std::chrono::steady_clock::time_point factor_start = std::chrono::steady_clock::now();
+		bool factored = KKT.factor(H,A,ones,ones);
+		result.factor_time += _elapsed(factor_start);
+		if (!factored || !KKT.solve(c,b,x,y))
+		{
+			result.status = QP_Result::Numerical_failure;
+			result.message = "LOQO: numerical issue with solving linear system";
+			result.total_time = _elapsed(start);
+			return false;
+		}
+		//std::cout<<" Soln from Initial KKT matrix:\n"<< x << y << std::endl;
+		for (int j = 0; j < n; j++ ){
+			g(j) = std::max(abs(x(j)),100.0);
+			z(j) = g(j);
+			t(j) = g(j);
+			s(j) = g(j);
+			v(j) = std::max(abs(y(j)),100.0);
+			w(j) = v(j);
+			p(j) = std::max(abs(r(j) - w(j)),100.0);
+			q(j) = v(j);
+		}
 	}
-	MatrixXd DebugMatrixV(n,10);
-	DebugMatrixV.col(0) = x;
-	DebugMatrixV.col(1) = y;
-	DebugMatrixV.col(2) = g;
-	DebugMatrixV.col(3) = z;
-	DebugMatrixV.col(4) = t;
-	DebugMatrixV.col(5) = s;
-	DebugMatrixV.col(6) = v;
-	DebugMatrixV.col(7) = w;
-	DebugMatrixV.col(8) = p;
-	DebugMatrixV.col(9) = q;
-	//std::cout<<" Current Variable matrix:\n"<< DebugMatrixV << std::endl;
 
 	double mu = (z.dot(g) + v.dot(w) + s.dot(t) + p.dot(q))/4*n; 
 
- 	// construct G Z, V W, S T, and P Q diagonal matrices
-    MatrixXd G(n,n);
-	MatrixXd Z(n,n);
- 	MatrixXd V(n,n);
- 	MatrixXd W(n,n);
- 	MatrixXd S(n,n);
- 	MatrixXd T(n,n);
- 	MatrixXd P(n,n);
- 	MatrixXd Q(n,n);
-	// below matrices are computed after predictor step
-	MatrixXd dG(n,n);
-	MatrixXd dV(n,n);
-	MatrixXd dT(n,n);
-	MatrixXd dP(n,n);
-
+	// diagonal matrices G Z, V W, S T, and P Q are kept as vectors
+	// the diagonal products used in the Newton system
+	VectorXd ts(n); // S^(-1)*T
+	VectorXd gz(n); // G*Z^(-1)
+	VectorXd vw(n); // V*W^(-1)
+	VectorXd qp(n); // P^(-1)*Q
+	VectorXd D(n);
+	VectorXd E(n);
 
 	// helper variables
 	VectorXd rho(n);
@@ -158,8 +234,14 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 	VectorXd betah(n);
 	VectorXd alphah(n);
 	VectorXd nuh(n);
-	VectorXd ev(n);
-	ev.setOnes();
+	VectorXd r1(n);
+	VectorXd r2(n);
+	rho.setZero();
+	nu.setZero();
+	alpha.setZero();
+	sigma.setZero();
+	tau.setZero();
+	beta.setZero();
 
 	// step directions
 	VectorXd dx(n);
@@ -172,84 +254,99 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 	VectorXd dw(n);
 	VectorXd dp(n);
 	VectorXd dq(n);
-	//MatrixXd DebugMatrixStepV(n,10);
 
-	bool converged = false;
-	double last_iterations_sig_fig = 0.0;
-	double primal_infeasibility = sqrt(rho.dot(rho) + tau.dot(tau) + alpha.dot(alpha) + nu.dot(nu))/(sqrt(b.dot(b)) + 1.0);
-	double  dual_infeasibilitiy = sqrt(sigma.dot(sigma) + beta.dot(beta));
-	double last_primal_infeasibility = primal_infeasibility;
-	double   last_dual_infeasibility = dual_infeasibilitiy;
-	double last_primal = 0;
-	double last_dual = 0;
-	VectorXd iter_minus_one_x = x;
+	// best iterate so far (see QP_Parameters::stall_iterations)
+	LOQO_Iterate best;
+	double best_gap = std::numeric_limits<double>::infinity();
+	double best_merit = std::numeric_limits<double>::infinity();
+	bool best_feasible = false;
+	// a warm start is usually infeasible for the constraints that changed while its gap is already
+	// small, so it is also measured, and has to converge, on the (relative) primal infeasibility
+	double feasibility_tolerance = warm_start ? parameters.gap_tolerance : std::numeric_limits<double>::infinity();
+	int stalled = 0;
 	int iter = 0;
-	while (!converged)
+	while (true)
 	{
-		iter++;
-// 		MatrixXd DebugV(n,10);
-// 		DebugV.col(0) = x;
-// 		DebugV.col(1) = y;
-// 		DebugV.col(2) = g;
-// 		DebugV.col(3) = z;
-// 		DebugV.col(4) = t;
-// 		DebugV.col(5) = s;
-// 		DebugV.col(6) = v;
-// 		DebugV.col(7) = w;
-// 		DebugV.col(8) = p;
-// 		DebugV.col(9) = q;
-// 		std::cout<<" Current Variable matrix (x,y,g,z,t,s,v,w,p,q):\n"<< DebugV << std::endl;
-
-		double primal_obj = 0.5*x.transpose()*H*x;
-		double   dual_obj = b.dot(y) - 0.5*x.transpose()*H*x - r.dot(q);
-
-		double sigfig = std::max(-std::log10(abs(primal_obj - dual_obj)/(abs(primal_obj) + 1.0)),0.0);
-
-		primal_infeasibility = sqrt(rho.dot(rho) + tau.dot(tau) + alpha.dot(alpha) + nu.dot(nu))/(sqrt(b.dot(b)) + 1.0);
-		dual_infeasibilitiy = sqrt(sigma.dot(sigma) + beta.dot(beta));
-
-		std::cout<<" Iteration["<<iter<<"]"<<std::endl;
-		std::cout<<"	Primal_obj = "<< primal_obj << std::endl;
-		std::cout<<"	Dual_obj = "<< dual_obj << std::endl;
-		std::cout<<"	Significant figures = "<< sigfig << std::endl;
-		std::cout<<"	Primal Infeasibility = "<< primal_infeasibility <<std::endl;
-		std::cout<<"	Dual Infeasibility = "<< dual_infeasibilitiy<<std::endl;
-
-		if ( sigfig > 6 )
-		{
-			converged = true;
-			fvalues = x; // strong duality gap
-			break;
-		}
-		if (dual_obj > primal_obj || sigfig < last_iterations_sig_fig) return false;
-
-		last_iterations_sig_fig = sigfig;
-		last_primal_infeasibility = primal_infeasibility;
-		last_dual_infeasibility = dual_infeasibilitiy;
-		last_primal = primal_obj;
-		last_dual = dual_obj;
-		iter_minus_one_x = x;
- 
-		G = g.asDiagonal();
-		Z = z.asDiagonal();
-		V = v.asDiagonal();
-		W = w.asDiagonal();
-		S = s.asDiagonal();
-		T = t.asDiagonal();
-		P = p.asDiagonal();
-		Q = q.asDiagonal();
-
-		MatrixXd D(n,n);
-		D = (S.inverse()*T + G*Z.inverse()).inverse();
-		MatrixXd E(n,n);
-		E = (V*W.inverse() + P.inverse()*Q).inverse();
-
+		VectorXd Hx = H*x;
+		// residuals of the current iterate, the primal ones are part of the convergence test
 		rho     = b - A*x + w;
 		nu      = -x + g - t;
 		alpha   = r - w - p;
-		sigma   = -A.transpose()*y - z + H*x;
+		sigma   = -A.transpose()*y - z + Hx;
 		tau     = -z -s;
 		beta    = y + q - v;
+		double primal_obj = 0.5*x.dot(Hx);
+		double   dual_obj = b.dot(y) - 0.5*x.dot(Hx) - r.dot(q);
+
+		double relative_gap = abs(primal_obj - dual_obj)/(abs(primal_obj) + 1.0);
+		double primal_infeasibility = sqrt(rho.dot(rho) + tau.dot(tau) + alpha.dot(alpha) + nu.dot(nu))/(sqrt(b.dot(b)) + 1.0);
+		double dual_infeasibilitiy = sqrt(sigma.dot(sigma) + beta.dot(beta));
+		result.duality_gap.push_back(relative_gap);
+		result.primal_infeasibility.push_back(primal_infeasibility);
+		result.dual_infeasibility.push_back(dual_infeasibilitiy);
+
+		if (parameters.verbose)
+		{
+			std::cout<<" Iteration["<<iter<<"]"<<std::endl;
+			std::cout<<"	Primal_obj = "<< primal_obj << std::endl;
+			std::cout<<"	Dual_obj = "<< dual_obj << std::endl;
+			std::cout<<"	Significant figures = "<< std::max(-std::log10(relative_gap),0.0) << std::endl;
+			std::cout<<"	Primal Infeasibility = "<< primal_infeasibility <<std::endl;
+			std::cout<<"	Dual Infeasibility = "<< dual_infeasibilitiy<<std::endl;
+		}
+
+		// an iterate with the dual objective above the primal one (weak duality violated) is never kept
+		bool feasible = primal_infeasibility < feasibility_tolerance;
+		double merit = warm_start ? relative_gap + primal_infeasibility : relative_gap;
+		if (dual_obj <= primal_obj && merit < best_merit)
+		{
+			best_merit = merit;
+			best_gap = relative_gap;
+			best_feasible = feasible;
+			best.x = x;
+			best.y = y;
+			best.g = g;
+			best.z = z;
+			best.t = t;
+			best.s = s;
+			best.v = v;
+			best.w = w;
+			best.p = p;
+			best.q = q;
+			best.iterations = iter;
+			stalled = 0;
+		}
+		else stalled++;
+
+		if (relative_gap < parameters.gap_tolerance && dual_obj <= primal_obj && feasible)
+		{
+			result.status = QP_Result::Converged;
+			break;
+		}
+		if (stalled > parameters.stall_iterations)
+		{
+			result.status = QP_Result::Stalled;
+			break;
+		}
+		if (iter >= parameters.max_iterations)
+		{
+			result.status = QP_Result::Max_iterations;
+			break;
+		}
+		if (parameters.time_budget > 0 && _elapsed(start) > parameters.time_budget)
+		{
+			result.status = QP_Result::Time_budget;
+			break;
+		}
+
+		ts = t.cwiseQuotient(s);
+		gz = g.cwiseQuotient(z);
+		vw = v.cwiseQuotient(w);
+		qp = q.cwiseQuotient(p);
+
+		D = (ts + gz).cwiseInverse();
+		E = (vw + qp).cwiseInverse();
+
 		// predictor nonlinearities
 		gamma_z = -z;
 		gamma_w = -w;
@@ -257,69 +354,32 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 		gamma_q = -q;
 
 		tauh = tau - gamma_s;
-		betah = beta - V*W.inverse()*gamma_w;
-		alphah = alpha - P*Q.inverse()*gamma_q;
-		nuh = nu + G*Z.inverse()*gamma_z;
-
-// 		MatrixXd RHSV(n,14);
-// 		RHSV.col(0) = rho;
-// 		RHSV.col(1) = nu;
-// 		RHSV.col(2) = alpha;
-// 		RHSV.col(3) = sigma;
-// 		RHSV.col(4) = tau;
-// 		RHSV.col(5) = beta;
-// 		RHSV.col(6) = gamma_z;
-// 		RHSV.col(7) = gamma_w;
-// 		RHSV.col(8) = gamma_s;
-// 		RHSV.col(9) = gamma_q;
-// 		RHSV.col(10) = tauh;
-// 		RHSV.col(11) = betah;
-// 		RHSV.col(12) = alphah;
-// 		RHSV.col(13) = nuh;
-// 		std::cout<<" Current RHS matrix (rho,nu,alpha,sigma,tau,beta,gamma_z,gamma_w,gamma_s,gamma_q,tauh,betah,alphah,nuh):\n"<< RHSV << std::endl;
-
-		rhs << (sigma - D*(nuh + S.inverse()*T*tauh)),(rho - E*(betah - P.inverse()*Q*alphah));
-
-		KKT << -(H + D), A.transpose(), A, E;
-// 		std::cout<<" Predictor KKT matrix:\n"<< KKT << std::endl;
-// 		std::cout<<" Predictor rhs:\n"<< rhs << std::endl;
-
-		soln = KKT.partialPivLu().solve(rhs);
-
-		if ( !soln.allFinite()){
-			std::cout<<" Numerical issue with solving linear system..."<<std::endl;
-			return false;
+		betah = beta - vw.cwiseProduct(gamma_w);
+		alphah = alpha - gamma_q.cwiseQuotient(qp);
+		nuh = nu + gz.cwiseProduct(gamma_z);
+
+		r1 = sigma - D.cwiseProduct(nuh + ts.cwiseProduct(tauh));
+		r2 = rho - E.cwiseProduct(betah - qp.cwiseProduct(alphah));
+
+		// factor once, solve for both the predictor and the corrector right hand sides
+		std::chrono::steady_clock::time_point factor_start = std::chrono::steady_clock::now();
+		bool factored = KKT.factor(H,A,D,E);
+		result.factor_time += _elapsed(factor_start);
+		if (!factored || !KKT.solve(r1,r2,dx,dy))
+		{
+			result.status = QP_Result::Numerical_failure;
+			break;
 		}
 
 		// get "delta" variables for predictor system ...
-		dx = soln.head(n);
-		dy = soln.tail(n); 
-
-// 		std::cout<<" Soln from Predictor KKT matrix:\n"<< soln << std::endl;
-// 		std::cout<<" dx:\n"<< dx << std::endl;
-// 		std::cout<<" dy:\n"<< dy << std::endl;
-
-		dw = -E*(betah -P.inverse()*Q*alphah +dy);
-		dt = -D*S.inverse()*T*(G*Z.inverse()*tauh - nuh + dx);
-		dz = G.inverse()*Z*(nuh - dx - dt);
-		dq = P.inverse()*Q*(dw - alphah);
-		dv = V*W.inverse()*(gamma_w - dw);
-		ds = gamma_s - S*T.inverse()*dt;
-		dp = P*Q.inverse()*(gamma_q - dq);
-		dg = G*Z.inverse()*(gamma_z - dz);
-
-		// Debug
-//  		DebugMatrixStepV.col(0) = dx;
-// 		DebugMatrixStepV.col(1) = dy;
-//  		DebugMatrixStepV.col(2) = dg;
-//  		DebugMatrixStepV.col(3) = dz;
-//  		DebugMatrixStepV.col(4) = dt;
-//  		DebugMatrixStepV.col(5) = ds;
-//  		DebugMatrixStepV.col(6) = dv;
-//  		DebugMatrixStepV.col(7) = dw;
-//  		DebugMatrixStepV.col(8) = dp;
-//  		DebugMatrixStepV.col(9) = dq;
-//  		std::cout<<" Current Step Variable matrix (after predictor step) (dx,dy,dg,dz,dt,ds,dv,dw,dp,dq):\n"<< DebugMatrixStepV << std::endl;
+		dw = -E.cwiseProduct(betah - qp.cwiseProduct(alphah) + dy);
+		dt = -D.cwiseProduct(ts.cwiseProduct(gz.cwiseProduct(tauh) - nuh + dx));
+		dz = (nuh - dx - dt).cwiseQuotient(gz);
+		dq = qp.cwiseProduct(dw - alphah);
+		dv = vw.cwiseProduct(gamma_w - dw);
+		ds = gamma_s - dt.cwiseQuotient(ts);
+		dp = (gamma_q - dq).cwiseQuotient(qp);
+		dg = gz.cwiseProduct(gamma_z - dz);
 
 		// compute step lengths for primal and dual systems
 		double alpha_p = _find_positivity_step(dg,g,dw,w,dt,t,dp,p);
@@ -332,65 +392,37 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 
 		// update mu
 		mu = (z.dot(g) + v.dot(w) + s.dot(t) + p.dot(q))*(fraction)/(4*n);
-		std::cout<<"	mu (predictor) = "<<mu<<" fraction = "<<fraction<< std::endl;
-
+		if (parameters.verbose) std::cout<<"	mu (predictor) = "<<mu<<" fraction = "<<fraction<< std::endl;
 
 		// update rhs variables rho,nu,alpha,sigma,tau,beta,gamma's
-		// first compute dG,dV,dT,and dP matrices from dg,dv,dt, and dp vectors above
-		dG = dg.asDiagonal();
-		dV = dv.asDiagonal();
-		dT = dt.asDiagonal();
-		dP = dp.asDiagonal();
-		gamma_z = mu*G.inverse()*ev - z - G.inverse()*dG*dz;
-		gamma_w = mu*V.inverse()*ev - w - V.inverse()*dV*dw;
-		gamma_s = mu*T.inverse()*ev - s - T.inverse()*dT*ds;
-		gamma_q = mu*P.inverse()*ev - q - P.inverse()*dP*dq;
+		gamma_z = (mu*VectorXd::Ones(n) - dg.cwiseProduct(dz)).cwiseQuotient(g) - z;
+		gamma_w = (mu*VectorXd::Ones(n) - dv.cwiseProduct(dw)).cwiseQuotient(v) - w;
+		gamma_s = (mu*VectorXd::Ones(n) - dt.cwiseProduct(ds)).cwiseQuotient(t) - s;
+		gamma_q = (mu*VectorXd::Ones(n) - dp.cwiseProduct(dq)).cwiseQuotient(p) - q;
 		tauh = tau - gamma_s;
-		betah = beta - V*W.inverse()*gamma_w;
-		alphah = alpha - P*Q.inverse()*gamma_q;
-		nuh = nu + G*Z.inverse()*gamma_z;
-
-		rhs << (sigma - D*(nuh + S.inverse()*T*tauh)),(rho - E*(betah - P.inverse()*Q*alphah));
+		betah = beta - vw.cwiseProduct(gamma_w);
+		alphah = alpha - gamma_q.cwiseQuotient(qp);
+		nuh = nu + gz.cwiseProduct(gamma_z);
 
-// 		std::cout<<" Corrector KKT matrix:\n"<< KKT << std::endl;
-// 		std::cout<<" Corrector rhs:\n"<< rhs << std::endl;
+		r1 = sigma - D.cwiseProduct(nuh + ts.cwiseProduct(tauh));
+		r2 = rho - E.cwiseProduct(betah - qp.cwiseProduct(alphah));
 
-		soln = KKT.partialPivLu().solve(rhs);
-
-		if ( !soln.allFinite()){
-			std::cout<<" Numerical issue with solving linear system..."<<std::endl;
-			return false;
+		// corrector step reuses the factorization of the predictor step
+		if (!KKT.solve(r1,r2,dx,dy))
+		{
+			result.status = QP_Result::Numerical_failure;
+			break;
 		}
 
 		// get "delta" variables for corrector system ...
-		dx = soln.head(n);
-		dy = soln.tail(n);
-
-// 		std::cout<<" Soln from Corrector KKT matrix:\n"<< soln << std::endl;
-// 		std::cout<<" dx:\n"<< dx << std::endl;
-// 		std::cout<<" dy:\n"<< dy << std::endl;
-
-		dw = -E*(betah -P.inverse()*Q*alphah +dy);
-		dt = -D*S.inverse()*T*(G*Z.inverse()*tauh - nuh + dx);
-		dz = G.inverse()*Z*(nuh - dx - dt);
-		dq = P.inverse()*Q*(dw - alphah);
-		dv = V*W.inverse()*(gamma_w - dw);
-		ds = gamma_s - S*T.inverse()*dt;
-		dp = P*Q.inverse()*(gamma_q - dq);
-		dg = G*Z.inverse()*(gamma_z - dz);
-
-		// Debug
-// 		DebugMatrixStepV.col(0) = dx;
-// 		DebugMatrixStepV.col(1) = dy;
-// 		DebugMatrixStepV.col(2) = dg;
-// 		DebugMatrixStepV.col(3) = dz;
-// 		DebugMatrixStepV.col(4) = dt;
-// 		DebugMatrixStepV.col(5) = ds;
-// 		DebugMatrixStepV.col(6) = dv;
-// 		DebugMatrixStepV.col(7) = dw;
-// 		DebugMatrixStepV.col(8) = dp;
-// 		DebugMatrixStepV.col(9) = dq;
-// 		std::cout<<" Current Step Variable matrix (after corrector step) (dx,dy,dg,dz,dt,ds,dv,dw,dp,dq):\n"<< DebugMatrixStepV << std::endl;
+		dw = -E.cwiseProduct(betah - qp.cwiseProduct(alphah) + dy);
+		dt = -D.cwiseProduct(ts.cwiseProduct(gz.cwiseProduct(tauh) - nuh + dx));
+		dz = (nuh - dx - dt).cwiseQuotient(gz);
+		dq = qp.cwiseProduct(dw - alphah);
+		dv = vw.cwiseProduct(gamma_w - dw);
+		ds = gamma_s - dt.cwiseQuotient(ts);
+		dp = (gamma_q - dq).cwiseQuotient(qp);
+		dg = gz.cwiseProduct(gamma_z - dz);
 
 		// compute step lengths for primal and dual systems
 		alpha_p = _find_positivity_step(dg,g,dw,w,dt,t,dp,p);
@@ -410,8 +442,331 @@ bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A,
 		v += (1/alpha_d)*dv;
 		s += (1/alpha_d)*ds;
 		q += (1/alpha_d)*dq;
-		
+		iter++;
+	}
+
+	result.iterations = iter;
+	result.final_gap = best_gap;
+	result.total_time = _elapsed(start);
+	result.accepted = best_feasible && best_gap < std::max(parameters.gap_tolerance, parameters.acceptable_gap_tolerance);
+	std::ostringstream message;
+	if (result.status == QP_Result::Converged) message<<"LOQO converged in "<<iter<<" iterations";
+	else
+	{
+		if (result.status == QP_Result::Stalled) message<<"LOQO stalled";
+		else if (result.status == QP_Result::Max_iterations) message<<"LOQO reached the iteration limit";
+		else if (result.status == QP_Result::Time_budget) message<<"LOQO reached the time budget";
+		else message<<"LOQO stopped on a numerical issue with solving linear system";
+		message<<" after "<<iter<<" iterations, best relative gap = "<<best_gap<<(result.accepted ? " (accepted)" : " (not converged)");
+	}
+	result.message = message.str();
+	if (!result.accepted) return false;
+
+	fvalues = best.x; // strong duality gap
+	best.iterations = iter;
+	iterate = best;
+	return true;
+}
+
+bool Math_methods::_add_active_constraint( MatrixXd &R, MatrixXd &J, VectorXd &d, int &iq, double &R_norm )
+{
+	int n = (int)d.rows();
+
+	// Givens rotations zero d(iq + 1), ... , d(n - 1) so that the new constraint
+	// only adds a single column to the upper triangular R
+	for (int j = n - 1; j >= iq + 1; j-- ){
+		double cc = d(j - 1);
+		double ss = d(j);
+		double h = sqrt(cc*cc + ss*ss);
+		if (h == 0.0) continue;
+		d(j) = 0.0;
+		ss = ss / h;
+		cc = cc / h;
+		if (cc < 0.0)
+		{
+			cc = -cc;
+			ss = -ss;
+			d(j - 1) = -h;
+		}
+		else d(j - 1) = h;
+		double xny = ss / (1.0 + cc);
+		VectorXd t1 = J.col(j - 1);
+		VectorXd t2 = J.col(j);
+		J.col(j - 1) = cc*t1 + ss*t2;
+		J.col(j) = xny*(t1 + J.col(j - 1)) - t2;
+	}
+
+	iq++;
+	R.col(iq - 1).head(iq) = d.head(iq);
+
+	// the constraint is linearly dependent on the active set
+	if (std::abs(d(iq - 1)) <= DBL_EPSILON*R_norm) return false;
+	R_norm = std::max(R_norm, std::abs(d(iq - 1)));
+
+	return true;
+}
+
+void Math_methods::_delete_active_constraint( MatrixXd &R, MatrixXd &J, std::vector<int> &active, VectorXd &u, const int &p, int &iq, const int &l )
+{
+	int qq = -1;
+	for (int i = p; i < iq; i++ ){
+		if (active[i] == l)
+		{
+			qq = i;
+			break;
+		}
+	}
+	if (qq < 0) return;
+
+	// remove constraint l from the active set
+	for (int i = qq; i < iq - 1; i++ ){
+		active[i] = active[i + 1];
+		u(i) = u(i + 1);
+		R.col(i) = R.col(i + 1);
+	}
+	active[iq - 1] = active[iq];
+	u(iq - 1) = u(iq);
+	active[iq] = 0;
+	u(iq) = 0.0;
+	R.col(iq - 1).head(iq).setZero();
+	iq--;
+
+	if (iq == 0) return;
+
+	// restore the upper triangular form of R with Givens rotations
+	for (int j = qq; j < iq; j++ ){
+		double cc = R(j,j);
+		double ss = R(j + 1,j);
+		double h = sqrt(cc*cc + ss*ss);
+		if (h == 0.0) continue;
+		cc = cc / h;
+		ss = ss / h;
+		R(j + 1,j) = 0.0;
+		if (cc < 0.0)
+		{
+			R(j,j) = -h;
+			cc = -cc;
+			ss = -ss;
+		}
+		else R(j,j) = h;
+		double xny = ss / (1.0 + cc);
+		for (int k = j + 1; k < iq; k++ ){
+			double t1 = R(j,k);
+			double t2 = R(j + 1,k);
+			R(j,k) = t1*cc + t2*ss;
+			R(j + 1,k) = xny*(t1 + R(j,k)) - t2;
+		}
+		VectorXd t1 = J.col(j);
+		VectorXd t2 = J.col(j + 1);
+		J.col(j) = cc*t1 + ss*t2;
+		J.col(j + 1) = xny*(J.col(j) + t1) - t2;
+	}
+}
+
+bool Math_methods::quadratic_solver_active_set( const MatrixXd &H, const MatrixXd &A, const MatrixXd &C, const VectorXd &b, const VectorXd &d, VectorXd &fvalues )
+{
+	// minimize f = 1/2 xT H x
+	// s.t. A x = b
+	//      C x >= d
+	// Dual active set method of Goldfarb and Idnani (Math. Prog. 27 (1983) 1-33).
+	// Starting from the unconstrained minimum (x = 0), the equality constraints and then the most violated
+	// inequality constraints are added to the active set one at a time, dropping active inequalities whose
+	// multiplier would become negative. The method works on the Cholesky factor H = L LT through
+	// J = L^(-T) Q and the upper triangular R of the QR factorization of L^(-1) N (N the active constraint
+	// normals), both updated with Givens rotations when a constraint is added or dropped. Each iteration
+	// therefore costs O(n^2) instead of a factorization of the full KKT system.
+	int n = (int)H.rows();
+	int p = (int)A.rows();
+	int m = (int)C.rows();
+
+	LLT<MatrixXd> llt(H);
+	if (llt.info() != Success)
+	{
+		std::cout<<" Active set QP: Hessian is not positive definite"<<std::endl;
+		return false;
+	}
+
+	// J = L^(-T)
+	MatrixXd J = llt.matrixU().solve(MatrixXd::Identity(n,n));
+	MatrixXd R(n,n);
+	R.setZero();
+	double R_norm = 1.0;
+	double c1 = H.trace();
+	double c2 = J.trace();
+
+	VectorXd x(n);
+	x.setZero(); // unconstrained minimum
+	VectorXd z(n);
+	VectorXd r(m + p);
+	VectorXd dv(n);
+	VectorXd np(n);
+	VectorXd u(m + p);
+	u.setZero();
+	VectorXd s(m);
+	std::vector<int> active(m + p, 0);
+	std::vector<int> iai(m, 0);
+	std::vector<bool> iaexcl(m, true);
+	int iq = 0;
+
+	// add the equality constraints
+	for (int i = 0; i < p; i++ ){
+		np = A.row(i).transpose();
+		dv = J.transpose()*np;
+		z = J.rightCols(n - iq)*dv.tail(n - iq);
+		r.head(iq) = R.topLeftCorner(iq,iq).triangularView<Upper>().solve(dv.head(iq));
+		// full step, the sign of the multiplier of an equality constraint is free
+		double t2 = 0.0;
+		double znp = z.dot(np);
+		if (std::abs(z.dot(z)) > DBL_EPSILON) t2 = (b(i) - np.dot(x)) / znp;
+		x += t2*z;
+		u(iq) = t2;
+		u.head(iq) -= t2*r.head(iq);
+		active[iq] = -i - 1;
+		if (!_add_active_constraint(R,J,dv,iq,R_norm))
+		{
+			std::cout<<" Active set QP: equality constraints are linearly dependent"<<std::endl;
+			return false;
+		}
+	}
+
+	for (int i = 0; i < m; i++ ) iai[i] = i;
+
+	VectorXd x_old(n);
+	VectorXd u_old(m + p);
+	std::vector<int> active_old(m + p, 0);
+	bool converged = false;
+	int iter = 0;
+	int max_iter = 10*(m + p) + 100;
+	while (!converged && iter < max_iter)
+	{
+		iter++;
+		// step 1: find the most violated inequality constraint
+		for (int i = p; i < iq; i++ ) iai[active[i]] = -1;
+		s = C*x - d;
+		double psi = 0.0;
+		for (int i = 0; i < m; i++ ){
+			iaexcl[i] = true;
+			psi += std::min(0.0, s(i));
+		}
+		if (std::abs(psi) <= m*DBL_EPSILON*c1*c2*100.0) // all constraints satisfied
+		{
+			converged = true;
+			break;
+		}
+
+		x_old = x;
+		u_old.head(iq) = u.head(iq);
+		for (int i = 0; i < iq; i++ ) active_old[i] = active[i];
+
+		bool added = false;
+		while (!added)
+		{
+			int ip = -1;
+			double ss = 0.0;
+			for (int i = 0; i < m; i++ ){
+				if (s(i) < ss && iai[i] != -1 && iaexcl[i])
+				{
+					ss = s(i);
+					ip = i;
+				}
+			}
+			if (ip < 0) // no violated constraint left
+			{
+				fvalues = x;
+				std::cout<<" Active set QP: "<<iter<<" iterations, "<<iq - p<<" active inequalities"<<std::endl;
+				return true;
+			}
+
+			np = C.row(ip).transpose();
+			u(iq) = 0.0;
+			active[iq] = ip;
+
+			// step 2: add constraint ip, dropping active constraints while only partial steps are possible
+			bool done = false;
+			while (!done)
+			{
+				dv = J.transpose()*np;
+				z = J.rightCols(n - iq)*dv.tail(n - iq);
+				r.head(iq) = R.topLeftCorner(iq,iq).triangularView<Upper>().solve(dv.head(iq));
+
+				// partial step length t1 (dual feasibility), full step length t2 (primal feasibility)
+				int l = -1;
+				double t1 = std::numeric_limits<double>::infinity();
+				for (int k = p; k < iq; k++ ){
+					if (r(k) > 0.0 && u(k) / r(k) < t1)
+					{
+						t1 = u(k) / r(k);
+						l = active[k];
+					}
+				}
+				double t2 = std::numeric_limits<double>::infinity();
+				if (std::abs(z.dot(z)) > DBL_EPSILON) t2 = -s(ip) / z.dot(np);
+
+				double t = std::min(t1, t2);
+				if (t == std::numeric_limits<double>::infinity())
+				{
+					std::cout<<" Active set QP: constraints are inconsistent"<<std::endl;
+					return false;
+				}
+
+				if (t2 == std::numeric_limits<double>::infinity())
+				{
+					// step in dual space only
+					u.head(iq) -= t*r.head(iq);
+					u(iq) += t;
+					iai[l] = l;
+					_delete_active_constraint(R,J,active,u,p,iq,l);
+					continue;
+				}
+
+				// step in primal and dual space
+				x += t*z;
+				u.head(iq) -= t*r.head(iq);
+				u(iq) += t;
+
+				if (t2 <= t1)
+				{
+					// full step: add constraint ip to the active set
+					if (!_add_active_constraint(R,J,dv,iq,R_norm))
+					{
+						// degenerate, exclude ip and restore the previous active set
+						iaexcl[ip] = false;
+						_delete_active_constraint(R,J,active,u,p,iq,ip);
+						for (int i = 0; i < m; i++ ) iai[i] = i;
+						for (int i = p; i < iq; i++ ){
+							active[i] = active_old[i];
+							u(i) = u_old(i);
+							iai[active[i]] = -1;
+						}
+						x = x_old;
+						done = true;
+					}
+					else
+					{
+						iai[ip] = -1;
+						done = true;
+						added = true;
+					}
+				}
+				else
+				{
+					// partial step: drop constraint l and try again
+					iai[l] = l;
+					_delete_active_constraint(R,J,active,u,p,iq,l);
+					s(ip) = C.row(ip).dot(x) - d(ip);
+				}
+			}
+		}
 	}
 
+	if (!converged)
+	{
+		std::cout<<" Active set QP: did not converge in "<<max_iter<<" iterations"<<std::endl;
+		return false;
+	}
+
+	fvalues = x;
+	std::cout<<" Active set QP: "<<iter<<" iterations, "<<iq - p<<" active inequalities"<<std::endl;
+
 	return true;
 }
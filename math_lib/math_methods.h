@@ -35,13 +35,19 @@
 #define math_methods_h
 
 #include <math_lib_module.h>
+#include <double_double.h>
+#ifdef SURFE_USE_GMP
 #include <gmpxx.h>
+#endif
 
 #include <vector>
 #include <iostream>
 #include <sstream>
 #include <fstream>
 #include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
 #include <Eigen/Core>
 #include <Eigen/Dense>
 #include <Eigen/Eigenvalues>
@@ -49,18 +55,146 @@
 
 using namespace Eigen;
 
+// extended precision scalar for computations where double round-off is a problem (e.g. the modified kernel).
+// Hardware double-double by default, GMP mpf_class when built with SURFE_USE_GMP
+#ifdef SURFE_USE_GMP
+typedef mpf_class extended_float;
+#else
+typedef double_double extended_float;
+#endif
+
+// Solves the symmetric quasi-definite interior point Newton system
+// | -(H + D)  AT || dx |   | r1 |
+// |     A     E  || dy | = | r2 |
+// where D and E are positive diagonal matrices (passed as vectors). dy is eliminated
+// giving the n x n positive definite system (H + D + AT E^(-1) A) dx = AT E^(-1) r2 - r1
+// which is Cholesky factored once and can then be reused for several right hand sides
+class MATH_LIB_EXPORT Reduced_KKT_Solver{
+private:
+	const MatrixXd *_A;
+	VectorXd _e_inv;
+	LLT<MatrixXd> _llt;
+	LDLT<MatrixXd> _ldlt;
+	bool _use_llt;
+public:
+	Reduced_KKT_Solver() : _A(NULL), _use_llt(true) {}
+	// A must outlive the solver as only a reference to it is kept
+	bool factor(const MatrixXd &H, const MatrixXd &A, const VectorXd &d, const VectorXd &e);
+	bool solve(const VectorXd &r1, const VectorXd &r2, VectorXd &dx, VectorXd &dy) const;
+};
+
+// Interior point iterate of Math_methods::quadratic_solver. The final iterate of a solve can be
+// passed to a later solve of a similar problem (e.g. with a few added constraints) as a warm start.
+template <class T>
+struct QP_Iterate{
+	Matrix <T, Dynamic, 1> x; // primal variables
+	Matrix <T, Dynamic, 1> y; // equality constraint multipliers
+	Matrix <T, Dynamic, 1> z; // inequality constraint multipliers
+	Matrix <T, Dynamic, 1> s; // inequality constraint slacks
+	int iterations; // # of iterations taken to reach this iterate
+	QP_Iterate() : iterations(0) {}
+};
+
+// Interior point iterate of Math_methods::quadratic_solver_loqo (see QP_Iterate)
+struct LOQO_Iterate{
+	VectorXd x, y, g, z, t, s, v, w, p, q;
+	int iterations;
+	LOQO_Iterate() : iterations(0) {}
+};
+
+// Stopping rule, limits and logging of the interior point QP solvers
+struct MATH_LIB_EXPORT QP_Parameters{
+	double mu_tolerance; // predictor-corrector: converged when the mean complementarity z_i*s_i is below this
+	double gap_tolerance; // LOQO: converged when the relative primal-dual gap is below this (1e-6: 6 significant figures)
+	// when a solve stops early (stall, iteration or time limit, numerical failure) the best iterate is still
+	// accepted if it meets these looser tolerances
+	double acceptable_mu_tolerance;
+	double acceptable_gap_tolerance;
+	int max_iterations;
+	// iterations without improving on the best iterate before giving up: the gap can go up for a few
+	// iterations (e.g. through round-off) without the solve being lost, so the solvers keep the best
+	// iterate and only stop once it has not improved for this many iterations
+	int stall_iterations;
+	double time_budget; // seconds, 0 for no limit
+	bool verbose; // per iteration log to std::cout
+	QP_Parameters() : mu_tolerance(1e-8), gap_tolerance(1e-6), acceptable_mu_tolerance(1e-6), acceptable_gap_tolerance(1e-4),
+		max_iterations(200), stall_iterations(5), time_budget(0), verbose(false) {}
+};
+
+// Outcome and convergence history of an interior point QP solve
+struct MATH_LIB_EXPORT QP_Result{
+	enum Status {Converged,Stalled,Max_iterations,Time_budget,Numerical_failure};
+	Status status;
+	bool accepted; // the returned iterate met the convergence or the acceptable tolerance
+	int iterations;
+	double final_gap; // mu (predictor-corrector) or relative gap (LOQO) of the returned iterate
+	std::vector<double> duality_gap; // per iteration, same measure as final_gap
+	std::vector<double> primal_infeasibility;
+	std::vector<double> dual_infeasibility;
+	double factor_time; // seconds spent factoring the Newton systems
+	double total_time;
+	std::string message;
+	QP_Result() : status(Converged), accepted(false), iterations(0), final_gap(0), factor_time(0), total_time(0) {}
+};
+
+// Solves the Newton system of the predictor-corrector QP solver (see Math_methods::quadratic_solver)
+// | H  -AT  -CT   0 || dx |     | rh |
+// | A    0    0   0 || dy | = - | ra |
+// | C    0    0  -I || dz |     | rc |
+// | 0    0    S   Z || ds |     | rsz|
+// S and Z are positive diagonals so ds and dz are eliminated, leaving the n x n normal equations
+// M = H + CT Z S^(-1) C. Equality constraints are solved through the na x na Schur complement A M^(-1) AT
+// (inequality rows with a zero slack are treated as equality rows for that iteration).
+template <class T>
+class QP_Normal_Equations{
+private:
+	const Matrix <T, Dynamic, Dynamic> *_A;
+	const Matrix <T, Dynamic, Dynamic> *_C;
+	Matrix <T, Dynamic, 1> _w; // Z S^(-1)
+	Matrix <T, Dynamic, 1> _s_inv;
+	std::vector<int> _active; // inequality rows whose slack is zero
+	Matrix <T, Dynamic, 1> _z_active;
+	Matrix <T, Dynamic, Dynamic> _E; // A and the active rows of C
+	Matrix <T, Dynamic, Dynamic> _MinvET;
+	LLT< Matrix <T, Dynamic, Dynamic> > _llt;
+	LDLT< Matrix <T, Dynamic, Dynamic> > _ldlt;
+	PartialPivLU< Matrix <T, Dynamic, Dynamic> > _schur;
+	bool _use_llt;
+
+	Matrix <T, Dynamic, Dynamic> _solve_M(const Matrix <T, Dynamic, Dynamic> &rhs) const
+	{
+		if (_use_llt) return _llt.solve(rhs);
+		return _ldlt.solve(rhs);
+	}
+public:
+	QP_Normal_Equations() : _A(NULL), _C(NULL), _use_llt(true) {}
+	// A and C must outlive the solver as only references to them are kept
+	bool factor(const Matrix <T, Dynamic, Dynamic> &H, const Matrix <T, Dynamic, Dynamic> &A, const Matrix <T, Dynamic, Dynamic> &C,
+		const Matrix <T, Dynamic, 1> &z, const Matrix <T, Dynamic, 1> &s);
+	// solves for the step given the residuals rh, ra, rc, and rsz
+	bool solve(const Matrix <T, Dynamic, 1> &rh, const Matrix <T, Dynamic, 1> &ra, const Matrix <T, Dynamic, 1> &rc, const Matrix <T, Dynamic, 1> &rsz,
+		Matrix <T, Dynamic, 1> &dx, Matrix <T, Dynamic, 1> &dy, Matrix <T, Dynamic, 1> &dz, Matrix <T, Dynamic, 1> &ds) const;
+};
+
 class MATH_LIB_EXPORT Math_methods{
 private:
 	template <class T> static T _find_step_length(const Matrix <T, Dynamic, 1> &a, const Matrix <T, Dynamic, 1> &da,
 		const Matrix <T, Dynamic, 1> &b, const Matrix <T, Dynamic, 1> &db);
 	template <class T> static void _rot(std::vector< std::vector < T > > &a, const T &s, const T &tau, const int &i, const int &j, const int &k, const int &l);
 	static double _get_double(const double &d) { return d;}
+	static double _get_double(const double_double &d) { return d.get_d(); }
+#ifdef SURFE_USE_GMP
 	static double _get_double(const mpf_class &d) { return d.get_d(); }
+#endif
+	static double _elapsed(const std::chrono::steady_clock::time_point &start) { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
 	static double _find_step(const VectorXd &da, const VectorXd &a);
 	static double _find_positivity_step( const VectorXd &da, const VectorXd &a,
 		                          const VectorXd &db, const VectorXd &b,
 								  const VectorXd &dc, const VectorXd &c,
 								  const VectorXd &dd, const VectorXd &d);
+	// active set (Goldfarb-Idnani) factorization updates
+	static bool _add_active_constraint(MatrixXd &R, MatrixXd &J, VectorXd &d, int &iq, double &R_norm);
+	static void _delete_active_constraint(MatrixXd &R, MatrixXd &J, std::vector<int> &active, VectorXd &u, const int &p, int &iq, const int &l);
 public:
 	template <class T> static bool sort_vector_w_index(std::vector<T> &arr, std::vector<int> &brr);
 	template <class T> static T max_element_wrt_zero(const T &a, const T &b);
@@ -73,7 +207,33 @@ public:
 		const Matrix <T, Dynamic, 1> &b,
 		const Matrix <T, Dynamic, 1> &d,
 		Matrix <T, Dynamic, 1> &fvalues);
-	static bool Math_methods::quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues );
+	// if warm_start is true the solve starts from iterate, on return iterate holds the final iterate
+	template <class T> static bool quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
+		const Matrix <T, Dynamic, Dynamic> &A,
+		const Matrix <T, Dynamic, Dynamic> &C,
+		const Matrix <T, Dynamic, 1> &b,
+		const Matrix <T, Dynamic, 1> &d,
+		Matrix <T, Dynamic, 1> &fvalues,
+		QP_Iterate<T> &iterate,
+		const bool &warm_start);
+	// parameters set the stopping rule and limits, result receives the convergence history (nothing is printed unless parameters.verbose)
+	template <class T> static bool quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
+		const Matrix <T, Dynamic, Dynamic> &A,
+		const Matrix <T, Dynamic, Dynamic> &C,
+		const Matrix <T, Dynamic, 1> &b,
+		const Matrix <T, Dynamic, 1> &d,
+		Matrix <T, Dynamic, 1> &fvalues,
+		QP_Iterate<T> &iterate,
+		const bool &warm_start,
+		const QP_Parameters &parameters,
+		QP_Result &result);
+	static bool quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues );
+	static bool quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues,
+		LOQO_Iterate &iterate, const bool &warm_start );
+	static bool quadratic_solver_loqo( const MatrixXd &H, const MatrixXd &A, const VectorXd &b, const VectorXd &r, VectorXd &fvalues,
+		LOQO_Iterate &iterate, const bool &warm_start, const QP_Parameters &parameters, QP_Result &result );
+	// same problem as quadratic_solver, solved with the dual active set method of Goldfarb and Idnani
+	static bool quadratic_solver_active_set( const MatrixXd &H, const MatrixXd &A, const MatrixXd &C, const VectorXd &b, const VectorXd &d, VectorXd &fvalues );
 };
 
 template <class T>
@@ -148,6 +308,122 @@ T Math_methods::_find_step_length(const Matrix <T, Dynamic, 1> &a, const Matrix
 	return alpha;
 }
 
+template <class T>
+bool QP_Normal_Equations<T>::factor(const Matrix <T, Dynamic, Dynamic> &H, const Matrix <T, Dynamic, Dynamic> &A, const Matrix <T, Dynamic, Dynamic> &C,
+	const Matrix <T, Dynamic, 1> &z, const Matrix <T, Dynamic, 1> &s)
+{
+	int n = (int)H.rows();
+	int na = (int)A.rows();
+	int nc = (int)C.rows();
+	using std::abs;
+	using std::sqrt;
+
+	_A = &A;
+	_C = &C;
+	_w.resize(nc);
+	_s_inv.resize(nc);
+	_active.clear();
+	// a slack at zero cannot be eliminated (S^(-1) does not exist) so its constraint row is kept
+	// with the equality constraints instead: C_j dx = -rc_j + ds_j where ds_j = -rsz_j/z_j
+	bool positive = true;
+	for (int j = 0; j < nc; j++){
+		if (abs(s(j)) <= 1e-12*abs(z(j)))
+		{
+			_active.push_back(j);
+			_w(j) = 0.0;
+			_s_inv(j) = 0.0;
+		}
+		else
+		{
+			_s_inv(j) = 1.0/s(j);
+			_w(j) = z(j)*_s_inv(j);
+			if (_w(j) <= 0.0) positive = false;
+		}
+	}
+	int nact = (int)_active.size();
+	_z_active.resize(nact);
+	for (int j = 0; j < nact; j++) _z_active(j) = z(_active[j]);
+
+	// M = H + CT W C with W = Z S^(-1)
+	// while W >= 0 it is formed as a rank update of the lower triangle only, but the step length rule
+	// allows z or s to leave the positive orthant in which case M may be indefinite
+	Matrix <T, Dynamic, Dynamic> M = H;
+	if (nc > 0)
+	{
+		if (positive)
+		{
+			Matrix <T, Dynamic, Dynamic> B(nc, n);
+			for (int j = 0; j < nc; j++) B.row(j) = sqrt(_w(j))*C.row(j);
+			M.template selfadjointView<Lower>().rankUpdate(B.transpose());
+		}
+		else M += C.transpose()*(_w.asDiagonal()*C);
+	}
+
+	_llt.compute(M);
+	_use_llt = (_llt.info() == Success);
+	if (!_use_llt)
+	{
+		_ldlt.compute(M);
+		if (_ldlt.info() != Success) return false;
+	}
+
+	// equality rows: A and the active inequality rows
+	_E.resize(na + nact, n);
+	if (na > 0) _E.topRows(na) = A;
+	for (int j = 0; j < nact; j++) _E.row(na + j) = C.row(_active[j]);
+
+	if (na + nact > 0)
+	{
+		_MinvET = _solve_M(_E.transpose());
+		Matrix <T, Dynamic, Dynamic> schur = _E*_MinvET;
+		_schur.compute(schur);
+	}
+
+	return true;
+}
+
+template <class T>
+bool QP_Normal_Equations<T>::solve(const Matrix <T, Dynamic, 1> &rh, const Matrix <T, Dynamic, 1> &ra, const Matrix <T, Dynamic, 1> &rc, const Matrix <T, Dynamic, 1> &rsz,
+	Matrix <T, Dynamic, 1> &dx, Matrix <T, Dynamic, 1> &dy, Matrix <T, Dynamic, 1> &dz, Matrix <T, Dynamic, 1> &ds) const
+{
+	if (_A == NULL || _C == NULL) return false;
+
+	int na = (int)_A->rows();
+	int nact = (int)_active.size();
+
+	// from rows 3 and 4: dz = -W (rc + C dx) - S^(-1) rsz
+	Matrix <T, Dynamic, 1> zc = _w.cwiseProduct(rc) + _s_inv.cwiseProduct(rsz);
+	// row 1 becomes M dx - ET dy = -rh - CT (W rc + S^(-1) rsz)
+	Matrix <T, Dynamic, 1> g = -rh - _C->transpose()*zc;
+	Matrix <T, Dynamic, 1> u = _solve_M(g);
+
+	if (na + nact > 0)
+	{
+		// row 2: E dx = e with dx = u + M^(-1) ET dy
+		Matrix <T, Dynamic, 1> e(na + nact);
+		if (na > 0) e.head(na) = -ra;
+		for (int j = 0; j < nact; j++) e(na + j) = -rc(_active[j]) - rsz(_active[j])/_z_active(j);
+		Matrix <T, Dynamic, 1> dye = _schur.solve(e - _E*u);
+		dx = u + _MinvET*dye;
+		dy = dye.head(na);
+
+		ds = (*_C)*dx + rc;
+		dz = -_w.cwiseProduct(ds) - _s_inv.cwiseProduct(rsz);
+		for (int j = 0; j < nact; j++) dz(_active[j]) = dye(na + j);
+	}
+	else
+	{
+		dy.resize(0);
+		dx = u;
+		ds = (*_C)*dx + rc;
+		dz = -_w.cwiseProduct(ds) - _s_inv.cwiseProduct(rsz);
+	}
+
+	if (!dx.allFinite() || !dy.allFinite() || !dz.allFinite() || !ds.allFinite()) return false;
+
+	return true;
+}
+
 template <class T>
 bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
 	const Matrix <T, Dynamic, Dynamic> &A,
@@ -155,6 +431,36 @@ bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
 	const Matrix <T, Dynamic, 1> &b,
 	const Matrix <T, Dynamic, 1> &d,
 	Matrix <T, Dynamic, 1> &fvalues)
+{
+	QP_Iterate<T> iterate;
+	return quadratic_solver(H, A, C, b, d, fvalues, iterate, false);
+}
+
+template <class T>
+bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
+	const Matrix <T, Dynamic, Dynamic> &A,
+	const Matrix <T, Dynamic, Dynamic> &C,
+	const Matrix <T, Dynamic, 1> &b,
+	const Matrix <T, Dynamic, 1> &d,
+	Matrix <T, Dynamic, 1> &fvalues,
+	QP_Iterate<T> &iterate,
+	const bool &warm_start)
+{
+	QP_Result result;
+	return quadratic_solver(H, A, C, b, d, fvalues, iterate, warm_start, QP_Parameters(), result);
+}
+
+template <class T>
+bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
+	const Matrix <T, Dynamic, Dynamic> &A,
+	const Matrix <T, Dynamic, Dynamic> &C,
+	const Matrix <T, Dynamic, 1> &b,
+	const Matrix <T, Dynamic, 1> &d,
+	Matrix <T, Dynamic, 1> &fvalues,
+	QP_Iterate<T> &iterate,
+	const bool &warm_start,
+	const QP_Parameters &parameters,
+	QP_Result &result)
 {
 	// Describe the Quadratic Optimization problem
 	// min (w.r.t. x) f(x) = 1/2 * xT * H * x => our objective function
@@ -191,11 +497,10 @@ bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
 	//       S[nc x nc]
 	//       Z[nc x nc]
 	//       I[nc x nc]
-	// EQN (1) can be reduced in size by block elimination since S and Z are strictly positive
-	// New EQN becomes
-	// | H  AT      CT   || dx|    |     -rh     | 
-	// | T   0	     0   ||-dy| =  |     -ra     |
-	// | C   0 -Z^(-1)*S ||-dz|    |-rc-Z^(-1)rsz|
+	// EQN (1) is never assembled. Since S and Z are strictly positive ds and dz are eliminated
+	// and the remaining n x n normal equations (H + CT*Z*S^(-1)*C) are factored once per iteration
+	// (see QP_Normal_Equations). The equality constraints are handled through the Schur complement
+	// T*(H + CT*Z*S^(-1)*C)^(-1)*TT.
 
 	int n = (int)H.rows();
 	int na = (int)A.rows();
@@ -205,344 +510,250 @@ bool Math_methods::quadratic_solver(const Matrix <T, Dynamic, Dynamic> &H,
 	/////////////////////////// Initialization ////////////////////////////
 	///////////////////////////////////////////////////////////////////////
 	// Calculation Helper Variables
-	T add, temp, temp2, temp_p, minus_one, elemsum, datanorm, zTs, mu, zero, prev_mu;
-	zero = 0.0;
-	elemsum = 0.0;
+	T datanorm, mu;
 	// KKT System
 	Matrix <T, Dynamic, 1> x(n);
 	x.setZero();
 	Matrix <T, Dynamic, 1> y(na);
 	y.setZero();
 	Matrix <T, Dynamic, 1> z(nc);
-	z.setZero();
 	Matrix <T, Dynamic, 1> s(nc);
-	s.setZero();
 	Matrix <T, Dynamic, 1> rh(n);
-	rh.setZero();
 	Matrix <T, Dynamic, 1> ra(na);
-	ra.setZero();
 	Matrix <T, Dynamic, 1> rc(nc);
-	rc.setZero();
 	Matrix <T, Dynamic, 1> rsz(nc);
-	rsz.setZero();
-
-	Matrix <T, Dynamic, 1> t1(n);
-	t1.setZero();
-	Matrix <T, Dynamic, 1> t2(n);
-	t2.setZero();
-	Matrix <T, Dynamic, 1> t3(n);
-	t3.setZero();
-	Matrix <T, Dynamic, 1> t4(na);
-	t4.setZero();
-	Matrix <T, Dynamic, 1> t5(nc);
-	t5.setZero();
-
-	Matrix <T, Dynamic, Dynamic> AT = A.transpose(); 
-	Matrix <T, Dynamic, Dynamic> CT = C.transpose();
-	Matrix <T, Dynamic, Dynamic> KKT(n + na + 2 * nc, n + na + 2 * nc);
-	Matrix <T, Dynamic, Dynamic> KKT_predictor(n + na + 2 * nc, n + na + 2 * nc);
-	Matrix <T, Dynamic, Dynamic> KKT_corrector(n + na + 2 * nc, n + na + 2 * nc);
-
-	Matrix <T, Dynamic, 1> solution_vector(n + na + 2 * nc);
-	solution_vector.setZero();
+
+	QP_Normal_Equations<T> KKT;
 
 	// step containers and related helper variables
-	T alpha, min_alpha_z, min_alpha_s, max_alpha_z, max_alpha_s, mu_aff, sigma;
-	Matrix <T, Dynamic, 1> alpha_z(nc);
-	alpha_z.setZero();
-	Matrix <T, Dynamic, 1> alpha_s(nc);
-	alpha_s.setZero();
-	Matrix <T, Dynamic, 1> dx_aff(n);
-	dx_aff.setZero();
-	Matrix <T, Dynamic, 1> dy_aff(na);
-	dy_aff.setZero();
+	T alpha, mu_aff, sigma;
 	Matrix <T, Dynamic, 1> dz_aff(nc);
-	dz_aff.setZero();
 	Matrix <T, Dynamic, 1> ds_aff(nc);
-	ds_aff.setZero();
 	Matrix <T, Dynamic, 1> rsz_aff(nc);
-	rsz_aff.setZero();
-	Matrix <T, Dynamic, 1> dvector(n + na + 2 * nc);
-	dvector.setZero();
-
 	Matrix <T, Dynamic, 1> dx(n);
-	dx.setZero();
 	Matrix <T, Dynamic, 1> dy(na);
-	dy.setZero();
 	Matrix <T, Dynamic, 1> dz(nc);
-	dz.setZero();
 	Matrix <T, Dynamic, 1> ds(nc);
-	ds.setZero();
-	Matrix <T, Dynamic, 1> dvector_corr(n + na + 2 * nc);
-	dvector_corr.setZero();
 
 	///////////////////////////////////////////////////////////////////////
 	////////////////////// End of Initialization //////////////////////////
 	///////////////////////////////////////////////////////////////////////
 
+	result = QP_Result();
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
 	// get norm of matrix 
 	datanorm = sqrt(H.maxCoeff());
 
-	// setup initial iterate for z and s...
-	for (int j = 0; j < nc; j++){
-		z(j) = datanorm;
-		s(j) = datanorm;
-	}
-
-	// Build KKT matrix blocks [1][1], [1][2], [1][3], [1][4]
-	for (int j = 0; j < n; j++){ // Matrix rows...
-		// Matrix columns...
-		// [1][1] Block
-		for (int k = 0; k < n; k++) KKT(j,k) = H(j,k);
-		// [1][2] Block
-		for (int k = 0; k < na; k++) KKT(j,n + k) = -1.0*AT(j,k);
-		// [1][3] Block
-		for (int k = 0; k < nc; k++) KKT(j,n + na + k) = -1.0*CT(j,k);
-		// [1][4] Block
-		for (int k = 0; k < nc; k++) KKT(j,n + na + nc + k) = 0.0;
-	}
-	// Build KKT matrix blocks [2][1], [2][2], [2][3], [2][4]
-	for (int j = 0; j < na; j++){
-		// [2][1] Block
-		for (int k = 0; k < n; k++)  KKT(n + j,k) = A(j,k);
-		// [2][2] Block
-		for (int k = 0; k < na; k++) KKT(n + j,n + k) = 0.0;
-		// [2][3] Block
-		for (int k = 0; k < nc; k++) KKT(n + j,n + na + k) = 0.0;
-		// [2][4] Block
-		for (int k = 0; k < nc; k++) KKT(n + j,n + na + nc + k) = 0.0;
-	}
-	// Build KKT matrix blocks [3][1], [3][2], [3][3], [3][4]
-	for (int j = 0; j < nc; j++){
-		// [3][1] Block
-		for (int k = 0; k < n; k++)  KKT(n + na + j, k) = C(j, k);
-		// [3][2] Block
-		for (int k = 0; k < na; k++) KKT(n + na + j,n + k) = 0.0;
-		// [3][3] Block
-		for (int k = 0; k < nc; k++) KKT(n + na + j,n + na + k) = 0.0;
-		// [3][4] Block
-		for (int k = 0; k < nc; k++){
-			if (j == k) KKT(n + na + j,n + na + nc + k) = -1.0;
-			else KKT(n + na + j,n + na + nc + k) = 0.0;
+	if (warm_start)
+	{
+		if (iterate.x.rows() != n || iterate.y.rows() != na || iterate.z.rows() != nc || iterate.s.rows() != nc) return false;
+		// start from the supplied iterate. The slacks are recomputed from x so the inequality residuals
+		// vanish, and only the multipliers and slacks at (or near) the boundary are moved inside it: by a
+		// fraction of the previous mean complementarity, or by the constraint violation of the new
+		// problem if that is larger, as a point closer to the boundary cannot absorb the violation
+		x = iterate.x;
+		y = iterate.y;
+		z = iterate.z;
+		s = C*x - d;
+		T interior = (nc > 0) ? T(0.1)*iterate.z.cwiseProduct(iterate.s).cwiseAbs().sum() / nc : T(0);
+		if (!(interior > T(0))) interior = T(1e-8)*datanorm;
+		T violation = (na > 0) ? T((A*x - b).cwiseAbs().maxCoeff()) : T(0);
+		for (int j = 0; j < nc; j++) if (-s(j) > violation) violation = -s(j);
+		if (violation > interior) interior = violation;
+		for (int j = 0; j < nc; j++){
+			if (z(j) < interior) z(j) = interior;
+			if (s(j) < interior) s(j) = interior;
 		}
 	}
-	// Build KKT matrix blocks [4][1], [4][2]
-	for (int j = 0; j < nc; j++){
-		// [4][1] Block
-		for (int k = 0; k < n; k++)  KKT(n + na + nc + j,k) = 0.0;
-		// [4][2] Block
-		for (int k = 0; k < na; k++) KKT(n + na + nc + j,n + k) = 0.0;
-	}
+	else
+	{
+		// setup initial iterate for z and s...
+		z.setConstant(datanorm);
+		s.setConstant(datanorm);
+
+		//////////////////////////////////////////////
+		// Determine Starting Point for the iterate //
+		//////////////////////////////////////////////
+		// 1st compute residuals for the affine system
+		rh = H*x - A.transpose()*y - C.transpose()*z; // rh residual = H*x - AT*y - CT*z
+		ra = A*x - b;                                 // ra residual = A*x - b
+		rc = C*x - s - d;                             // rc residual = C*x - s - d
+		rsz = s.cwiseProduct(z);                      // rsz residual = Z[]*S[]*e
 
-	// Build KKT matrix blocks: [4][3], [4][4]
-	for (int j = 0; j < nc; j++){
-		// [4][3] Block
-		for (int k = 0; k < nc; k++){
-			if (j == k) KKT(n + na + nc + j,n + na + k) = s(j);
-			else KKT(n + na + nc + j,n + na + k) = 0.0;
-		}
-		// [4][4] Block
-		for (int k = 0; k < nc; k++){
-			if (j == k) KKT(n + na + nc + j,n + na + nc + k) = z(j);
-			else KKT(n + na + nc + j,n + na + nc + k) = 0.0;
+		// Solve Affine system ...
+		std::chrono::steady_clock::time_point factor_start = std::chrono::steady_clock::now();
+		bool factored = KKT.factor(H, A, C, z, s);
+		result.factor_time += _elapsed(factor_start);
+		if (!factored || !KKT.solve(rh, ra, rc, rsz, dx, dy, dz, ds))
+		{
+			result.status = QP_Result::Numerical_failure;
+			result.message = "QPP did not converge. Numerical issue with solving linear system";
+			result.total_time = _elapsed(start);
+			return false;
 		}
-	}
-
-	//////////////////////////////////////////////
-	// Determine Starting Point for the iterate //
-	//////////////////////////////////////////////
-	// 1st compute residuals for the affine system
-	t1 = H*x;
-	t2 = AT*y;
-	t3 = CT*z;
-	t4 = A*x;
-	t5 = C*x;
-	// 	_output_vector(t3,"t3.txt"); // debug
-	// 	_output_vector(z,"z.txt");
-	// 	_output_matrix(CT,"CT.txt");
-	for (int j = 0; j < n; j++){ // rh residual = H*x - AT*y - CT*z
-		rh(j) = t1(j) - t2(j) - t3(j);
-		solution_vector(j) = -1.0*rh(j);
-	}
-	for (int j = 0; j < na; j++){ // ra residual = A*x - b
-		ra(j) = t4(j) - b(j);
-		solution_vector(n + j) = -1.0*ra(j);
-	}
-	zTs = 0.0; // re-initialize this adder
-	for (int j = 0; j < nc; j++){ // rc residual = C*x - s - d
-		rc(j) = t5(j) - s(j) - d(j);
-		rsz(j) = s(j) * z(j); // rsz residual = Z[]*S[]*e
-		solution_vector(n + na + j) = -1.0*rc(j);
-		zTs += rsz(j);
-		solution_vector(n + na + nc + j) = -1.0*rsz(j);
-	}
-	// Solve Affine system ...
-//	for (int j = 0; j < n + na + 2 * nc; j++) dvector(j) = solution_vector(j);
-	for (int j = 0; j < n + na + 2 * nc; j++){
-		for (int k = 0; k < n + na + 2 * nc; k++) KKT_predictor(j,k) = KKT(j,k);
-	}
-	dvector = KKT_predictor.partialPivLu().solve(solution_vector);
-
-// 	for (int j = 0; j < n + na + 2 * nc; j++ ){
-// 		cout<<" dvector["<<j<<"]= "<<dvector[j].get_d()<<endl;
-// 	}
-
-	for (int j = 0; j < n;  j++) dx(j) = dvector(j);
-	for (int j = 0; j < na; j++) dy(j) = dvector(j + n);
-	for (int j = 0; j < nc; j++){
-		dz(j) = dvector(j + n + na);
-		ds(j) = dvector(j + n + na + nc);
-	}
 
-	// Update iterate using full affine scaling
-	// (x,y,z,s)->(x,y,z,s) + (dx_aff,dy_aff,dz_aff,ds_aff)
-	for (int j = 0; j < n; j++) x(j) += dx(j);
-	for (int j = 0; j < na; j++) y(j) += dy(j);
-	for (int j = 0; j < nc; j++) z(j) += dz(j);
-	for (int j = 0; j < nc; j++) s(j) += ds(j);
+		// Update iterate using full affine scaling
+		// (x,y,z,s)->(x,y,z,s) + (dx_aff,dy_aff,dz_aff,ds_aff)
+		x += dx;
+		y += dy;
+		z += dz;
+		s += ds;
 
-	// above iterate likely infeasible
-	// measure violation
-	std::vector < T > max_violation_list;
-	for (int j = 0; j < nc; j++){
-		T v1 = -1.0*z(j);
-		T v2 = -1.0*s(j);
-		T maximum = max_element_wrt_zero(v1, v2);
-		if (maximum < 0) maximum = 0.0;
-		max_violation_list.push_back(maximum);
-	}
-	// sort max_violation_list
-	std::sort(max_violation_list.begin(), max_violation_list.end());
-	T max_violation = max_violation_list[nc - 1];
-	// compute the iterate shift for complementary variables z & s
-	T shift = 1000.0 + 2.0*max_violation;
-	// update complementary variables ...
-	for (int j = 0; j < nc; j++){
-		z(j) += shift;
-		s(j) += shift;
+		// above iterate likely infeasible
+		// measure violation
+		T max_violation = 0.0;
+		for (int j = 0; j < nc; j++){
+			T v1 = -1.0*z(j);
+			T v2 = -1.0*s(j);
+			T maximum = max_element_wrt_zero(v1, v2);
+			if (maximum > max_violation) max_violation = maximum;
+		}
+		// compute the iterate shift for complementary variables z & s
+		T shift = 1000.0 + 2.0*max_violation;
+		// update complementary variables ...
+		z.array() += shift;
+		s.array() += shift;
 	}
 
-	bool found_soln = false;
+	// best iterate so far (see QP_Parameters::stall_iterations)
+	Matrix <T, Dynamic, 1> best_x, best_y, best_z, best_s;
+	double best_mu = std::numeric_limits<double>::infinity();
+	double best_merit = std::numeric_limits<double>::infinity();
+	bool best_feasible = false;
+	// a warm start is usually infeasible for the constraints that changed and its complementarity
+	// can already be small, so it is also measured, and has to converge, on the residuals and positivity
+	double feasibility_tolerance = std::sqrt(parameters.mu_tolerance)*(1.0 + _get_double(datanorm));
+	int stalled = 0;
 	int iter = 0;
-	while (!found_soln)
+	while (true)
 	{
-		// Update KKT matrix blocks: [4][3], [4][4]
-		for (int j = 0; j < nc; j++){
-			// [4][3] Block
-			for (int k = 0; k < nc; k++){
-				if (j == k) KKT(n + na + nc + j,n + na + k) = s(j);
-				else KKT(n + na + nc + j,n + na + k) = 0.0;
-			}
-			// [4][4] Block
-			for (int k = 0; k < nc; k++){
-				if (j == k) KKT(n + na + nc + j,n + na + nc + k) = z(j);
-				else KKT(n + na + nc + j,n + na + nc + k) = 0.0;
-			}
-		}
+		// COMPUTE RESIDUALS ...
+		rh = H*x - A.transpose()*y - C.transpose()*z;
+		ra = A*x - b;
+		rc = C*x - s - d;
+		rsz = s.cwiseProduct(z);
 
-		//_output_matrix(KKT,"KKT_matrix.txt"); // debug
+		//calculate mu
+		mu = rsz.sum() / nc;
+		double mu_d = _get_double(mu);
+		double infeasibility = _get_double(T(sqrt(T(ra.squaredNorm() + rc.squaredNorm()))));
+		result.duality_gap.push_back(mu_d);
+		result.primal_infeasibility.push_back(infeasibility);
+		result.dual_infeasibility.push_back(_get_double(T(rh.norm())));
+		infeasibility += result.dual_infeasibility.back();
+		if (parameters.verbose) cout<<" mu["<<iter<<"]= "<<mu_d<<endl;
+
+		bool feasible = !warm_start || (infeasibility < feasibility_tolerance && (nc == 0 || (z.minCoeff() >= T(0) && s.minCoeff() >= T(0))));
+		double merit = warm_start ? mu_d + infeasibility : mu_d;
+		if (merit < best_merit)
+		{
+			best_merit = merit;
+			best_mu = mu_d;
+			best_feasible = feasible;
+			best_x = x;
+			best_y = y;
+			best_z = z;
+			best_s = s;
+			stalled = 0;
+		}
+		else stalled++;
 
-		// COMPUTE RESIDUALS ...
-		t1 = H*x;
-		t2 = AT*y;
-		t3 = CT*z;
-		t4 = A*x;
-		t5 = C*x;
-		for (int j = 0; j < n; j++){ // rh residual = H*x - AT*y - CT*z
-			rh(j) = t1(j) - t2(j) - t3(j);
-			solution_vector(j) = -1.0*rh(j);
+		if (mu_d < parameters.mu_tolerance && feasible)
+		{
+			result.status = QP_Result::Converged;
+			break;
 		}
-		for (int j = 0; j < na; j++){ // ra residual = A*x - b
-			ra(j) = t4(j) - b(j);
-			solution_vector(n + j) = -1.0*ra(j);
+		if (stalled > parameters.stall_iterations)
+		{
+			result.status = QP_Result::Stalled;
+			break;
 		}
-		zTs = 0.0; // re-initialize this adder
-		for (int j = 0; j < nc; j++){ // rc residual = C*x - s - d
-			rc(j) = t5(j) - s(j) - d(j);
-			rsz(j) = s(j) * z(j); // rsz residual = Z[]*S[]*e
-			solution_vector(n + na + j) = -1.0*rc(j);
-			zTs += rsz(j);
-			solution_vector(n + na + nc + j) = -1.0*rsz(j);
+		if (iter >= parameters.max_iterations)
+		{
+			result.status = QP_Result::Max_iterations;
+			break;
 		}
-		//calculate mu
-		mu = zTs / nc;
-		double mu_d = _get_double(mu); // debug
-		cout<<" mu["<<iter<<"]= "<<mu_d<<endl;
-		if (iter > 5 && mu > prev_mu)
+		if (parameters.time_budget > 0 && _elapsed(start) > parameters.time_budget)
 		{
-			cout<<" QPP did not converge. Due to precision problem..."<<endl;
-			return false;
+			result.status = QP_Result::Time_budget;
+			break;
 		}
-		prev_mu = mu;
-		if (mu < 0.00000001)
+
+		// the Newton matrix only depends on the current z and s so it is factored once and
+		// used for both the predictor and the corrector right hand sides
+		std::chrono::steady_clock::time_point factor_start = std::chrono::steady_clock::now();
+		bool factored = KKT.factor(H, A, C, z, s);
+		result.factor_time += _elapsed(factor_start);
+		if (!factored)
 		{
-			found_soln = true;
-			for (int j = 0; j < n; j++) fvalues(j) = x(j); // get solution
-			continue;
+			result.status = QP_Result::Numerical_failure;
+			break;
 		}
 		///////////////////////////////////////////////////////
 		/////////////////// Predictor Step ////////////////////
 		///////////////////////////////////////////////////////
 		// Solve Affine system ...
-		//cout<<" solution vector for affine system "<<endl;
-//		for (int j = 0; j < n + na + 2 * nc; j++) dvector(j) = solution_vector(j);
-		for (int j = 0; j < n + na + 2 * nc; j++){
-			for (int k = 0; k < n + na + 2 * nc; k++) KKT_predictor(j,k) = KKT(j,k);
-		}
-		dvector = KKT_predictor.partialPivLu().solve(solution_vector);
-
-		// get step vectors...
-		for (int j = 0; j < nc; j++){
-			dz_aff(j) = dvector(j + n + na);
-			ds_aff(j) = dvector(j + n + na + nc);
+		if (!KKT.solve(rh, ra, rc, rsz, dx, dy, dz_aff, ds_aff))
+		{
+			result.status = QP_Result::Numerical_failure;
+			break;
 		}
 
 		alpha = _find_step_length(s, ds_aff, z, dz_aff);
 
 		// calculate mu_aff
-		elemsum = 0.0;
-		for (int j = 0; j < nc; j++) elemsum += (z(j) + alpha*dz_aff(j)) * (s(j) + alpha*ds_aff(j));
-		mu_aff = elemsum / nc;
+		mu_aff = ((z + alpha*dz_aff).cwiseProduct(s + alpha*ds_aff)).sum() / nc;
 		sigma = (mu_aff / mu)*(mu_aff / mu)*(mu_aff / mu);
 
 		///////////////////////////////////////////////////////
 		/////////////////// Corrector Step ////////////////////
 		///////////////////////////////////////////////////////
 		// modify rsz vector using the calculated correctors ...
-		// recompute rsz residuals...
 		// Z*S*e - sigma*mu*e + dz_aff*ds_aff*e
-		for (int j = 0; j < nc; j++){
-			rsz_aff(j) = rsz(j) - sigma*mu + dz_aff(j) * ds_aff(j);
-			solution_vector(n + na + nc + j) = -1.0*rsz_aff(j);
-		}
-//		for (int j = 0; j < n + na + 2 * nc; j++) dvector_corr(j) = solution_vector(j);
+		rsz_aff = rsz + dz_aff.cwiseProduct(ds_aff);
+		rsz_aff.array() -= sigma*mu;
 
 		// Solve the corrected linear system ...
-		for (int j = 0; j < n + na + 2 * nc; j++){
-			for (int k = 0; k < n + na + 2 * nc; k++) KKT_corrector(j,k) = KKT(j,k);
-		}
-		dvector_corr = KKT_corrector.partialPivLu().solve(solution_vector);
-
-		// get step vectors from corrector step...
-		for (int j = 0; j < n; j++){
-			dx(j) = dvector_corr(j);
-			if (j < na) dy(j) = dvector_corr(j + n);
-			if (j < nc)
-			{
-				dz(j) = dvector_corr(j + n + na);
-				ds(j) = dvector_corr(j + n + na + nc);
-			}
+		if (!KKT.solve(rh, ra, rc, rsz_aff, dx, dy, dz, ds))
+		{
+			result.status = QP_Result::Numerical_failure;
+			break;
 		}
 
 		alpha = _find_step_length(s, ds, z, dz);
 
 		// update x,y,z,s vectors using alpha step
-		for (int j = 0; j < n; j++) x(j) += alpha*dx(j);
-		for (int j = 0; j < na; j++) y(j) += alpha*dy(j);
-		for (int j = 0; j < nc; j++) z(j) += alpha*dz(j);
-		for (int j = 0; j < nc; j++) s(j) += alpha*ds(j);
+		x += alpha*dx;
+		y += alpha*dy;
+		z += alpha*dz;
+		s += alpha*ds;
 		iter++;
 	}
+
+	result.iterations = iter;
+	result.final_gap = best_mu;
+	result.total_time = _elapsed(start);
+	result.accepted = best_feasible && best_mu < std::max(parameters.mu_tolerance, parameters.acceptable_mu_tolerance);
+	std::ostringstream message;
+	if (result.status == QP_Result::Converged) message<<"QPP converged in "<<iter<<" iterations";
+	else
+	{
+		if (result.status == QP_Result::Stalled) message<<"QPP stalled";
+		else if (result.status == QP_Result::Max_iterations) message<<"QPP reached the iteration limit";
+		else if (result.status == QP_Result::Time_budget) message<<"QPP reached the time budget";
+		else message<<"QPP stopped on a numerical issue with solving linear system";
+		message<<" after "<<iter<<" iterations, best mu = "<<best_mu<<(result.accepted ? " (accepted)" : " (not converged)");
+	}
+	result.message = message.str();
+	if (!result.accepted) return false;
+
+	fvalues = best_x; // get solution
+	iterate.x = best_x;
+	iterate.y = best_y;
+	iterate.z = best_z;
+	iterate.s = best_s;
+	iterate.iterations = iter;
 	return true;
 }
 
@@ -368,6 +368,31 @@ double Cubic::dzz()
 	else return -3.0* (((_z_delta*_z_delta) / _radius) + _radius);
 }
 
+bool Cubic::radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi) const
+{
+	for (int j = 0; j < n; j++ )
+	{
+		double r = sqrt(r2[j]);
+		if (ddphi != NULL) ddphi[j] = (r != 0) ? 3.0 / r : 0.0;
+		phi[j] = r*r*r;
+		dphi[j] = 3.0*r;
+	}
+	return true;
+}
+
+double Cubic::hessian_bound(const double &, const double &r_max) const
+{
+	// eigenvalues 3r and 6r
+	return 6.0*r_max;
+}
+
+double Cubic::third_derivative_bound(const double &, const double &) const
+{
+	// phi = f(r^2): third derivatives 4f''(d_ij x_k + d_ik x_j + d_jk x_i) + 8f''' x_i x_j x_k, within 12|f''|r + 8|f'''|r^3.
+	// f = s^1.5: 9 + 3
+	return 12.0;
+}
+
 double ACubic::basis()
 {
 	scaled_radius();
@@ -592,6 +617,34 @@ double Gaussian::dzz()
 	return (2.0*_shape_parameter*_shape_parameter - 4.0*pow(_shape_parameter, 4)*_z_delta*_z_delta)*exp(-(_shape_parameter*_shape_parameter*_radius*_radius));
 }
 
+bool Gaussian::radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi) const
+{
+	double e2 = _shape_parameter*_shape_parameter;
+	for (int j = 0; j < n; j++ )
+	{
+		double g = exp(-e2*r2[j]);
+		phi[j] = g;
+		dphi[j] = -2.0*e2*g;
+		if (ddphi != NULL) ddphi[j] = 4.0*e2*e2*g;
+	}
+	return true;
+}
+
+double Gaussian::hessian_bound(const double &r_min, const double &r_max) const
+{
+	// eigenvalues -2e2*g and 2e2*(2u - 1)*g, u = e2*r^2: both within 2e2*(1 + 2u)*exp(-u), largest at u = 0.5
+	double e2 = _shape_parameter*_shape_parameter;
+	double u = std::min(std::max(0.5, e2*r_min*r_min), e2*r_max*r_max);
+	return 2.0*e2*(1.0 + 2.0*u)*exp(-u);
+}
+
+double Gaussian::third_derivative_bound(const double &, const double &) const
+{
+	// 12|f''|r + 8|f'''|r^3 = e2^1.5*(12u^0.5 + 8u^1.5)*exp(-u), u = e2*r^2, u^0.5*exp(-u) largest at u = 0.5 and u^1.5*exp(-u) at u = 1.5
+	double e2 = _shape_parameter*_shape_parameter;
+	return pow(e2, 1.5)*(12.0*sqrt(0.5*exp(-1.0)) + 8.0*pow(1.5*exp(-1.0), 1.5));
+}
+
 double AGaussian::basis()
 {
 	scaled_radius();
@@ -804,6 +857,31 @@ double MQ::dzz()
 	return (_z_delta*_z_delta) / pow(_shape_parameter + _radius*_radius, 1.5) - (1.0 / pow(_shape_parameter + _radius*_radius, 0.5));
 }
 
+bool MQ::radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi) const
+{
+	for (int j = 0; j < n; j++ )
+	{
+		double q = sqrt(_shape_parameter + r2[j]);
+		phi[j] = q;
+		dphi[j] = 1.0 / q;
+		if (ddphi != NULL) ddphi[j] = -1.0 / (q*q*q);
+	}
+	return true;
+}
+
+double MQ::hessian_bound(const double &r_min, const double &) const
+{
+	// eigenvalues 1/q and c/q^3 <= 1/q
+	return 1.0 / sqrt(_shape_parameter + r_min*r_min);
+}
+
+double MQ::third_derivative_bound(const double &, const double &) const
+{
+	// 12|f''|r + 8|f'''|r^3 = 3r/q^3 + 3r^3/q^5 <= 6r/q^3, largest at r^2 = c/2
+	if (_shape_parameter <= 0.0) return std::numeric_limits<double>::infinity();
+	return 6.0*sqrt(0.5) / (pow(1.5, 1.5)*_shape_parameter);
+}
+
 double MQ3::basis()
 {
 	_p1->set_c(_c);
@@ -1165,6 +1243,43 @@ double TPS::dzz()
 	else return 0;
 }
 
+bool TPS::radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi) const
+{
+	for (int j = 0; j < n; j++ )
+	{
+		double s = r2[j];
+		if (s != 0)
+		{
+			double log_r = 0.5*log(s);
+			phi[j] = s*s*log_r;
+			dphi[j] = s + 4.0*s*log_r;
+			if (ddphi != NULL) ddphi[j] = 6.0 + 8.0*log_r;
+		}
+		else
+		{
+			phi[j] = 0.0;
+			dphi[j] = 0.0;
+			if (ddphi != NULL) ddphi[j] = 0.0;
+		}
+	}
+	return true;
+}
+
+double TPS::hessian_bound(const double &, const double &r_max) const
+{
+	// eigenvalues r^2*(1 + 4log(r)) and r^2*(7 + 12log(r)), within r^2*(7 + 12|log(r)|) which increases with r
+	if (r_max == 0) return 0.0;
+	return r_max*r_max*(7.0 + 12.0*fabs(log(r_max)));
+}
+
+double TPS::third_derivative_bound(const double &, const double &r_max) const
+{
+	// f = s^2*log(s)/2: 12|f''|r + 8|f'''|r^3 = 12r|2log(r) + 1.5| + 8r <= 24r|log(r)| + 26r, r|log(r)| largest at r = 1/e below 1
+	if (r_max == 0) return 0.0;
+	double r_log_r = (r_max <= exp(-1.0)) ? -r_max*log(r_max) : std::max(exp(-1.0), r_max*log(r_max));
+	return 24.0*r_log_r + 26.0*r_max;
+}
+
 double ATPS::basis()
 {
 	scaled_radius();
@@ -1445,6 +1560,32 @@ double IMQ::dzz()
 	return (-3.0*_z_delta*_z_delta / pow(_shape_parameter + _radius*_radius, 2.5)) + 1.0 / pow(_shape_parameter + _radius*_radius, 1.5);
 }
 
+bool IMQ::radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi) const
+{
+	for (int j = 0; j < n; j++ )
+	{
+		double q = 1.0 / sqrt(_shape_parameter + r2[j]);
+		phi[j] = q;
+		dphi[j] = -q*q*q;
+		if (ddphi != NULL) ddphi[j] = 3.0*q*q*q*q*q;
+	}
+	return true;
+}
+
+double IMQ::hessian_bound(const double &r_min, const double &) const
+{
+	// eigenvalues -q^3 and q^3*(3q^2r^2 - 1), q^2r^2 < 1
+	double q = 1.0 / sqrt(_shape_parameter + r_min*r_min);
+	return 2.0*q*q*q;
+}
+
+double IMQ::third_derivative_bound(const double &, const double &) const
+{
+	// 12|f''|r + 8|f'''|r^3 = 9r/q^5 + 15r^3/q^7 <= 24r/q^5, largest at r^2 = c/4
+	if (_shape_parameter <= 0.0) return std::numeric_limits<double>::infinity();
+	return 24.0*0.5 / (pow(1.25, 2.5)*_shape_parameter*_shape_parameter);
+}
+
 double AIMQ::basis()
 {
 	scaled_radius();
@@ -1744,6 +1885,12 @@ double AR::dzz()
 	return 0;
 }
 
+void Lagrangian_Polynomial_Basis::_add_unisolvent_point(const std::vector < Interface > &interface_points, const int &k)
+{
+	unisolvent_subset_points.push_back(interface_points[k]);
+	unisolvent_subset_indices.push_back(k);
+}
+
 bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std::vector < Interface > > &interface_point_lists)
 {
 	// NOTE : Currently only supporting 1st order polynomials ( have p(x) = A*x + B*y + C*z + D )
@@ -1762,6 +1909,7 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 		if ((int)interface_point_lists[j].size() >(int)interface_point_lists[index].size()) index = j;
 	}
 	if ((int)interface_point_lists[index].size() < 4) return false; // not enough points to create the 1st order Lagrangian Polynomial Basis
+	unisolvent_subset_list = index;
 
 	int n = (int)interface_point_lists[index].size();
 
@@ -1801,21 +1949,21 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 	// Find the axis that has the largest sampling
 	if (dx >= dy && dx >= dz)
 	{
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[0]]);
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[n - 1]]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[0]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[n - 1]);
 		if (dy >= dz)
 		{
 			for (int j = 0; j < n; j++) {
 				if (Index_Ycoord_array[j] != Index_Xcoord_array[0] && Index_Ycoord_array[j] != Index_Xcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Ycoord_array[n - 1 - j] != Index_Xcoord_array[0] && Index_Ycoord_array[n - 1 - j] != Index_Xcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1825,14 +1973,14 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 			for (int j = 0; j < n; j++) {
 				if (Index_Zcoord_array[j] != Index_Xcoord_array[0] && Index_Zcoord_array[j] != Index_Xcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Zcoord_array[n - 1 - j] != Index_Xcoord_array[0] && Index_Zcoord_array[n - 1 - j] != Index_Xcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1841,21 +1989,21 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 
 	if (dy >= dx && dy >= dz)
 	{
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[0]]);
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[n - 1]]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[0]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[n - 1]);
 		if (dx >= dz)
 		{
 			for (int j = 0; j < n; j++) {
 				if (Index_Xcoord_array[j] != Index_Ycoord_array[0] && Index_Xcoord_array[j] != Index_Ycoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Xcoord_array[n - 1 - j] != Index_Ycoord_array[0] && Index_Xcoord_array[n - 1 - j] != Index_Ycoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1865,14 +2013,14 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 			for (int j = 0; j < n; j++) {
 				if (Index_Zcoord_array[j] != Index_Ycoord_array[0] && Index_Zcoord_array[j] != Index_Ycoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Zcoord_array[n - 1 - j] != Index_Ycoord_array[0] && Index_Zcoord_array[n - 1 - j] != Index_Ycoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1881,21 +2029,21 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 
 	if (dz >= dx && dz >= dy)
 	{
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[0]]);
-		unisolvent_subset_points.push_back(interface_point_lists[index][Index_Zcoord_array[n - 1]]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[0]);
+		_add_unisolvent_point(interface_point_lists[index], Index_Zcoord_array[n - 1]);
 		if (dx >= dy)
 		{
 			for (int j = 0; j < n; j++) {
 				if (Index_Xcoord_array[j] != Index_Zcoord_array[0] && Index_Xcoord_array[j] != Index_Zcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Xcoord_array[n - 1 - j] != Index_Zcoord_array[0] && Index_Xcoord_array[n - 1 - j] != Index_Zcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Xcoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Xcoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1905,14 +2053,14 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 			for (int j = 0; j < n; j++) {
 				if (Index_Ycoord_array[j] != Index_Zcoord_array[0] && Index_Ycoord_array[j] != Index_Zcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[j]);
 					break;
 				}
 			}
 			for (int j = 0; j < n; j++) {
 				if (Index_Ycoord_array[n - 1 - j] != Index_Zcoord_array[0] && Index_Ycoord_array[n - 1 - j] != Index_Zcoord_array[n - 1])
 				{
-					unisolvent_subset_points.push_back(interface_point_lists[index][Index_Ycoord_array[n - 1 - j]]);
+					_add_unisolvent_point(interface_point_lists[index], Index_Ycoord_array[n - 1 - j]);
 					break;
 				}
 			}
@@ -1943,7 +2091,8 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 				if (interface_point_lists[index][j].x() != unisolvent_subset_points[0].x())
 				{
 					unisolvent_subset_points.pop_back();
-					unisolvent_subset_points.push_back(interface_point_lists[index][j]);
+					unisolvent_subset_indices.pop_back();
+					_add_unisolvent_point(interface_point_lists[index], j);
 					found_unique_point = true;
 					break;
 				}
@@ -1955,7 +2104,8 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 				if (interface_point_lists[index][j].y() != unisolvent_subset_points[0].y())
 				{
 					unisolvent_subset_points.pop_back();
-					unisolvent_subset_points.push_back(interface_point_lists[index][j]);
+					unisolvent_subset_indices.pop_back();
+					_add_unisolvent_point(interface_point_lists[index], j);
 					found_unique_point = true;
 					break;
 				}
@@ -1967,7 +2117,8 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 				if (interface_point_lists[index][j].z() != unisolvent_subset_points[0].z())
 				{
 					unisolvent_subset_points.pop_back();
-					unisolvent_subset_points.push_back(interface_point_lists[index][j]);
+					unisolvent_subset_indices.pop_back();
+					_add_unisolvent_point(interface_point_lists[index], j);
 					found_unique_point = true;
 					break;
 				}
@@ -1975,6 +2126,7 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 		}
 		if (!found_unique_point)
 		{
+			unisolvent_subset_indices[0] = -1; // moved off its interface point
 			if (add_x == (Q - 1)) unisolvent_subset_points[0].set_x(unisolvent_subset_points[0].x() + 0.0001);
 			if (add_y == (Q - 1)) unisolvent_subset_points[0].set_y(unisolvent_subset_points[0].y() + 0.0001);
 			if (add_z == (Q - 1)) unisolvent_subset_points[0].set_z(unisolvent_subset_points[0].z() + 0.0001);
@@ -1987,23 +2139,23 @@ bool Lagrangian_Polynomial_Basis::_get_unisolvent_subset(const std::vector < std
 
 void Lagrangian_Polynomial_Basis::_initialize_basis()
 {
-	mpf_class x1 = unisolvent_subset_points[0].x();
-	mpf_class y1 = unisolvent_subset_points[0].y();
-	mpf_class z1 = unisolvent_subset_points[0].z();
+	extended_float x1 = unisolvent_subset_points[0].x();
+	extended_float y1 = unisolvent_subset_points[0].y();
+	extended_float z1 = unisolvent_subset_points[0].z();
 
-	mpf_class x2 = unisolvent_subset_points[1].x();
-	mpf_class y2 = unisolvent_subset_points[1].y();
-	mpf_class z2 = unisolvent_subset_points[1].z();
+	extended_float x2 = unisolvent_subset_points[1].x();
+	extended_float y2 = unisolvent_subset_points[1].y();
+	extended_float z2 = unisolvent_subset_points[1].z();
 
-	mpf_class x3 = unisolvent_subset_points[2].x();
-	mpf_class y3 = unisolvent_subset_points[2].y();
-	mpf_class z3 = unisolvent_subset_points[2].z();
+	extended_float x3 = unisolvent_subset_points[2].x();
+	extended_float y3 = unisolvent_subset_points[2].y();
+	extended_float z3 = unisolvent_subset_points[2].z();
 
-	mpf_class x4 = unisolvent_subset_points[3].x();
-	mpf_class y4 = unisolvent_subset_points[3].y();
-	mpf_class z4 = unisolvent_subset_points[3].z();
+	extended_float x4 = unisolvent_subset_points[3].x();
+	extended_float y4 = unisolvent_subset_points[3].y();
+	extended_float z4 = unisolvent_subset_points[3].z();
 
-	mpf_class d = (x1*(y4*z2 - y3*z2 + y2*z3 - y4*z3 - y2*z4 + y3*z4) + 
+	extended_float d = (x1*(y4*z2 - y3*z2 + y2*z3 - y4*z3 - y2*z4 + y3*z4) + 
 		           x2*(y3*z1 - y4*z1 - y1*z3 + y4*z3 + y1*z4 - y3*z4) + 
 				   x3*(y4*z1 + y1*z2 - y4*z2 - y1*z4 - y2*z1 + y2*z4) +
 		           x4*(y2*z1 - y3*z1 - y1*z2 + y3*z2 + y1*z3 - y2*z3));
@@ -2055,9 +2207,9 @@ void Lagrangian_Polynomial_Basis::_initialize_basis()
 	_derivative_polynomial_constants(2,3) = _polynomial_constants[15]; // basis 4
 }
 
-Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly(const Point *p)
+Matrix <extended_float, Dynamic, 1> Lagrangian_Polynomial_Basis::poly(const Point *p)
 {
-	Matrix <mpf_class, Dynamic, 1> basis;
+	Matrix <extended_float, Dynamic, 1> basis;
 	basis.resize(4);
 
 	basis(0) = _polynomial_constants(0)  + _polynomial_constants(1)*p->x()  + _polynomial_constants(2)*p->y()  + _polynomial_constants(3)*p->z();
@@ -2068,9 +2220,9 @@ Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly(const Point *p)
 	return basis;
 }
 
-Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dx( const Point *p )
+Matrix <extended_float, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dx( const Point *p )
 {
-	Matrix <mpf_class, Dynamic, 1> basis;
+	Matrix <extended_float, Dynamic, 1> basis;
 	basis.resize(4);
 
 	basis(0) = _derivative_polynomial_constants(0,0);
@@ -2081,9 +2233,9 @@ Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dx( const Point
 	return basis;
 }
 
-Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dy( const Point *p )
+Matrix <extended_float, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dy( const Point *p )
 {
-	Matrix <mpf_class, Dynamic, 1> basis;
+	Matrix <extended_float, Dynamic, 1> basis;
 	basis.resize(4);
 
 	basis(0) = _derivative_polynomial_constants(1,0);
@@ -2094,9 +2246,9 @@ Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dy( const Point
 	return basis;
 }
 
-Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dz( const Point *p )
+Matrix <extended_float, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dz( const Point *p )
 {
-	Matrix <mpf_class, Dynamic, 1> basis;
+	Matrix <extended_float, Dynamic, 1> basis;
 	basis.resize(4);
 
 	basis(0) = _derivative_polynomial_constants(2,0);
@@ -2109,16 +2261,16 @@ Matrix <mpf_class, Dynamic, 1> Lagrangian_Polynomial_Basis::poly_dz( const Point
 
 double Modified_Kernel::basis_pt_pt()
 {
-	mpf_class t1,t2,t3,t4;
+	extended_float t1,t2,t3,t4;
 
-	Matrix <mpf_class, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
 	
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1(this->_aRBFKernel->basis());
+		extended_float b1(this->_aRBFKernel->basis());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2(this->_aRBFKernel->basis());
+		extended_float b2(this->_aRBFKernel->basis());
 		t1 += p1(j) * b1;
 		t2 += p2(j) * b2;
 		t3 += p1(j) * p2(j);
@@ -2126,28 +2278,28 @@ double Modified_Kernel::basis_pt_pt()
  			if (k != j)
  			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4 += p1(j) * p2(k) * b3;
 			}
 		}
 	}
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->basis() - t1 - t2 + t3 + t4;
+	extended_float sum = this->_aRBFKernel->basis() - t1 - t2 + t3 + t4;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_pt_planar_x()
 {
-	mpf_class t1x,t2x,t3x,t4x;
+	extended_float t1x,t2x,t3x,t4x;
 
-	Matrix <mpf_class, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1x(this->_aRBFKernel->dx_p2());
+		extended_float b1x(this->_aRBFKernel->dx_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2(this->_aRBFKernel->basis());
+		extended_float b2(this->_aRBFKernel->basis());
 		t1x += p1(j)*b1x;  
 		t2x += p2x(j)*b2;
 		t3x += p1(j)*p2x(j);
@@ -2155,29 +2307,29 @@ double Modified_Kernel::basis_pt_planar_x()
 			if ( k!=j )
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4x += p1(j) * p2x(k) * b3;
 			}
 		}
 	}
 
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dx_p2() - t1x - t2x + t3x + t4x;
+	extended_float sum = this->_aRBFKernel->dx_p2() - t1x - t2x + t3x + t4x;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_planar_x_pt()
 {
-	mpf_class t1x,t2x,t3x,t4x;
+	extended_float t1x,t2x,t3x,t4x;
 
-	Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1(this->_aRBFKernel->basis());
+		extended_float b1(this->_aRBFKernel->basis());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2x(this->_aRBFKernel->dx_p1());
+		extended_float b2x(this->_aRBFKernel->dx_p1());
 		t1x += p1x(j)*b1;  
 		t2x += p2(j)*b2x;
 		t3x += p1x(j)*p2(j);
@@ -2185,29 +2337,29 @@ double Modified_Kernel::basis_planar_x_pt()
 			if (k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4x += p1x(j) * p2(k) * b3;
 			}
 		}
 	}
 
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dx_p1() - t1x - t2x + t3x + t4x;
+	extended_float sum = this->_aRBFKernel->dx_p1() - t1x - t2x + t3x + t4x;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_pt_planar_y()
 {
-	mpf_class t1y,t2y,t3y,t4y;
+	extended_float t1y,t2y,t3y,t4y;
 
-	Matrix <mpf_class, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1y(this->_aRBFKernel->dy_p2());
+		extended_float b1y(this->_aRBFKernel->dy_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2(this->_aRBFKernel->basis());
+		extended_float b2(this->_aRBFKernel->basis());
 		t1y += p1(j)*b1y;  
 		t2y += p2y(j)*b2;
 		t3y += p1(j)*p2y(j);
@@ -2215,29 +2367,29 @@ double Modified_Kernel::basis_pt_planar_y()
 			if (k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4y += p1(j) * p2y(k) * b3;
 			}
 		}
 	}
 
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dy_p2() - t1y - t2y + t3y + t4y;
+	extended_float sum = this->_aRBFKernel->dy_p2() - t1y - t2y + t3y + t4y;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_planar_y_pt()
 {
-	mpf_class t1y,t2y,t3y,t4y;
+	extended_float t1y,t2y,t3y,t4y;
 
-	Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1(this->_aRBFKernel->basis());
+		extended_float b1(this->_aRBFKernel->basis());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2y(this->_aRBFKernel->dy_p1());
+		extended_float b2y(this->_aRBFKernel->dy_p1());
 		t1y += p1y(j)*b1;  
 		t2y += p2(j)*b2y;
 		t3y += p1y(j)*p2(j);
@@ -2245,29 +2397,29 @@ double Modified_Kernel::basis_planar_y_pt()
 			if (k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4y += p1y(j) * p2(k) * b3;
 			}
 		}
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dy_p1() - t1y - t2y + t3y + t4y;
+	extended_float sum = this->_aRBFKernel->dy_p1() - t1y - t2y + t3y + t4y;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_pt_planar_z()
 {
-	mpf_class t1z,t2z,t3z,t4z;
+	extended_float t1z,t2z,t3z,t4z;
 
-	Matrix <mpf_class, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1z(this->_aRBFKernel->dz_p2());
+		extended_float b1z(this->_aRBFKernel->dz_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2(this->_aRBFKernel->basis());
+		extended_float b2(this->_aRBFKernel->basis());
 		t1z += p1(j)*b1z;  
 		t2z += p2z(j)*b2;
 		t3z += p1(j)*p2z(j);
@@ -2275,29 +2427,29 @@ double Modified_Kernel::basis_pt_planar_z()
 			if ( k!= j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4z += p1(j) * p2z(k) * b3;
 			}
 		}
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dz_p2() - t1z - t2z + t3z + t4z;
+	extended_float sum = this->_aRBFKernel->dz_p2() - t1z - t2z + t3z + t4z;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_planar_z_pt()
 {
-	mpf_class t1z,t2z,t3z,t4z;
+	extended_float t1z,t2z,t3z,t4z;
 
-	Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
+	Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+	Matrix <extended_float, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1(this->_aRBFKernel->basis());
+		extended_float b1(this->_aRBFKernel->basis());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2z(this->_aRBFKernel->dz_p1());
+		extended_float b2z(this->_aRBFKernel->dz_p1());
 		t1z += p1z(j)*b1;  
 		t2z += p2(j)*b2z;
 		t3z += p1z(j)*p2(j);
@@ -2305,34 +2457,34 @@ double Modified_Kernel::basis_planar_z_pt()
 			if (k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4z += p1z(j) * p2(k) * b3;
 			}
 		}
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class sum = this->_aRBFKernel->dz_p1() - t1z - t2z + t3z + t4z;
+	extended_float sum = this->_aRBFKernel->dz_p1() - t1z - t2z + t3z + t4z;
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_pt_tangent()
 {
-	mpf_class t1x,t2x,t3x,t4x,t1y,t2y,t3y,t4y,t1z,t2z,t3z,t4z;
+	extended_float t1x,t2x,t3x,t4x,t1y,t2y,t3y,t4y,t1z,t2z,t3z,t4z;
 
-	Matrix <mpf_class, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1 = this->_aLPB->poly(this->p1());
 
-	Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1x(this->_aRBFKernel->dx_p2());
-		mpf_class b1y(this->_aRBFKernel->dy_p2());
-		mpf_class b1z(this->_aRBFKernel->dz_p2());
+		extended_float b1x(this->_aRBFKernel->dx_p2());
+		extended_float b1y(this->_aRBFKernel->dy_p2());
+		extended_float b1z(this->_aRBFKernel->dz_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2(this->_aRBFKernel->basis());
+		extended_float b2(this->_aRBFKernel->basis());
 		// for dx component
 		t1x += p1(j) * b1x;  
 		t2x += p2x(j) * b2;
@@ -2357,7 +2509,7 @@ double Modified_Kernel::basis_pt_tangent()
 			if (k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4x += p1(j) * p2x(k) * b3;
 				t4y += p1(j) * p2y(k) * b3;
 				t4z += p1(j) * p2z(k) * b3;
@@ -2366,35 +2518,35 @@ double Modified_Kernel::basis_pt_tangent()
 	}
 
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class dx = this->_aRBFKernel->dx_p2() - t1x - t2x + t3x + t4x;
-	mpf_class dy = this->_aRBFKernel->dy_p2() - t1y - t2y + t3y + t4y;
-	mpf_class dz = this->_aRBFKernel->dz_p2() - t1z - t2z + t3z + t4z;
+	extended_float dx = this->_aRBFKernel->dx_p2() - t1x - t2x + t3x + t4x;
+	extended_float dy = this->_aRBFKernel->dy_p2() - t1y - t2y + t3y + t4y;
+	extended_float dz = this->_aRBFKernel->dz_p2() - t1z - t2z + t3z + t4z;
 
 	// It is your responsibility to supply the right type
 	// It is not worth the cost of dynamic_cast + if
 	Tangent *t = static_cast<Tangent*>(this->p2());
-	mpf_class sum = dx * t->tx() + dy * t->ty() + dz * t->tz();
+	extended_float sum = dx * t->tx() + dy * t->ty() + dz * t->tz();
 
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_tangent_pt()
 {
-	mpf_class t1x,t2x,t3x,t4x,t1y,t2y,t3y,t4y,t1z,t2z,t3z,t4z;
+	extended_float t1x,t2x,t3x,t4x,t1y,t2y,t3y,t4y,t1z,t2z,t3z,t4z;
 
-	Matrix <mpf_class, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2 = this->_aLPB->poly(this->p2());
 
-	Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1(this->_aRBFKernel->basis());
+		extended_float b1(this->_aRBFKernel->basis());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2x(this->_aRBFKernel->dx_p1());
-		mpf_class b2y(this->_aRBFKernel->dy_p1());
-		mpf_class b2z(this->_aRBFKernel->dz_p1());
+		extended_float b2x(this->_aRBFKernel->dx_p1());
+		extended_float b2y(this->_aRBFKernel->dy_p1());
+		extended_float b2z(this->_aRBFKernel->dz_p1());
 		// for dx component
 		t1x += p1x(j) * b1;  
 		t2x += p2(j) * b2x;
@@ -2411,7 +2563,7 @@ double Modified_Kernel::basis_tangent_pt()
 			if ( k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4x += p1x(j) * p2(k) * b3;
 				t4y += p1y(j) * p2(k) * b3;
 				t4z += p1z(j) * p2(k) * b3;
@@ -2420,39 +2572,39 @@ double Modified_Kernel::basis_tangent_pt()
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class dx = this->_aRBFKernel->dx_p1() - t1x - t2x + t3x + t4x;
-	mpf_class dy = this->_aRBFKernel->dy_p1() - t1y - t2y + t3y + t4y;
-	mpf_class dz = this->_aRBFKernel->dz_p1() - t1z - t2z + t3z + t4z;
+	extended_float dx = this->_aRBFKernel->dx_p1() - t1x - t2x + t3x + t4x;
+	extended_float dy = this->_aRBFKernel->dy_p1() - t1y - t2y + t3y + t4y;
+	extended_float dz = this->_aRBFKernel->dz_p1() - t1z - t2z + t3z + t4z;
 
 	// It is your responsibility to supply the right type
 	// It is not worth the cost of dynamic_cast + if
 	Tangent *t = static_cast<Tangent*>(this->p1());
-	mpf_class sum = dx * t->tx() + dy * t->ty() + dz * t->tz();
+	extended_float sum = dx * t->tx() + dy * t->ty() + dz * t->tz();
 
 	return sum.get_d();
 }
 
 double Modified_Kernel::basis_planar_planar( const Parameter_Types::SecondDerivatives& sd )
 {
-	mpf_class t1,t2,t3,t4;
+	extended_float t1,t2,t3,t4;
 
-	Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
 
-	Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1x(this->_aRBFKernel->dx_p2());
-		mpf_class b1y(this->_aRBFKernel->dy_p2());
-		mpf_class b1z(this->_aRBFKernel->dz_p2());
+		extended_float b1x(this->_aRBFKernel->dx_p2());
+		extended_float b1y(this->_aRBFKernel->dy_p2());
+		extended_float b1z(this->_aRBFKernel->dz_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2x(this->_aRBFKernel->dx_p1());
-		mpf_class b2y(this->_aRBFKernel->dy_p1());
-		mpf_class b2z(this->_aRBFKernel->dz_p1());
+		extended_float b2x(this->_aRBFKernel->dx_p1());
+		extended_float b2y(this->_aRBFKernel->dy_p1());
+		extended_float b2z(this->_aRBFKernel->dz_p1());
 		if ( sd == Parameter_Types::DXDX)
 		{
 			t1 += p1x(j) * b1x;  
@@ -2511,7 +2663,7 @@ double Modified_Kernel::basis_planar_planar( const Parameter_Types::SecondDeriva
 			if ( k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				if ( sd == Parameter_Types::DXDX ) t4 += p2x(k) * b3 * p1x(j);
 				if ( sd == Parameter_Types::DYDY ) t4 += p2y(k) * b3 * p1y(j);
 				if ( sd == Parameter_Types::DZDZ ) t4 += p2z(k) * b3 * p1z(j);
@@ -2526,7 +2678,7 @@ double Modified_Kernel::basis_planar_planar( const Parameter_Types::SecondDeriva
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class base;
+	extended_float base;
 	if ( sd == Parameter_Types::DXDX ) base = this->_aRBFKernel->dxx();
 	if ( sd == Parameter_Types::DYDY ) base = this->_aRBFKernel->dyy();
 	if ( sd == Parameter_Types::DZDZ ) base = this->_aRBFKernel->dzz();
@@ -2537,40 +2689,40 @@ double Modified_Kernel::basis_planar_planar( const Parameter_Types::SecondDeriva
 	if ( sd == Parameter_Types::DZDX ) base = this->_aRBFKernel->dzx();
 	if ( sd == Parameter_Types::DZDY ) base = this->_aRBFKernel->dzy();
 
-	mpf_class sum = base - t1 - t2 + t3 + t4;
+	extended_float sum = base - t1 - t2 + t3 + t4;
 	return sum.get_d();
 
 }
 
 double Modified_Kernel::basis_tangent_tangent()
 {
-	Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-	Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+	Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
 
-	Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-	Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+	Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
-	mpf_class t1xx,t2xx,t3xx,t4xx;
-	mpf_class t1yy,t2yy,t3yy,t4yy;
-	mpf_class t1zz,t2zz,t3zz,t4zz;
-	mpf_class t1xy,t2xy,t3xy,t4xy;
-	mpf_class t1xz,t2xz,t3xz,t4xz;
-	mpf_class t1yz,t2yz,t3yz,t4yz;
-	mpf_class t1yx,t2yx,t3yx,t4yx;
-	mpf_class t1zx,t2zx,t3zx,t4zx;
-	mpf_class t1zy,t2zy,t3zy,t4zy;
+	extended_float t1xx,t2xx,t3xx,t4xx;
+	extended_float t1yy,t2yy,t3yy,t4yy;
+	extended_float t1zz,t2zz,t3zz,t4zz;
+	extended_float t1xy,t2xy,t3xy,t4xy;
+	extended_float t1xz,t2xz,t3xz,t4xz;
+	extended_float t1yz,t2yz,t3yz,t4yz;
+	extended_float t1yx,t2yx,t3yx,t4yx;
+	extended_float t1zx,t2zx,t3zx,t4zx;
+	extended_float t1zy,t2zy,t3zy,t4zy;
 
 	for (int j = 0; j < 4; j++){
 		this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-		mpf_class b1x(this->_aRBFKernel->dx_p2());
-		mpf_class b1y(this->_aRBFKernel->dy_p2());
-		mpf_class b1z(this->_aRBFKernel->dz_p2());
+		extended_float b1x(this->_aRBFKernel->dx_p2());
+		extended_float b1y(this->_aRBFKernel->dy_p2());
+		extended_float b1z(this->_aRBFKernel->dz_p2());
 		this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-		mpf_class b2x(this->_aRBFKernel->dx_p1());
-		mpf_class b2y(this->_aRBFKernel->dy_p1());
-		mpf_class b2z(this->_aRBFKernel->dz_p1());
+		extended_float b2x(this->_aRBFKernel->dx_p1());
+		extended_float b2y(this->_aRBFKernel->dy_p1());
+		extended_float b2z(this->_aRBFKernel->dz_p1());
 		// dxx
 		t1xx += p1x(j) * b1x;  
 		t2xx += p2x(j) * b2x;
@@ -2611,7 +2763,7 @@ double Modified_Kernel::basis_tangent_tangent()
 			if ( k != j)
 			{
 				this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-				mpf_class b3(this->_aRBFKernel->basis());
+				extended_float b3(this->_aRBFKernel->basis());
 				t4xx += p2x(k) * b3 * p1x(j);
 				t4yy += p2y(k) * b3 * p1y(j);
 				t4zz += p2z(k) * b3 * p1z(j);
@@ -2626,20 +2778,20 @@ double Modified_Kernel::basis_tangent_tangent()
 	}
 	
 	this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-	mpf_class xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
-	mpf_class yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
-	mpf_class zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
-	mpf_class xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
-	mpf_class xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
-	mpf_class yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
-	mpf_class yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
-	mpf_class zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
-	mpf_class zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
+	extended_float xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
+	extended_float yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
+	extended_float zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
+	extended_float xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
+	extended_float xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
+	extended_float yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
+	extended_float yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
+	extended_float zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
+	extended_float zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
 
 	Tangent *t1 = static_cast<Tangent*>(this->p1());
 	Tangent *t2 = static_cast<Tangent*>(this->p2());
 
-	mpf_class value = t1->tx()*t2->tx()*xx + t1->tx()*t2->ty()*xy + t1->tx()*t2->tz()*xz + 
+	extended_float value = t1->tx()*t2->tx()*xx + t1->tx()*t2->ty()*xy + t1->tx()*t2->tz()*xz + 
 					  t1->ty()*t2->tx()*yx + t1->ty()*t2->ty()*yy + t1->ty()*t2->tz()*yz + 
 					  t1->tz()*t2->tx()*zx + t1->tz()*t2->ty()*zy + t1->tz()*t2->tz()*zz;
 
@@ -2650,22 +2802,22 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 {
 	if (fd == Parameter_Types::DX)
 	{
-		Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
-		mpf_class t1xx,t2xx,t3xx,t4xx;
-		mpf_class t1xy,t2xy,t3xy,t4xy;
-		mpf_class t1xz,t2xz,t3xz,t4xz;
+		extended_float t1xx,t2xx,t3xx,t4xx;
+		extended_float t1xy,t2xy,t3xy,t4xy;
+		extended_float t1xz,t2xz,t3xz,t4xz;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1x(this->_aRBFKernel->dx_p2());
-			mpf_class b1y(this->_aRBFKernel->dy_p2());
-			mpf_class b1z(this->_aRBFKernel->dz_p2());
+			extended_float b1x(this->_aRBFKernel->dx_p2());
+			extended_float b1y(this->_aRBFKernel->dy_p2());
+			extended_float b1z(this->_aRBFKernel->dz_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2x(this->_aRBFKernel->dx_p1());
+			extended_float b2x(this->_aRBFKernel->dx_p1());
 			// dxx
 			t1xx += p1x(j) * b1x;  
 			t2xx += p2x(j) * b2x;
@@ -2682,7 +2834,7 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4xx += p2x(k) * b3 * p1x(j);
 					t4xy += p2y(k) * b3 * p1x(j);
 					t4xz += p2z(k) * b3 * p1x(j);
@@ -2691,34 +2843,34 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
-		mpf_class xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
-		mpf_class xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
+		extended_float xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
+		extended_float xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
+		extended_float xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
 
 		Tangent *t = static_cast<Tangent*>(this->p2());
 
-		mpf_class value = t->tx()*xx + t->ty()*xy + t->tz()*xz;
+		extended_float value = t->tx()*xx + t->ty()*xy + t->tz()*xz;
 
 		return value.get_d();
 	}
 	else if (fd == Parameter_Types::DY)
 	{
-		Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
-		mpf_class t1yy,t2yy,t3yy,t4yy;
-		mpf_class t1yz,t2yz,t3yz,t4yz;
-		mpf_class t1yx,t2yx,t3yx,t4yx;
+		extended_float t1yy,t2yy,t3yy,t4yy;
+		extended_float t1yz,t2yz,t3yz,t4yz;
+		extended_float t1yx,t2yx,t3yx,t4yx;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1x(this->_aRBFKernel->dx_p2());
-			mpf_class b1y(this->_aRBFKernel->dy_p2());
-			mpf_class b1z(this->_aRBFKernel->dz_p2());
+			extended_float b1x(this->_aRBFKernel->dx_p2());
+			extended_float b1y(this->_aRBFKernel->dy_p2());
+			extended_float b1z(this->_aRBFKernel->dz_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2y(this->_aRBFKernel->dy_p1());
+			extended_float b2y(this->_aRBFKernel->dy_p1());
 			// dyy
 			t1yy += p1y(j) * b1y;  
 			t2yy += p2y(j) * b2y;
@@ -2735,7 +2887,7 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4yy += p2y(k) * b3 * p1y(j);
 					t4yz += p2z(k) * b3 * p1y(j);
 					t4yx += p2x(k) * b3 * p1y(j);
@@ -2744,34 +2896,34 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
-		mpf_class yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
-		mpf_class yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
+		extended_float yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
+		extended_float yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
+		extended_float yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
 
 		Tangent *t = static_cast<Tangent*>(this->p2());
 
-		mpf_class value = t->tx()*yx + t->ty()*yy + t->tz()*yz;
+		extended_float value = t->tx()*yx + t->ty()*yy + t->tz()*yz;
 
 		return value.get_d();
 	}
 	else // fd == DZ
 	{
-		Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
-		Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+		Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
-		mpf_class t1zz,t2zz,t3zz,t4zz;
-		mpf_class t1zx,t2zx,t3zx,t4zx;
-		mpf_class t1zy,t2zy,t3zy,t4zy;
+		extended_float t1zz,t2zz,t3zz,t4zz;
+		extended_float t1zx,t2zx,t3zx,t4zx;
+		extended_float t1zy,t2zy,t3zy,t4zy;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1x(this->_aRBFKernel->dx_p2());
-			mpf_class b1y(this->_aRBFKernel->dy_p2());
-			mpf_class b1z(this->_aRBFKernel->dz_p2());
+			extended_float b1x(this->_aRBFKernel->dx_p2());
+			extended_float b1y(this->_aRBFKernel->dy_p2());
+			extended_float b1z(this->_aRBFKernel->dz_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2z(this->_aRBFKernel->dz_p1());
+			extended_float b2z(this->_aRBFKernel->dz_p1());
 			// dzz
 			t1zz += p1z(j) * b1z;  
 			t2zz += p2z(j) * b2z;
@@ -2788,7 +2940,7 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4zz += p2z(k) * b3 * p1z(j);
 					t4zx += p2x(k) * b3 * p1z(j);
 					t4zy += p2y(k) * b3 * p1z(j);
@@ -2797,13 +2949,13 @@ double Modified_Kernel::basis_planar_tangent( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
-		mpf_class zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
-		mpf_class zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
+		extended_float zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
+		extended_float zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
+		extended_float zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
 
 		Tangent *t = static_cast<Tangent*>(this->p2());
 
-		mpf_class value = t->tx()*zx + t->ty()*zy + t->tz()*zz;
+		extended_float value = t->tx()*zx + t->ty()*zy + t->tz()*zz;
 
 		return value.get_d();
 	}
@@ -2814,22 +2966,22 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 	if (fd == Parameter_Types::DX)
 	{
 
-		Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2x = this->_aLPB->poly_dx(this->p2());
 
-		mpf_class t1xx,t2xx,t3xx,t4xx;
-		mpf_class t1yx,t2yx,t3yx,t4yx;
-		mpf_class t1zx,t2zx,t3zx,t4zx;
+		extended_float t1xx,t2xx,t3xx,t4xx;
+		extended_float t1yx,t2yx,t3yx,t4yx;
+		extended_float t1zx,t2zx,t3zx,t4zx;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1x(this->_aRBFKernel->dx_p2());
+			extended_float b1x(this->_aRBFKernel->dx_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2x(this->_aRBFKernel->dx_p1());
-			mpf_class b2y(this->_aRBFKernel->dy_p1());
-			mpf_class b2z(this->_aRBFKernel->dz_p1());
+			extended_float b2x(this->_aRBFKernel->dx_p1());
+			extended_float b2y(this->_aRBFKernel->dy_p1());
+			extended_float b2z(this->_aRBFKernel->dz_p1());
 			// dxx
 			t1xx += p1x(j) * b1x;  
 			t2xx += p2x(j) * b2x;
@@ -2846,7 +2998,7 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4xx += p2x(k) * b3 * p1x(j);
 					t4yx += p2x(k) * b3 * p1y(j);
 					t4zx += p2x(k) * b3 * p1z(j);
@@ -2855,34 +3007,34 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
-		mpf_class yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
-		mpf_class zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
+		extended_float xx = this->_aRBFKernel->dxx() - t1xx - t2xx + t3xx + t4xx;
+		extended_float yx = this->_aRBFKernel->dyx() - t1yx - t2yx + t3yx + t4yx;
+		extended_float zx = this->_aRBFKernel->dzx() - t1zx - t2zx + t3zx + t4zx;
 
 		Tangent *t = static_cast<Tangent*>(this->p1());
 
-		mpf_class value = t->tx()*xx + t->ty()*yx + t->tz()*zx;
+		extended_float value = t->tx()*xx + t->ty()*yx + t->tz()*zx;
 
 		return value.get_d();
 	}
 	else if (fd == Parameter_Types::DY)
 	{
-		Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2y = this->_aLPB->poly_dy(this->p2());
 
-		mpf_class t1yy,t2yy,t3yy,t4yy;
-		mpf_class t1zy,t2zy,t3zy,t4zy;
-		mpf_class t1xy,t2xy,t3xy,t4xy;
+		extended_float t1yy,t2yy,t3yy,t4yy;
+		extended_float t1zy,t2zy,t3zy,t4zy;
+		extended_float t1xy,t2xy,t3xy,t4xy;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1y(this->_aRBFKernel->dy_p2());
+			extended_float b1y(this->_aRBFKernel->dy_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2x(this->_aRBFKernel->dx_p1());
-			mpf_class b2y(this->_aRBFKernel->dy_p1());
-			mpf_class b2z(this->_aRBFKernel->dz_p1());
+			extended_float b2x(this->_aRBFKernel->dx_p1());
+			extended_float b2y(this->_aRBFKernel->dy_p1());
+			extended_float b2z(this->_aRBFKernel->dz_p1());
 			// dyy
 			t1yy += p1y(j) * b1y;  
 			t2yy += p2y(j) * b2y;
@@ -2899,7 +3051,7 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4yy += p2y(k) * b3 * p1y(j);
 					t4xy += p2y(k) * b3 * p1x(j);
 					t4zy += p2y(k) * b3 * p1z(j);
@@ -2908,34 +3060,34 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
-		mpf_class zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
-		mpf_class xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
+		extended_float yy = this->_aRBFKernel->dyy() - t1yy - t2yy + t3yy + t4yy;
+		extended_float zy = this->_aRBFKernel->dzy() - t1zy - t2zy + t3zy + t4zy;
+		extended_float xy = this->_aRBFKernel->dxy() - t1xy - t2xy + t3xy + t4xy;
 
 		Tangent *t = static_cast<Tangent*>(this->p1());
 
-		mpf_class value = t->tx()*xy + t->ty()*yy + t->tz()*zy;
+		extended_float value = t->tx()*xy + t->ty()*yy + t->tz()*zy;
 
 		return value.get_d();
 	}
 	else // fd == DZ
 	{
-		Matrix <mpf_class, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
-		Matrix <mpf_class, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
+		Matrix <extended_float, Dynamic, 1> p1x = this->_aLPB->poly_dx(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1y = this->_aLPB->poly_dy(this->p1());
+		Matrix <extended_float, Dynamic, 1> p1z = this->_aLPB->poly_dz(this->p1());
+		Matrix <extended_float, Dynamic, 1> p2z = this->_aLPB->poly_dz(this->p2());
 
-		mpf_class t1zz,t2zz,t3zz,t4zz;
-		mpf_class t1xz,t2xz,t3xz,t4xz;
-		mpf_class t1yz,t2yz,t3yz,t4yz;
+		extended_float t1zz,t2zz,t3zz,t4zz;
+		extended_float t1xz,t2xz,t3xz,t4xz;
+		extended_float t1yz,t2yz,t3yz,t4yz;
 
 		for (int j = 0; j < 4; j++){
 			this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],*this->p2());
-			mpf_class b1z(this->_aRBFKernel->dz_p2());
+			extended_float b1z(this->_aRBFKernel->dz_p2());
 			this->_aRBFKernel->set_points(*this->p1(),this->_aLPB->unisolvent_subset_points[j]);
-			mpf_class b2x(this->_aRBFKernel->dx_p1());
-			mpf_class b2y(this->_aRBFKernel->dy_p1());
-			mpf_class b2z(this->_aRBFKernel->dz_p1());
+			extended_float b2x(this->_aRBFKernel->dx_p1());
+			extended_float b2y(this->_aRBFKernel->dy_p1());
+			extended_float b2z(this->_aRBFKernel->dz_p1());
 			// dzz
 			t1zz += p1z(j) * b1z;  
 			t2zz += p2z(j) * b2z;
@@ -2952,7 +3104,7 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 				if ( k != j)
 				{
 					this->_aRBFKernel->set_points(this->_aLPB->unisolvent_subset_points[j],this->_aLPB->unisolvent_subset_points[k]);
-					mpf_class b3(this->_aRBFKernel->basis());
+					extended_float b3(this->_aRBFKernel->basis());
 					t4zz += p2z(k) * b3 * p1z(j);
 					t4xz += p2z(k) * b3 * p1x(j);
 					t4yz += p2z(k) * b3 * p1y(j);
@@ -2961,13 +3113,13 @@ double Modified_Kernel::basis_tangent_planar( const Parameter_Types::FirstDeriva
 		}
 		
 		this->_aRBFKernel->set_points(*this->_p1,*this->_p2);
-		mpf_class zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
-		mpf_class xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
-		mpf_class yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
+		extended_float zz = this->_aRBFKernel->dzz() - t1zz - t2zz + t3zz + t4zz;
+		extended_float xz = this->_aRBFKernel->dxz() - t1xz - t2xz + t3xz + t4xz;
+		extended_float yz = this->_aRBFKernel->dyz() - t1yz - t2yz + t3yz + t4yz;
 
 		Tangent *t = static_cast<Tangent*>(this->p1());
 
-		mpf_class value = t->tx()*xz + t->ty()*yz + t->tz()*zz;
+		extended_float value = t->tx()*xz + t->ty()*yz + t->tz()*zz;
 
 		return value.get_d();
 	}
@@ -3248,3 +3400,34 @@ VectorXd Poly_Second::dz()
 		return v;
 	}
 }
+
+double Lagrange_Polynomial_Kernel::basis_pt_pt()
+{
+	extended_float p = this->_aLPB->poly(this->p2())(_j);
+	return p.get_d();
+}
+
+double Lagrange_Polynomial_Kernel::basis_pt_planar_x()
+{
+	extended_float px = this->_aLPB->poly_dx(this->p2())(_j);
+	return px.get_d();
+}
+
+double Lagrange_Polynomial_Kernel::basis_pt_planar_y()
+{
+	extended_float py = this->_aLPB->poly_dy(this->p2())(_j);
+	return py.get_d();
+}
+
+double Lagrange_Polynomial_Kernel::basis_pt_planar_z()
+{
+	extended_float pz = this->_aLPB->poly_dz(this->p2())(_j);
+	return pz.get_d();
+}
+
+double Lagrange_Polynomial_Kernel::basis_pt_tangent()
+{
+	// It is your responsibility to supply the right type
+	Tangent *t = static_cast<Tangent*>(this->p2());
+	return basis_pt_planar_x()*t->tx() + basis_pt_planar_y()*t->ty() + basis_pt_planar_z()*t->tz();
+}
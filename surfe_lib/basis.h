@@ -37,10 +37,12 @@
 
 #include <modelling_parameters.h>
 #include <modelling_input.h>
-#include <gmpxx.h>
+#include <math_methods.h>
 
 #include <Eigen/Core>
 
+#include <limits>
+
 using namespace Eigen;
 
 class Kernel{
@@ -120,6 +122,18 @@ public:
 	double basis_tangent_tangent();
 	double basis_planar_tangent( const Parameter_Types::FirstDerivatives& fd );
 	double basis_tangent_planar( const Parameter_Types::FirstDerivatives& fd );
+	// kernels with a shape parameter (Gaussian, MQ, IMQ) change it and return true
+	virtual bool set_shape_parameter(const double &) { return false; }
+	// isotropic kernels as functions of the squared distance r2 for n pairs at once: phi(r) and phi'(r)/r, so that
+	// the derivative w.r.t. p2's x-coordinate is -dphi*(x1 - x2), and if ddphi is not NULL dphi'(r)/r for second
+	// derivatives (0 where singular at r = 0, always times a vanishing factor). phi may alias r2. False if not supported (anisotropic)
+	virtual bool radial_profile(const int &, const double *, double *, double *, double * = NULL) const { return false; }
+	// bound on the second derivatives (spectral norm of the Hessian) of an isotropic kernel over the distances [r_min, r_max],
+	// infinity if not supported
+	virtual double hessian_bound(const double &, const double &) const { return std::numeric_limits<double>::infinity(); }
+	// bound on the third derivatives (norm of the trilinear form) of an isotropic kernel over the distances [r_min, r_max],
+	// which bounds the Hessian of a derivative center. Infinity if not supported
+	virtual double third_derivative_bound(const double &, const double &) const { return std::numeric_limits<double>::infinity(); }
 	virtual RBFKernel *clone() = 0;
 };
 
@@ -142,6 +156,9 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi = NULL) const;
+	double hessian_bound(const double &r_min, const double &r_max) const;
+	double third_derivative_bound(const double &r_min, const double &r_max) const;
 	virtual Cubic *clone() { return new Cubic(*this); }
 };
 
@@ -190,6 +207,10 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
+	bool radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi = NULL) const;
+	double hessian_bound(const double &r_min, const double &r_max) const;
+	double third_derivative_bound(const double &r_min, const double &r_max) const;
 	virtual Gaussian *clone() { return new Gaussian(*this); }
 };
 
@@ -215,6 +236,7 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
 	virtual AGaussian *clone() { return new AGaussian(*this); }
 };
 
@@ -240,6 +262,10 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
+	bool radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi = NULL) const;
+	double hessian_bound(const double &r_min, const double &r_max) const;
+	double third_derivative_bound(const double &r_min, const double &r_max) const;
 	virtual MQ *clone() { return new MQ(*this); }
 };
 
@@ -265,6 +291,7 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _c = shape_parameter; return true; }
 	virtual MQ3 *clone() { return new MQ3(*this); }
 };
 
@@ -290,6 +317,7 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
 	virtual AMQ *clone() { return new AMQ(*this); }
 };
 
@@ -312,6 +340,9 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi = NULL) const;
+	double hessian_bound(const double &r_min, const double &r_max) const;
+	double third_derivative_bound(const double &r_min, const double &r_max) const;
 	virtual TPS *clone() { return new TPS(*this); }
 };
 
@@ -360,6 +391,10 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
+	bool radial_profile(const int &n, const double *r2, double *phi, double *dphi, double *ddphi = NULL) const;
+	double hessian_bound(const double &r_min, const double &r_max) const;
+	double third_derivative_bound(const double &r_min, const double &r_max) const;
 	virtual IMQ *clone() { return new IMQ(*this); }
 };
 
@@ -385,6 +420,7 @@ public:
 	double dzx();
 	double dzy();
 	double dzz();
+	bool set_shape_parameter(const double &shape_parameter) { _shape_parameter = shape_parameter; return true; }
 	virtual AIMQ *clone() { return new AIMQ(*this); }
 };
 
@@ -439,6 +475,7 @@ protected:
 	bool _truncated;
 public:
 	Polynomial_Basis() : _truncated(false) { }
+	virtual ~Polynomial_Basis() {}
 	void set_point(Point& point) { _p = &point;}
 	virtual VectorXd basis() = 0;
 	virtual VectorXd dx() = 0;
@@ -479,32 +516,42 @@ public:
 
 class Lagrangian_Polynomial_Basis {
 private:
-	Matrix <mpf_class, Dynamic, 1> _polynomial_constants;
-	Matrix <mpf_class, Dynamic, Dynamic> _derivative_polynomial_constants;
+	Matrix <extended_float, Dynamic, 1> _polynomial_constants;
+	Matrix <extended_float, Dynamic, Dynamic> _derivative_polynomial_constants;
 	bool _get_unisolvent_subset(const std::vector < std::vector < Interface > > &interface_point_lists);
+	void _add_unisolvent_point(const std::vector < Interface > &interface_points, const int &k);
 	void _initialize_basis();
 public:
 	Lagrangian_Polynomial_Basis(const std::vector < std::vector < Interface > > &interface_point_lists)
 	{
+		unisolvent_subset_list = -1;
+#ifdef SURFE_USE_GMP
 		mpf_set_default_prec(128.0);
+#endif
 		if (_get_unisolvent_subset(interface_point_lists)) _initialize_basis();
 		else
 		{
 			// throw exception
 		}
 	}
-	Matrix <mpf_class, Dynamic, 1> poly(const Point *p);
-	Matrix <mpf_class, Dynamic, 1> poly_dx(const Point *p);
-	Matrix <mpf_class, Dynamic, 1> poly_dy(const Point *p);
-	Matrix <mpf_class, Dynamic, 1> poly_dz(const Point *p);
+	Matrix <extended_float, Dynamic, 1> poly(const Point *p);
+	Matrix <extended_float, Dynamic, 1> poly_dx(const Point *p);
+	Matrix <extended_float, Dynamic, 1> poly_dy(const Point *p);
+	Matrix <extended_float, Dynamic, 1> poly_dz(const Point *p);
 	std::vector < Interface > unisolvent_subset_points;
+	// where the unisolvent points come from: interface_point_lists[unisolvent_subset_list][unisolvent_subset_indices[j]]
+	// (-1 for a point that was moved off its interface point)
+	int unisolvent_subset_list;
+	std::vector < int > unisolvent_subset_indices;
 };
 
 class Modified_Kernel : public Kernel {
 public:
 	Modified_Kernel(RBFKernel* arbfkernel, const std::vector < std::vector < Interface > > &interface_point_lists)
 	{ 
+#ifdef SURFE_USE_GMP
 		mpf_set_default_prec(128.0);
+#endif
 		_aRBFKernel = arbfkernel;
 		_aLPB = new Lagrangian_Polynomial_Basis(interface_point_lists);
 	}
@@ -528,9 +575,35 @@ public:
 	double basis_planar_tangent(const Parameter_Types::FirstDerivatives& fd );
 	double basis_tangent_planar(const Parameter_Types::FirstDerivatives& fd );
 	virtual Modified_Kernel *clone() { return new Modified_Kernel(*this); }
+	Lagrangian_Polynomial_Basis *lagrangian_basis() const { return _aLPB; }
 private:   
 	RBFKernel *_aRBFKernel;
 	Lagrangian_Polynomial_Basis *_aLPB;
 };
 
+// K(x,y) = p_j(y) for the Lagrange polynomial p_j of a Modified_Kernel. An interpolant evaluated with this kernel
+// gives its constraint functionals applied to p_j. Derivatives with respect to the first point vanish.
+class Lagrange_Polynomial_Kernel : public Kernel {
+public:
+	Lagrange_Polynomial_Kernel(Lagrangian_Polynomial_Basis *lpb, const int &j) : _aLPB(lpb), _j(j) {}
+	~Lagrange_Polynomial_Kernel() {}
+	double basis_pt_pt();
+	double basis_pt_planar_x();
+	double basis_planar_x_pt() { return 0.0; }
+	double basis_pt_planar_y();
+	double basis_planar_y_pt() { return 0.0; }
+	double basis_pt_planar_z();
+	double basis_planar_z_pt() { return 0.0; }
+	double basis_pt_tangent();
+	double basis_tangent_pt() { return 0.0; }
+	double basis_planar_planar(const Parameter_Types::SecondDerivatives& ) { return 0.0; }
+	double basis_tangent_tangent() { return 0.0; }
+	double basis_planar_tangent(const Parameter_Types::FirstDerivatives& ) { return 0.0; }
+	double basis_tangent_planar(const Parameter_Types::FirstDerivatives& ) { return 0.0; }
+	virtual Lagrange_Polynomial_Kernel *clone() { return new Lagrange_Polynomial_Kernel(*this); }
+private:
+	Lagrangian_Polynomial_Basis *_aLPB;
+	int _j;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,370 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <classification.h>
+
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <limits>
+
+// distances between the closest and the farthest points of two boxes
+static void _box_distances(const double *lower_a, const double *upper_a, const double *lower_b, const double *upper_b, double &r_min, double &r_max)
+{
+	double near2 = 0.0;
+	double far2 = 0.0;
+	for (int d = 0; d < 3; d++ )
+	{
+		double gap = std::max(0.0, std::max(lower_b[d] - upper_a[d], lower_a[d] - upper_b[d]));
+		double span = std::max(upper_b[d] - lower_a[d], upper_a[d] - lower_b[d]);
+		near2 += gap*gap;
+		far2 += span*span;
+	}
+	r_min = sqrt(near2);
+	r_max = sqrt(far2);
+}
+
+Lithology_Classifier::Lithology_Classifier(const Tiled_Evaluator &evaluator, const int &leaf_size)
+{
+	_evaluator = &evaluator;
+	_exact_fraction = 0.0;
+	_build_tree(evaluator.centers(), std::max(1, leaf_size));
+	_compute_moments();
+}
+
+bool Lithology_Classifier::supported() const
+{
+	if (_evaluator->n_fields() != 1 || _evaluator->kernel() == NULL || _boxes.empty()) return false;
+	for (int j = 0; j < _centers.size(); j++ ) if (_centers.c[j] != 0.0) return false;
+	double bound = _evaluator->kernel()->hessian_bound(1.0, 1.0);
+	return bound < std::numeric_limits<double>::infinity();
+}
+
+void Lithology_Classifier::_build_tree(const Packed_Centers &centers, const int &leaf_size)
+{
+	int n = centers.size();
+	std::vector<int> order(n);
+	for (int j = 0; j < n; j++ ) order[j] = j;
+	const std::vector<double> *coordinates[3] = { &centers.x, &centers.y, &centers.z };
+
+	_boxes.clear();
+	if (n > 0)
+	{
+		Box root;
+		root.begin = 0;
+		root.end = n;
+		_boxes.push_back(root);
+	}
+	// breadth first, a box is split at the median of its longest side
+	for (int k = 0; k < (int)_boxes.size(); k++ )
+	{
+		int begin = _boxes[k].begin;
+		int end = _boxes[k].end;
+		Box &box = _boxes[k];
+		for (int j = begin; j < end; j++ )
+			for (int d = 0; d < 3; d++ )
+			{
+				double p = (*coordinates[d])[order[j]];
+				if (j == begin || p < box.lower[d]) box.lower[d] = p;
+				if (j == begin || p > box.upper[d]) box.upper[d] = p;
+			}
+		box.first_child = -1;
+		int axis = 0;
+		for (int d = 1; d < 3; d++ ) if (box.upper[d] - box.lower[d] > box.upper[axis] - box.lower[axis]) axis = d;
+		if (end - begin <= leaf_size || box.upper[axis] == box.lower[axis]) continue;
+
+		int middle = (begin + end) / 2;
+		const std::vector<double> &coordinate = *coordinates[axis];
+		std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+			[&coordinate](const int &a, const int &b) { return coordinate[a] < coordinate[b]; });
+		box.first_child = (int)_boxes.size();
+		Box child;
+		child.begin = begin;
+		child.end = middle;
+		_boxes.push_back(child);
+		child.begin = middle;
+		child.end = end;
+		_boxes.push_back(child);
+	}
+
+	// centers in tree order
+	_centers = Packed_Centers();
+	_centers.weights.resize(n, 1);
+	for (int j = 0; j < n; j++ )
+	{
+		int k = order[j];
+		_centers.x.push_back(centers.x[k]);
+		_centers.y.push_back(centers.y[k]);
+		_centers.z.push_back(centers.z[k]);
+		_centers.c.push_back(centers.c[k]);
+		_centers.value.push_back(centers.value[k]);
+		_centers.dx.push_back(centers.dx[k]);
+		_centers.dy.push_back(centers.dy[k]);
+		_centers.dz.push_back(centers.dz[k]);
+		_centers.weights(j, 0) = centers.weights(k, 0);
+	}
+	// point centers are no longer first: value is read for every center
+	_centers.n_point_centers = 0;
+}
+
+void Lithology_Classifier::_compute_moments()
+{
+	// moments about the box center c0: sum w*L(f) ~ f(c0)*sum w*value + grad f(c0).sum w*(value*(c - c0) + d)
+	int n_boxes = (int)_boxes.size();
+	_moments = Packed_Centers();
+	_moments.weights = MatrixXd::Ones(n_boxes, 1);
+	for (int k = 0; k < n_boxes; k++ )
+	{
+		Box &box = _boxes[k];
+		double c0[3];
+		for (int d = 0; d < 3; d++ ) c0[d] = 0.5*(box.lower[d] + box.upper[d]);
+		double m0 = 0.0;
+		double m1[3] = { 0.0, 0.0, 0.0 };
+		box.moment_bound = 0.0;
+		for (int j = box.begin; j < box.end; j++ )
+		{
+			double w = _centers.weights(j, 0);
+			double offset[3] = { _centers.x[j] - c0[0], _centers.y[j] - c0[1], _centers.z[j] - c0[2] };
+			double direction[3] = { _centers.dx[j], _centers.dy[j], _centers.dz[j] };
+			m0 += w*_centers.value[j];
+			for (int d = 0; d < 3; d++ ) m1[d] += w*(_centers.value[j]*offset[d] + direction[d]);
+			double rho = sqrt(offset[0]*offset[0] + offset[1]*offset[1] + offset[2]*offset[2]);
+			double d_norm = sqrt(direction[0]*direction[0] + direction[1]*direction[1] + direction[2]*direction[2]);
+			box.moment_bound += fabs(w)*(0.5*fabs(_centers.value[j])*rho*rho + d_norm*rho);
+		}
+		_moments.x.push_back(c0[0]);
+		_moments.y.push_back(c0[1]);
+		_moments.z.push_back(c0[2]);
+		_moments.c.push_back(0.0);
+		_moments.value.push_back(m0);
+		_moments.dx.push_back(m1[0]);
+		_moments.dy.push_back(m1[1]);
+		_moments.dz.push_back(m1[2]);
+	}
+	_moments.n_point_centers = 0;
+}
+
+int Lithology_Classifier::_classify_brick(const double *origin, const double *spacing, const int *dims, const int *lower, const int *upper,
+	const std::vector<double> &iso_values, Tiled_Evaluator::Workspace &workspace, unsigned char *units) const
+{
+	const int nb_max = brick_size*brick_size*brick_size;
+	long long nodes[nb_max];
+	double px[nb_max];
+	double py[nb_max];
+	double pz[nb_max];
+	double pc[nb_max];
+	int nb = 0;
+	for (int k = lower[2]; k < upper[2]; k++ )
+		for (int j = lower[1]; j < upper[1]; j++ )
+			for (int i = lower[0]; i < upper[0]; i++ )
+			{
+				nodes[nb] = i + (long long)dims[0]*(j + (long long)dims[1]*k);
+				px[nb] = origin[0] + i*spacing[0];
+				py[nb] = origin[1] + j*spacing[1];
+				pz[nb] = origin[2] + k*spacing[2];
+				pc[nb] = 0.0;
+				nb++;
+			}
+	double brick_lower[3];
+	double brick_upper[3];
+	for (int d = 0; d < 3; d++ )
+	{
+		brick_lower[d] = origin[d] + lower[d]*spacing[d];
+		brick_upper[d] = origin[d] + (upper[d] - 1)*spacing[d];
+	}
+	const RBFKernel *kernel = _evaluator->kernel();
+
+	// polynomial plus the root moments
+	std::vector<Evaluation_Point> pts;
+	std::vector<int> indices(nb);
+	for (int i = 0; i < nb; i++ )
+	{
+		pts.push_back(Evaluation_Point(px[i], py[i], pz[i]));
+		indices[i] = i;
+	}
+	MatrixXd fields = MatrixXd::Zero(nb, 1);
+	_evaluator->set_fields(pts, &indices[0], nb, fields);
+	fields.setZero();
+	_evaluator->accumulate(_moments, 0, 1, px, py, pz, pc, nb, workspace, fields);
+	double polynomial[nb_max];
+	double value[nb_max];
+	for (int i = 0; i < nb; i++ )
+	{
+		polynomial[i] = pts[i].scalar_field();
+		value[i] = polynomial[i] + fields(i, 0);
+	}
+
+	// boxes summed through their moments, largest error bound on top
+	std::vector<std::pair<double, int> > frontier;
+	std::function<void(const int &)> push = [&](const int &k) {
+		const Box &box = _boxes[k];
+		double r_min, r_max;
+		_box_distances(brick_lower, brick_upper, box.lower, box.upper, r_min, r_max);
+		double bound = (box.moment_bound > 0.0) ? kernel->hessian_bound(r_min, r_max)*box.moment_bound : 0.0;
+		frontier.push_back(std::make_pair(bound, k));
+		std::push_heap(frontier.begin(), frontier.end());
+	};
+	push(0);
+
+	int pending[nb_max];
+	for (int i = 0; i < nb; i++ ) pending[i] = i;
+	int n_pending = nb;
+	double qx[nb_max];
+	double qy[nb_max];
+	double qz[nb_max];
+	MatrixXd refined(nb, 1);
+	MatrixXd moments(nb, 1);
+	int n_exact = 0;
+	int exact_sums = 0;
+	// kernel evaluations per pending node spent on refinements, past the budget the pending nodes get the exact sum
+	int work = 1;
+	int budget = _centers.size() / 4;
+	while (true)
+	{
+		// nodes whose value +- the bounds left on the frontier still holds an iso value stay pending. Summed afresh
+		// each pass, a running sum of added and removed bounds of very different size loses the small ones
+		double margin = 0.0;
+		for (size_t f = 0; f < frontier.size(); f++ ) margin += frontier[f].first;
+		int m = 0;
+		for (int p = 0; p < n_pending; p++ )
+		{
+			int i = pending[p];
+			int unit_low = (int)(std::upper_bound(iso_values.begin(), iso_values.end(), value[i] - margin) - iso_values.begin());
+			int unit_high = (int)(std::upper_bound(iso_values.begin(), iso_values.end(), value[i] + margin) - iso_values.begin());
+			if (unit_low == unit_high || frontier.empty())
+			{
+				units[nodes[i]] = (unsigned char)(std::upper_bound(iso_values.begin(), iso_values.end(), value[i]) - iso_values.begin());
+				exact_sums += n_exact;
+			}
+			else pending[m++] = i;
+		}
+		n_pending = m;
+		if (n_pending == 0) break;
+		if (work > budget)
+		{
+			for (int p = 0; p < n_pending; p++ )
+			{
+				qx[p] = px[pending[p]];
+				qy[p] = py[pending[p]];
+				qz[p] = pz[pending[p]];
+			}
+			fields.setZero();
+			_evaluator->accumulate(_centers, 0, _centers.size(), qx, qy, qz, pc, n_pending, workspace, fields);
+			for (int p = 0; p < n_pending; p++ )
+			{
+				int i = pending[p];
+				units[nodes[i]] = (unsigned char)(std::upper_bound(iso_values.begin(), iso_values.end(), polynomial[i] + fields(p, 0)) - iso_values.begin());
+			}
+			exact_sums += n_pending*_centers.size();
+			break;
+		}
+
+		// the box of the largest bound: moments of its children or, at a leaf, its exact sum in place of its moments
+		std::pop_heap(frontier.begin(), frontier.end());
+		int k = frontier.back().second;
+		frontier.pop_back();
+		const Box &box = _boxes[k];
+		for (int p = 0; p < n_pending; p++ )
+		{
+			qx[p] = px[pending[p]];
+			qy[p] = py[pending[p]];
+			qz[p] = pz[pending[p]];
+		}
+		refined.setZero();
+		moments.setZero();
+		if (box.first_child < 0)
+		{
+			_evaluator->accumulate(_centers, box.begin, box.end, qx, qy, qz, pc, n_pending, workspace, refined);
+			n_exact += box.end - box.begin;
+			work += box.end - box.begin + 1;
+		}
+		else
+		{
+			_evaluator->accumulate(_moments, box.first_child, box.first_child + 2, qx, qy, qz, pc, n_pending, workspace, refined);
+			push(box.first_child);
+			push(box.first_child + 1);
+			work += 3;
+		}
+		_evaluator->accumulate(_moments, k, k + 1, qx, qy, qz, pc, n_pending, workspace, moments);
+		for (int p = 0; p < n_pending; p++ ) value[pending[p]] += refined(p, 0) - moments(p, 0);
+	}
+	return exact_sums;
+}
+
+bool Lithology_Classifier::classify_grid(const double *origin, const double *spacing, const int *dims, const std::vector<double> &iso_values,
+	unsigned char *units, const double &max_exact_fraction)
+{
+	std::vector<double> sorted_iso_values(iso_values);
+	std::sort(sorted_iso_values.begin(), sorted_iso_values.end());
+	int n_bricks[3];
+	for (int d = 0; d < 3; d++ ) n_bricks[d] = (dims[d] + brick_size - 1) / brick_size;
+	int n = n_bricks[0]*n_bricks[1]*n_bricks[2];
+	const int sample_stride = 32;
+	double exact_sums[2] = { 0.0, 0.0 }; // sampled bricks, others
+	double nodes[2] = { 0.0, 0.0 };
+
+	// every sample_stride-th brick first, the rest only if the sample stays under max_exact_fraction
+	for (int pass = 0; pass < 2; pass++ )
+	{
+		if (pass == 1 && nodes[0] > 0 && exact_sums[0] > max_exact_fraction*nodes[0]*_centers.size())
+		{
+			_exact_fraction = exact_sums[0] / (nodes[0]*_centers.size());
+			return false;
+		}
+		double pass_sums = 0.0;
+		double pass_nodes = 0.0;
+		#pragma omp parallel
+		{
+			Tiled_Evaluator::Workspace workspace;
+			#pragma omp for schedule(dynamic) reduction(+:pass_sums, pass_nodes)
+			for (int b = 0; b < n; b++ ){
+				if ((b % sample_stride == 0) != (pass == 0)) continue;
+				int brick[3] = { b % n_bricks[0], (b / n_bricks[0]) % n_bricks[1], b / (n_bricks[0]*n_bricks[1]) };
+				int lower[3];
+				int upper[3];
+				for (int d = 0; d < 3; d++ )
+				{
+					lower[d] = brick[d]*brick_size;
+					upper[d] = std::min(dims[d], lower[d] + brick_size);
+				}
+				pass_sums += _classify_brick(origin, spacing, dims, lower, upper, sorted_iso_values, workspace, units);
+				pass_nodes += (upper[0] - lower[0])*(upper[1] - lower[1])*(upper[2] - lower[2]);
+			}
+		}
+		exact_sums[pass] = pass_sums;
+		nodes[pass] = pass_nodes;
+	}
+	double total = (nodes[0] + nodes[1])*_centers.size();
+	_exact_fraction = (total > 0) ? (exact_sums[0] + exact_sums[1]) / total : 0.0;
+	return true;
+}
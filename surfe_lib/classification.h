@@ -0,0 +1,89 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef classification_h
+#define classification_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <tiled_evaluation.h>
+
+#include <vector>
+#include <Eigen/Core>
+
+using namespace Eigen;
+
+// Classification of the nodes of a regular grid into units, the intervals between sorted iso values, without their
+// exact scalar field. The centers are sorted into a binary tree of boxes. A box is summed through its moments about its
+// center (a point and a derivative center), the error of which is bounded by the kernel's second derivatives between a
+// brick of nodes and the box (RBFKernel::hessian_bound). At a brick the root moments are refined, box of the largest
+// bound first, into the moments of the children and at the leaves into the exact sums, until no iso value is left
+// within the remaining bound of a node's value. Nodes away from the contacts stop after a fraction of the centers,
+// the others end with their exact value.
+class SURFE_LIB_EXPORT Lithology_Classifier {
+private:
+	struct Box {
+		double lower[3];
+		double upper[3];
+		int begin; // centers [begin, end) in tree order
+		int end;
+		int first_child; // two consecutive children, -1 for a leaf
+		double moment_bound; // sum |w|(|value| rho^2/2 + |d| rho), rho the distance of a center to the box center
+	};
+	const Tiled_Evaluator *_evaluator;
+	Packed_Centers _centers; // in tree order
+	Packed_Centers _moments; // one center per box
+	std::vector<Box> _boxes;
+	double _exact_fraction;
+	void _build_tree(const Packed_Centers &centers, const int &leaf_size);
+	void _compute_moments();
+	// units of the nodes [lower, upper) of the grid, returns the # of centers summed exactly
+	int _classify_brick(const double *origin, const double *spacing, const int *dims, const int *lower, const int *upper,
+		const std::vector<double> &iso_values, Tiled_Evaluator::Workspace &workspace, unsigned char *units) const;
+public:
+	// brick_size nodes along each axis
+	static const int brick_size = 4;
+	Lithology_Classifier(const Tiled_Evaluator &evaluator, const int &leaf_size = 8);
+	// false for several scalar fields, centers using the fourth coordinate c or a kernel without a second derivative bound
+	bool supported() const;
+	// units[node] = # of iso values <= scalar field at the node, node index as in Tiled_Evaluator::evaluate_grid.
+	// At most 255 iso values. A sample of the bricks is classified first: false if it needs more than max_exact_fraction
+	// of the kernel sums (kernels that grow with the distance, e.g. cubic, rarely close their bounds), the exact
+	// field is then cheaper
+	bool classify_grid(const double *origin, const double *spacing, const int *dims, const std::vector<double> &iso_values, unsigned char *units,
+		const double &max_exact_fraction = 0.5);
+	// fraction of the kernel sums (nodes x centers) computed by the last classify_grid, over the sample if it returned false
+	double exact_fraction() const { return _exact_fraction; }
+};
+
+#endif
@@ -123,6 +123,7 @@ Continuous_Property::Continuous_Property(const model_parameters& m_p, const Basi
 	b_input = basic_i;
 
 	_iteration = 0;
+	_n_properties = 1;
 }
 
 
@@ -145,6 +146,17 @@ bool Continuous_Property::get_method_parameters()
 	// Total number of equality constraints
 	b_parameters.n_equality = b_parameters.n_interface + 3*b_parameters.n_planar + b_parameters.n_tangent;
 
+	// # of properties (value columns) ...
+	_n_properties = 1;
+	if (b_parameters.n_interface != 0) _n_properties = b_input.itrface->at(0).n_properties();
+	for (int j = 0; j < (int)b_parameters.n_interface; j++ ){
+		if (b_input.itrface->at(j).n_properties() != _n_properties)
+		{
+			error_msg.append(" Interface points have different numbers of property values.");
+			return false;
+		}
+	}
+
 	// polynomial parameters ...
 	if (b_parameters.n_inequality == 0)
 	{
@@ -176,7 +188,18 @@ bool Continuous_Property::setup_system_solver()
 	MatrixXd interpolation_matrix(n,n);
 	if (!get_interpolation_matrix(interpolation_matrix)) return false;
 
-	Linear_LU_decomposition *llu = new Linear_LU_decomposition(interpolation_matrix,equality_values);
+	if (_n_properties > 1)
+	{
+		// the interpolation matrix is the same for every property: factor once, one column of weights per property
+		MatrixXd property_values(n,_n_properties);
+		get_equality_values(property_values);
+		Linear_LU_decomposition *mlu = new Linear_LU_decomposition(interpolation_matrix,property_values);
+		if (!mlu->solve()) return false;
+		solver = mlu;
+		return true;
+	}
+
+	System_Solver *llu = Linear_Solver_Selector::create(interpolation_matrix,equality_values,m_parameters,b_parameters);
 	if (!llu->solve()) return false;
 	solver = llu;
 
@@ -323,38 +346,82 @@ void Continuous_Property::eval_scalar_interpolant_at_point( Point &p )
 	int n_p = b_parameters.n_planar;
 	int n_t = b_parameters.n_tangent;
 
+	// basis function values at p, one per weight. They are shared by all the properties
 	Kernel *kernel_j = kernel->clone();
-	double elemsum_1 = 0.0;
-	double elemsum_2 = 0.0;
-	double elemsum_3 = 0.0;
-	double elemsum_4 = 0.0;
-	double poly = 0.0;
+	VectorXd basis_values = VectorXd::Zero(solver->weights.size());
 	for (int k = 0; k < n_i; k++ ){
 		kernel_j->set_points(p, b_input.itrface->at(k));
-		elemsum_2 += solver->weights[k] * kernel_j->basis_pt_pt();
+		basis_values(k) = kernel_j->basis_pt_pt();
 	}
 	for (int k = 0; k < n_p; k++ ){
 		kernel_j->set_points(p, b_input.planar->at(k));
-		elemsum_3 += solver->weights[n_i + 3*k] * kernel_j->basis_pt_planar_x();
-		elemsum_3 += solver->weights[n_i + 3*k + 1] * kernel_j->basis_pt_planar_y();
-		elemsum_3 += solver->weights[n_i + 3*k + 2] * kernel_j->basis_pt_planar_z();
+		basis_values(n_i + 3*k) = kernel_j->basis_pt_planar_x();
+		basis_values(n_i + 3*k + 1) = kernel_j->basis_pt_planar_y();
+		basis_values(n_i + 3*k + 2) = kernel_j->basis_pt_planar_z();
 	}
 	for (int k = 0; k < n_t; k++ ){
 		kernel_j->set_points(p, b_input.tangent->at(k));
-		elemsum_4 += solver->weights[n_i + 3*n_p + k] * kernel_j->basis_pt_tangent();
+		basis_values(n_i + 3*n_p + k) = kernel_j->basis_pt_tangent();
 	}
 	if (b_parameters.poly_term)
 	{
 		Polynomial_Basis *p_basis_j = p_basis->clone();
 		p_basis_j->set_point(p);
 		VectorXd b = p_basis_j->basis();
-		for (int k = 0; k < (int)b.size(); k++ ) poly += b(k) * solver->weights[n_i + 3*n_p + n_t + k];
+		for (int k = 0; k < (int)b.size(); k++ ) basis_values(n_i + 3*n_p + n_t + k) = b(k);
 		delete p_basis_j;
 	}
-	p.set_scalar_field(elemsum_1 + elemsum_2 + elemsum_3 +elemsum_4 + poly);
+
+	if (_n_properties > 1)
+	{
+		VectorXd values = solver->weights_matrix.transpose()*basis_values;
+		p.set_scalar_fields(std::vector<double>(values.data(), values.data() + values.size()));
+		p.set_scalar_field(values(0));
+	}
+	else p.set_scalar_field(basis_values.dot(solver->weights));
 	delete kernel_j;
 }
 
+Tiled_Evaluator *Continuous_Property::get_tiled_evaluator()
+{
+	Tiled_Evaluator *evaluator = _new_tiled_evaluator(_n_properties);
+	if (evaluator == NULL) return NULL;
+
+	int n_i = b_parameters.n_interface;
+	int n_p = b_parameters.n_planar;
+	int n_t = b_parameters.n_tangent;
+
+	// one column of weights per property
+	MatrixXd weights;
+	if (_n_properties > 1) weights = solver->weights_matrix;
+	else weights = solver->weights;
+	RowVectorXd w;
+	for (int k = 0; k < n_i; k++ ){
+		w = weights.row(k);
+		evaluator->add_point_center(b_input.itrface->at(k), w.data());
+	}
+	for (int k = 0; k < n_p; k++ ){
+		w = weights.row(n_i + 3*k);
+		evaluator->add_derivative_center(b_input.planar->at(k), 1.0, 0.0, 0.0, w.data());
+		w = weights.row(n_i + 3*k + 1);
+		evaluator->add_derivative_center(b_input.planar->at(k), 0.0, 1.0, 0.0, w.data());
+		w = weights.row(n_i + 3*k + 2);
+		evaluator->add_derivative_center(b_input.planar->at(k), 0.0, 0.0, 1.0, w.data());
+	}
+	for (int k = 0; k < n_t; k++ ){
+		Tangent &t = b_input.tangent->at(k);
+		w = weights.row(n_i + 3*n_p + k);
+		evaluator->add_derivative_center(t, t.tx(), t.ty(), t.tz(), w.data());
+	}
+	if (b_parameters.poly_term)
+	{
+		int n_c = n_i + 3*n_p + n_t;
+		evaluator->set_polynomial(p_basis, weights.bottomRows(weights.rows() - n_c));
+	}
+	evaluator->pack();
+	return evaluator;
+}
+
 void Continuous_Property::eval_vector_interpolant_at_point( Point &p )
 {
 	int n_i = b_parameters.n_interface;
@@ -376,30 +443,30 @@ void Continuous_Property::eval_vector_interpolant_at_point( Point &p )
 	double poly_z = 0.0;
 	// interface constraints 
 	for (int k = 0; k < n_i; k++ ){
-		kernel->set_points(p, b_input.itrface->at(k));
-		elemsum_1_x += solver->weights[k] * kernel->basis_planar_x_pt();
-		elemsum_1_y += solver->weights[k] * kernel->basis_planar_y_pt();
-		elemsum_1_z += solver->weights[k] * kernel->basis_planar_z_pt();
+		kernel_j->set_points(p, b_input.itrface->at(k));
+		elemsum_1_x += solver->weights[k] * kernel_j->basis_planar_x_pt();
+		elemsum_1_y += solver->weights[k] * kernel_j->basis_planar_y_pt();
+		elemsum_1_z += solver->weights[k] * kernel_j->basis_planar_z_pt();
 	}
 	// normal constraints
 	for (int k = 0; k < n_p; k++ ){
-		kernel->set_points(p, b_input.planar->at(k));
-		elemsum_2_x += solver->weights[n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDX);
-		elemsum_2_x += solver->weights[n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDY);
-		elemsum_2_x += solver->weights[n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDZ);
-		elemsum_2_y += solver->weights[n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDX);
-		elemsum_2_y += solver->weights[n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDY);
-		elemsum_2_y += solver->weights[n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDZ);
-		elemsum_2_z += solver->weights[n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDX);
-		elemsum_2_z += solver->weights[n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDY);
-		elemsum_2_z += solver->weights[n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDZ);
+		kernel_j->set_points(p, b_input.planar->at(k));
+		elemsum_2_x += solver->weights[n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDX);
+		elemsum_2_x += solver->weights[n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDY);
+		elemsum_2_x += solver->weights[n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDZ);
+		elemsum_2_y += solver->weights[n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDX);
+		elemsum_2_y += solver->weights[n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDY);
+		elemsum_2_y += solver->weights[n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDZ);
+		elemsum_2_z += solver->weights[n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDX);
+		elemsum_2_z += solver->weights[n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDY);
+		elemsum_2_z += solver->weights[n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDZ);
 	}
 	// tangent constraints
 	for (int k = 0; k < n_t; k++ ){
-		kernel->set_points(p, b_input.tangent->at(k));
-		elemsum_3_x += solver->weights[n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DX);
-		elemsum_3_y += solver->weights[n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DY);
-		elemsum_3_z += solver->weights[n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DZ);
+		kernel_j->set_points(p, b_input.tangent->at(k));
+		elemsum_3_x += solver->weights[n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DX);
+		elemsum_3_y += solver->weights[n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DY);
+		elemsum_3_z += solver->weights[n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DZ);
 	}
 	if (b_parameters.poly_term)
 	{
@@ -440,6 +507,19 @@ bool Continuous_Property::get_equality_values( VectorXd &equality_values )
 	return true;
 }
 
+bool Continuous_Property::get_equality_values( MatrixXd &equality_values )
+{
+	// only the interface constraints carry property values, the other rows are the same for every property
+	VectorXd values(equality_values.rows());
+	get_equality_values(values);
+	for (int p = 0; p < (int)equality_values.cols(); p++ ){
+		equality_values.col(p) = values;
+		for (int j = 0; j < (int)b_input.itrface->size(); j++) equality_values(j,p) = b_input.itrface->at(j).property_value(p);
+	}
+
+	return true;
+}
+
 bool Continuous_Property::process_input_data()
 {
 	if ((int)b_input.itrface->size() == 0) return false;
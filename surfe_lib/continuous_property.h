@@ -40,16 +40,21 @@
 
 class SURFE_LIB_EXPORT Continuous_Property : public GRBF_Modelling_Methods {
 private:
+	int _n_properties; // # of property values per interface point, solved together
 	bool _get_polynomial_matrix_block(MatrixXd &poly_matrix);
 	bool _insert_polynomial_matrix_blocks_in_interpolation_matrix(const MatrixXd &poly_matrix, MatrixXd &interpolation_matrix);
 public:
 	// Constructor/Destructor
 	Continuous_Property(const model_parameters& m_p, const Basic_input& basic_i);
-	Continuous_Property(){};
+	Continuous_Property() : _n_properties(1) {};
 	// Methods
 	Polynomial_Basis *create_polynomial_basis(const int &poly_order);
 	bool get_interpolation_matrix(MatrixXd &interpolation_matrix);
 	bool get_equality_values(VectorXd &equality_values);
+	// one column per property
+	bool get_equality_values(MatrixXd &equality_values);
+	int n_properties() const { return _n_properties; }
+	int n_scalar_fields() const { return _n_properties; }
 	void eval_scalar_interpolant_at_point(Point &p);
 	void eval_vector_interpolant_at_point(Point &p);
 	bool get_method_parameters();
@@ -59,6 +64,7 @@ public:
 	bool measure_residuals(Basic_input &input);
 	bool append_greedy_input(Basic_input &input);
 	bool convert_modified_kernel_to_rbf_kernel() { return true; } // To IMPLEMENT
+	Tiled_Evaluator *get_tiled_evaluator();
 	GRBF_Modelling_Methods *clone() { return new Continuous_Property(*this); }
 	// Attributes
 	Polynomial_Basis *p_basis;
@@ -34,9 +34,9 @@
 #ifndef debug_h
 #define debug_h
 
-#include <gmpxx.h>
 #include <modelling_input.h>
 #include <modeling_methods.h>
+#include <math_methods.h>
 
 #include <vector>
 #include <string>
@@ -45,7 +45,7 @@
 #include <fstream>
 #include <Windows.h>
 
-typedef mpf_class mpfc;
+typedef extended_float mpfc;
 
 void open_console_window();
 
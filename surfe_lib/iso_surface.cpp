@@ -0,0 +1,169 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <iso_surface.h>
+
+#include <algorithm>
+#include <cmath>
+
+// corners of the 6 tetrahedra of a cell, corner bits: 1 i + 1, 2 j + 1, 4 k + 1. Each one walks from corner 0 to corner 7
+// along the three axes in one of their orders
+static const int _tetrahedra[6][4] = {
+	{ 0, 1, 3, 7 }, { 0, 1, 5, 7 }, { 0, 2, 3, 7 }, { 0, 2, 6, 7 }, { 0, 4, 5, 7 }, { 0, 4, 6, 7 }
+};
+
+Iso_Surface_Extractor::Iso_Surface_Extractor(const double *origin, const double *spacing, const int *dims, const std::vector<double> &iso_values)
+	: _plane(0), _meshes(iso_values.size()), _edge_vertices(iso_values.size())
+{
+	for (int d = 0; d < 3; d++ )
+	{
+		_origin[d] = origin[d];
+		_spacing[d] = spacing[d];
+		_dims[d] = dims[d];
+	}
+	for (int s = 0; s < (int)iso_values.size(); s++ ) _meshes[s].iso_value = iso_values[s];
+}
+
+int Iso_Surface_Extractor::_edge_vertex(const int &s, const long long &a, const long long &b, const double &fa, const double &fb)
+{
+	long long lower = std::min(a, b);
+	long long upper = std::max(a, b);
+	long long plane_size = (long long)_dims[0]*_dims[1];
+	// axes of the edge from the differences of the node coordinates
+	int axes = 0;
+	if (upper % _dims[0] != lower % _dims[0]) axes |= 1;
+	if ((upper / _dims[0]) % _dims[1] != (lower / _dims[0]) % _dims[1]) axes |= 2;
+	if (upper / plane_size != lower / plane_size) axes |= 4;
+	long long key = lower*8 + axes;
+	std::map<long long, int>::iterator it = _edge_vertices[s].find(key);
+	if (it != _edge_vertices[s].end()) return it->second;
+
+	Iso_Surface_Mesh &mesh = _meshes[s];
+	double t = (mesh.iso_value - fa) / (fb - fa);
+	double pa[3] = { (double)(a % _dims[0]), (double)((a / _dims[0]) % _dims[1]), (double)(a / plane_size) };
+	double pb[3] = { (double)(b % _dims[0]), (double)((b / _dims[0]) % _dims[1]), (double)(b / plane_size) };
+	for (int d = 0; d < 3; d++ ) mesh.vertices.push_back(_origin[d] + (pa[d] + t*(pb[d] - pa[d]))*_spacing[d]);
+	int vertex = mesh.n_vertices() - 1;
+	_edge_vertices[s][key] = vertex;
+	return vertex;
+}
+
+void Iso_Surface_Extractor::add_plane(const double *values)
+{
+	int nx = _dims[0];
+	int ny = _dims[1];
+	long long plane_size = (long long)nx*ny;
+	if (_plane > 0)
+	{
+		long long base = (long long)(_plane - 1)*plane_size; // node (0, 0) of the previous plane
+		for (int s = 0; s < (int)_meshes.size(); s++ )
+		{
+			Iso_Surface_Mesh &mesh = _meshes[s];
+			for (int j = 0; j + 1 < ny; j++ )
+				for (int i = 0; i + 1 < nx; i++ )
+				{
+					long long node[8];
+					double f[8];
+					for (int c = 0; c < 8; c++ )
+					{
+						int offset = (i + (c & 1)) + nx*(j + ((c & 2) ? 1 : 0));
+						node[c] = base + offset + ((c & 4) ? plane_size : 0);
+						f[c] = ((c & 4) ? values[offset] : _previous[offset]) - mesh.iso_value;
+					}
+					bool above = f[0] > 0.0;
+					bool crossed = false;
+					for (int c = 1; c < 8 && !crossed; c++ ) crossed = ((f[c] > 0.0) != above);
+					if (!crossed) continue;
+
+					for (int t = 0; t < 6; t++ )
+					{
+						int in[4];
+						int out[4];
+						int n_in = 0;
+						int n_out = 0;
+						for (int v = 0; v < 4; v++ )
+						{
+							int c = _tetrahedra[t][v];
+							if (f[c] > 0.0) in[n_in++] = c;
+							else out[n_out++] = c;
+						}
+						if (n_in == 0 || n_out == 0) continue;
+						int polygon[4];
+						int n_polygon = 0;
+						if (n_in == 1 || n_out == 1)
+						{
+							// one corner cut off: a triangle
+							int single = (n_in == 1) ? in[0] : out[0];
+							int *others = (n_in == 1) ? out : in;
+							for (int v = 0; v < 3; v++ )
+								polygon[n_polygon++] = _edge_vertex(s, node[single], node[others[v]], f[single] + mesh.iso_value, f[others[v]] + mesh.iso_value);
+						}
+						else
+						{
+							// two and two: a quadrilateral around the four crossed edges
+							int order[4][2] = { { in[0], out[0] }, { in[0], out[1] }, { in[1], out[1] }, { in[1], out[0] } };
+							for (int v = 0; v < 4; v++ )
+								polygon[n_polygon++] = _edge_vertex(s, node[order[v][0]], node[order[v][1]], f[order[v][0]] + mesh.iso_value, f[order[v][1]] + mesh.iso_value);
+						}
+						// the field is linear in the tetrahedron: its corners above the iso value are on the positive side of the polygon
+						double p_in[3] = { _origin[0] + (i + (in[0] & 1))*_spacing[0], _origin[1] + (j + ((in[0] & 2) ? 1 : 0))*_spacing[1],
+							_origin[2] + (_plane - 1 + ((in[0] & 4) ? 1 : 0))*_spacing[2] };
+						for (int k = 1; k + 1 < n_polygon; k++ )
+						{
+							int tri[3] = { polygon[0], polygon[k], polygon[k + 1] };
+							const double *p0 = &mesh.vertices[3*tri[0]];
+							const double *p1 = &mesh.vertices[3*tri[1]];
+							const double *p2 = &mesh.vertices[3*tri[2]];
+							double e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+							double e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+							double normal[3] = { e1[1]*e2[2] - e1[2]*e2[1], e1[2]*e2[0] - e1[0]*e2[2], e1[0]*e2[1] - e1[1]*e2[0] };
+							double side = normal[0]*(p_in[0] - p0[0]) + normal[1]*(p_in[1] - p0[1]) + normal[2]*(p_in[2] - p0[2]);
+							if (side == 0.0) continue; // degenerate, an iso value at a node
+							if (side < 0.0) std::swap(tri[1], tri[2]);
+							for (int v = 0; v < 3; v++ ) mesh.triangles.push_back(tri[v]);
+						}
+					}
+				}
+			// only the edges within the new plane are shared with the next layer of cells
+			long long first = (long long)_plane*plane_size;
+			std::map<long long, int>::iterator it = _edge_vertices[s].begin();
+			while (it != _edge_vertices[s].end())
+			{
+				if (it->first / 8 < first || (it->first & 4)) _edge_vertices[s].erase(it++);
+				else ++it;
+			}
+		}
+	}
+	_previous.assign(values, values + plane_size);
+	_plane++;
+}
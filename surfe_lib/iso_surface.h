@@ -0,0 +1,76 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef iso_surface_h
+#define iso_surface_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <vector>
+#include <map>
+
+// triangle mesh of one iso surface
+struct SURFE_LIB_EXPORT Iso_Surface_Mesh {
+	double iso_value;
+	std::vector<double> vertices; // x, y, z per vertex
+	std::vector<double> normals; // x, y, z per vertex: unit gradient of the scalar field (towards increasing values)
+	std::vector<int> triangles; // 3 vertices per triangle, counter clockwise seen from the side the normals point to
+	Iso_Surface_Mesh() : iso_value(0) {}
+	int n_vertices() const { return (int)vertices.size() / 3; }
+	int n_triangles() const { return (int)triangles.size() / 3; }
+};
+
+// Marching tetrahedra on the regular grid origin + (i, j, k)*spacing, fed one plane of nodes (fixed k) at a time: only the
+// previous plane is kept. Every cell is split in 6 tetrahedra around its diagonal from node (i, j, k) to (i+1, j+1, k+1),
+// which matches the split of the faces of neighbouring cells, and the field is linear in each tetrahedron. Vertices on
+// the edges of the last plane are cached to be shared with the next layer of cells. Normals are left to the caller.
+class SURFE_LIB_EXPORT Iso_Surface_Extractor {
+private:
+	double _origin[3];
+	double _spacing[3];
+	int _dims[3];
+	int _plane; // # of planes added
+	std::vector<double> _previous; // values of the previous plane
+	std::vector<Iso_Surface_Mesh> _meshes;
+	// per mesh: vertex of the edge (lower node*8 + axes of the edge, a bit per axis) of the current layer of cells
+	std::vector< std::map<long long, int> > _edge_vertices;
+	int _edge_vertex(const int &s, const long long &a, const long long &b, const double &fa, const double &fb);
+public:
+	Iso_Surface_Extractor(const double *origin, const double *spacing, const int *dims, const std::vector<double> &iso_values);
+	// values of the nodes of plane k = # of planes added so far (dims[0]*dims[1], i fastest). Triangulates the layer of
+	// cells between it and the previous plane
+	void add_plane(const double *values);
+	std::vector<Iso_Surface_Mesh> &meshes() { return _meshes; }
+};
+
+#endif
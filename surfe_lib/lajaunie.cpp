@@ -142,6 +142,7 @@ Lajaunie_Approach::Lajaunie_Approach(const model_parameters& m_p, const Basic_in
 	b_input = basic_i;
 
 	_increment_pairs = new std::vector < std::vector < Interface > >();
+	p_basis = NULL;
 
 	_iteration = 0;
 }
@@ -243,7 +244,7 @@ bool Lajaunie_Approach::setup_system_solver()
 		get_equality_values(equality_values);
 		MatrixXd interpolation_matrix(n, n);
 		if (!get_interpolation_matrix(interpolation_matrix)) return false;
-		Linear_LU_decomposition *llu = new Linear_LU_decomposition(interpolation_matrix,equality_values);
+		System_Solver *llu = Linear_Solver_Selector::create(interpolation_matrix,equality_values,m_parameters,b_parameters);
 		if (!llu->solve())
 		{
 			error_msg.append(" Linear Solver failure.");
@@ -488,60 +489,43 @@ bool Lajaunie_Approach::append_greedy_input(Basic_input &input)
 
 bool Lajaunie_Approach::convert_modified_kernel_to_rbf_kernel()
 {
-	// prep for linear prob...
-	// set the constraints...
-	// for Lajaunie and Stratigraphic Surface methods we don't update the itrface[].level()'s
-	// we update the _increment_pairs[][] level()'s
-	for (int j = 0; j < (int)_increment_pairs->size(); j++ ){
-		eval_scalar_interpolant_at_point(_increment_pairs->at(j)[0]);
-		eval_scalar_interpolant_at_point(_increment_pairs->at(j)[1]);
-		_increment_pairs->at(j)[0].setLevel(_increment_pairs->at(j)[0].scalar_field());
-		_increment_pairs->at(j)[1].setLevel(_increment_pairs->at(j)[1].scalar_field());
-	}
-
-	for (int j = 0; j < b_input.planar->size(); j++ ){
-		eval_vector_interpolant_at_point(b_input.planar->at(j));
-		// debug
-		// 		cout<<" Planar["<<j<<"]: "<<endl;
-		// 		cout<<"	Nx = "<<b_input.planar->at(j).nx()<<" Nx interpolated = "<<b_input.planar->at(j).nx_interp()<<endl;
-		// 		cout<<"	Ny = "<<b_input.planar->at(j).ny()<<" Ny interpolated = "<<b_input.planar->at(j).ny_interp()<<endl;
-		// 		cout<<"	Nz = "<<b_input.planar->at(j).nz()<<" Nz interpolated = "<<b_input.planar->at(j).nz_interp()<<endl;
-		double normal[3] = {b_input.planar->at(j).nx_interp(),b_input.planar->at(j).ny_interp(),b_input.planar->at(j).nz_interp()};
-		b_input.planar->at(j).setNormal(normal[0],normal[1],normal[2]);
-	}
-	for (int j = 0; j < b_input.tangent->size(); j++ ){
-		eval_vector_interpolant_at_point(b_input.tangent->at(j));
-		// 		cout<<" Tangent["<<j<<"]: "<<endl;
-		// 		cout<<"	Tx = "<<b_input.tangent->at(j).tx()<<" Nx interpolated = "<<b_input.tangent->at(j).nx_interp()<<endl;
-		// 		cout<<"	Ty = "<<b_input.tangent->at(j).ty()<<" Ny interpolated = "<<b_input.tangent->at(j).ny_interp()<<endl;
-		// 		cout<<"	Tz = "<<b_input.tangent->at(j).tz()<<" Nz interpolated = "<<b_input.tangent->at(j).nz_interp()<<endl;
-		// 		cout<<" Tx*nx + Ty*ny + Tz*nz = "<<b_input.tangent->at(j).tx()*b_input.tangent->at(j).nx_interp() + b_input.tangent->at(j).ty()*b_input.tangent->at(j).ny_interp() +
-		// 			b_input.tangent->at(j).tz()*b_input.tangent->at(j).nz_interp()<<endl;
-		double vf[3] = {b_input.tangent->at(j).nx_interp(),b_input.tangent->at(j).ny_interp(),b_input.tangent->at(j).nz_interp()};
-		double inner_product = vf[0]*b_input.tangent->at(j).tx() + vf[1]*b_input.tangent->at(j).ty() + vf[2]*b_input.tangent->at(j).tz();
-		b_input.tangent->at(j).setInnerProductConstraint(inner_product);
-	}
+	if (rbf_kernel == NULL || kernel == NULL) return false;
+
+	std::vector<Interface> centers;
+	VectorXd center_weights;
+	VectorXd poly_weights;
+	if (!_expand_modified_kernel(centers, center_weights, poly_weights)) return false;
+
+	// increments and gradients vanish on constants, so the center weights sum to zero and the centers
+	// are added as the increment pairs (x_j, x_0)
+	int n_ip = _n_increment_pair;
+	int n_c = b_parameters.n_constraints;
+	VectorXd weights(n_c + 3 + 4);
+	weights.head(n_ip) = solver->weights.head(n_ip);
+	for (int j = 1; j < 4; j++ ){
+		std::vector<Interface> pair;
+		pair.push_back(centers[j]);
+		pair.push_back(centers[0]);
+		_increment_pairs->push_back(pair);
+		weights(n_ip + j - 1) = center_weights(j);
+	}
+	weights.segment(n_ip + 3, n_c - n_ip) = solver->weights.segment(n_ip, n_c - n_ip);
+	weights.tail(4) = poly_weights;
 
 	// switch from modified kernel to normal rbf kernel
 	kernel = rbf_kernel;
+	delete p_basis;
+	p_basis = new Poly_First;
 
+	_n_increment_pair += 3;
 	if (m_parameters.use_restricted_range) b_parameters.restricted_range = false;
+	b_parameters.n_constraints = _n_increment_pair + 3*b_parameters.n_planar + b_parameters.n_tangent;
 	b_parameters.n_equality = _n_increment_pair + 3*b_parameters.n_planar + b_parameters.n_tangent;
 	b_parameters.poly_term = true;
-	b_parameters.n_poly_terms = 3;
+	b_parameters.n_poly_terms = 4;
 	b_parameters.modified_basis = false;
 	b_parameters.problem_type = Parameter_Types::Linear;
-	int n_e = b_parameters.n_equality;
-	int n_p = b_parameters.n_poly_terms;
-	VectorXd equality_values(n_e + n_p);
-	get_equality_values(equality_values);
-
-	MatrixXd interpolation_matrix(n_e + n_p, n_e + n_p);
-	if (!get_interpolation_matrix(interpolation_matrix)) return false;
-
-	Linear_LU_decomposition *llu = new Linear_LU_decomposition(interpolation_matrix,equality_values);
-	if (!llu->solve()) return false;
-	solver = llu;
+	solver->weights = weights;
 
 	if (!_update_interface_iso_values()) return false;
 
@@ -775,6 +759,38 @@ void Lajaunie_Approach::eval_scalar_interpolant_at_point( Point &p )
 	delete kernel_j;
 }
 
+Tiled_Evaluator *Lajaunie_Approach::get_tiled_evaluator()
+{
+	Tiled_Evaluator *evaluator = _new_tiled_evaluator();
+	if (evaluator == NULL) return NULL;
+
+	int n_ip = _n_increment_pair;
+	int n_p = b_parameters.n_planar;
+	int n_t = b_parameters.n_tangent;
+
+	// an increment pair is the difference of two point centers
+	for (int k = 0; k < (int)_increment_pairs->size(); k++ ){
+		evaluator->add_point_center(_increment_pairs->at(k)[0], solver->weights[k]);
+		evaluator->add_point_center(_increment_pairs->at(k)[1], -solver->weights[k]);
+	}
+	for (int k = 0; k < n_p; k++ ){
+		evaluator->add_derivative_center(b_input.planar->at(k), 1.0, 0.0, 0.0, solver->weights[n_ip + 3*k]);
+		evaluator->add_derivative_center(b_input.planar->at(k), 0.0, 1.0, 0.0, solver->weights[n_ip + 3*k + 1]);
+		evaluator->add_derivative_center(b_input.planar->at(k), 0.0, 0.0, 1.0, solver->weights[n_ip + 3*k + 2]);
+	}
+	for (int k = 0; k < n_t; k++ ){
+		Tangent &t = b_input.tangent->at(k);
+		evaluator->add_derivative_center(t, t.tx(), t.ty(), t.tz(), solver->weights[n_ip + 3*n_p + k]);
+	}
+	if (b_parameters.poly_term)
+	{
+		int n_c = n_ip + 3*n_p + n_t;
+		evaluator->set_polynomial(p_basis, solver->weights.tail(solver->weights.size() - n_c));
+	}
+	evaluator->pack();
+	return evaluator;
+}
+
 void Lajaunie_Approach::eval_vector_interpolant_at_point( Point &p )
 {
 	int n_ip = _n_increment_pair;
@@ -796,37 +812,37 @@ void Lajaunie_Approach::eval_vector_interpolant_at_point( Point &p )
 	double poly_z = 0.0;
 	// interface constraints
 	for (int k = 0; k < n_ip;k++ ){
-		kernel->set_points(p, _increment_pairs->at(k)[0]);
-		double v1x = kernel->basis_planar_x_pt();
-		double v1y = kernel->basis_planar_y_pt();
-		double v1z = kernel->basis_planar_z_pt();
-		kernel->set_points(p, _increment_pairs->at(k)[1]);
-		double v2x = kernel->basis_planar_x_pt();
-		double v2y = kernel->basis_planar_y_pt();
-		double v2z = kernel->basis_planar_z_pt();
+		kernel_j->set_points(p, _increment_pairs->at(k)[0]);
+		double v1x = kernel_j->basis_planar_x_pt();
+		double v1y = kernel_j->basis_planar_y_pt();
+		double v1z = kernel_j->basis_planar_z_pt();
+		kernel_j->set_points(p, _increment_pairs->at(k)[1]);
+		double v2x = kernel_j->basis_planar_x_pt();
+		double v2y = kernel_j->basis_planar_y_pt();
+		double v2z = kernel_j->basis_planar_z_pt();
 		elemsum_1_x += solver->weights[k]*(v1x - v2x);
 		elemsum_1_y += solver->weights[k]*(v1y - v2y);
 		elemsum_1_z += solver->weights[k]*(v1z - v2z);
 	}
 	// planar constraints
 	for (int k = 0; k < n_p; k++ ){
-		kernel->set_points(p, b_input.planar->at(k));
-		elemsum_2_x += solver->weights[n_ip + 0 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DXDX);
-		elemsum_2_x += solver->weights[n_ip + 1 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DXDY);
-		elemsum_2_x += solver->weights[n_ip + 2 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DXDZ);
-		elemsum_2_y += solver->weights[n_ip + 0 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DYDX);
-		elemsum_2_y += solver->weights[n_ip + 1 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DYDY);
-		elemsum_2_y += solver->weights[n_ip + 2 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DYDZ);
-		elemsum_2_z += solver->weights[n_ip + 0 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DZDX);
-		elemsum_2_z += solver->weights[n_ip + 1 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DZDY);
-		elemsum_2_z += solver->weights[n_ip + 2 + 3*k]*kernel->basis_planar_planar(Parameter_Types::DZDZ);
+		kernel_j->set_points(p, b_input.planar->at(k));
+		elemsum_2_x += solver->weights[n_ip + 0 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DXDX);
+		elemsum_2_x += solver->weights[n_ip + 1 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DXDY);
+		elemsum_2_x += solver->weights[n_ip + 2 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DXDZ);
+		elemsum_2_y += solver->weights[n_ip + 0 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DYDX);
+		elemsum_2_y += solver->weights[n_ip + 1 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DYDY);
+		elemsum_2_y += solver->weights[n_ip + 2 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DYDZ);
+		elemsum_2_z += solver->weights[n_ip + 0 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DZDX);
+		elemsum_2_z += solver->weights[n_ip + 1 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DZDY);
+		elemsum_2_z += solver->weights[n_ip + 2 + 3*k]*kernel_j->basis_planar_planar(Parameter_Types::DZDZ);
 	}
 	// Tangent constraints
 	for (int k = 0; k < n_t; k++ ){
-		kernel->set_points(p, b_input.tangent->at(k));
-		elemsum_3_x += solver->weights[n_ip + 3*n_p + k]*kernel->basis_planar_tangent(Parameter_Types::DX);
-		elemsum_3_y += solver->weights[n_ip + 3*n_p + k]*kernel->basis_planar_tangent(Parameter_Types::DY);
-		elemsum_3_z += solver->weights[n_ip + 3*n_p + k]*kernel->basis_planar_tangent(Parameter_Types::DZ);
+		kernel_j->set_points(p, b_input.tangent->at(k));
+		elemsum_3_x += solver->weights[n_ip + 3*n_p + k]*kernel_j->basis_planar_tangent(Parameter_Types::DX);
+		elemsum_3_y += solver->weights[n_ip + 3*n_p + k]*kernel_j->basis_planar_tangent(Parameter_Types::DY);
+		elemsum_3_z += solver->weights[n_ip + 3*n_p + k]*kernel_j->basis_planar_tangent(Parameter_Types::DZ);
 	}
 	if (b_parameters.poly_term)
 	{
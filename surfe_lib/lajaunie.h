@@ -63,6 +63,7 @@ public:
 	bool measure_residuals(Basic_input &input);
 	bool append_greedy_input(Basic_input &input);
 	bool convert_modified_kernel_to_rbf_kernel();
+	Tiled_Evaluator *get_tiled_evaluator();
 	GRBF_Modelling_Methods *clone() { return new Lajaunie_Approach(*this); }
 	// Attributes
 	Polynomial_Basis *p_basis;
@@ -37,12 +37,47 @@
 #include <iostream>
 #include <iomanip>
 #include <fstream>
+#include <cmath>
+#include <limits>
+
+VectorXd System_Solver::_map_vector(const VectorXd &previous, const std::vector<int> &map, const double &default_value)
+{
+	int n = (int)map.size();
+	VectorXd v(n);
+	for (int j = 0; j < n; j++ ){
+		if (map[j] >= 0 && map[j] < (int)previous.rows()) v(j) = previous(map[j]);
+		else v(j) = default_value;
+	}
+	return v;
+}
 
 bool Linear_LU_decomposition::solve()
 {
 
 	if (_constraint_values.rows() != _interpolation_matrix.rows()) return false;
 
+	_refinement_iterations = 0;
+	if (_constraint_matrix.cols() > 1)
+	{
+		_precision_used = Double_precision;
+		weights_matrix = _interpolation_matrix.partialPivLu().solve(_constraint_matrix);
+		if (!weights_matrix.allFinite()) return false;
+		weights = weights_matrix.col(0);
+		return true;
+	}
+
+	if (_mixed_precision)
+	{
+		if (_solve_mixed_precision())
+		{
+			_precision_used = Mixed_precision;
+			std::cout << "Mixed precision LU converged after " << _refinement_iterations << " refinement iterations" << std::endl;
+			return true;
+		}
+		std::cout << "Mixed precision LU refinement stalled, using double precision LU" << std::endl;
+	}
+
+	_precision_used = Double_precision;
 	weights = _interpolation_matrix.partialPivLu().solve(_constraint_values);
 
 	if ( !weights.allFinite()) return false; 
@@ -50,6 +85,53 @@ bool Linear_LU_decomposition::solve()
 	return true;
 }
 
+bool Linear_LU_decomposition::_solve_mixed_precision()
+{
+	// float32 factorization, residuals in double. Converges to double accuracy when
+	// cond(A)*eps_float < 1, otherwise the residual stops decreasing and we give up.
+	int n = (int)_interpolation_matrix.rows();
+	if (n == 0) return false;
+
+	MatrixXf matrix_f = _interpolation_matrix.cast<float>();
+	if (!matrix_f.allFinite()) return false;
+	PartialPivLU<MatrixXf> lu(matrix_f);
+
+	VectorXd x = lu.solve(_constraint_values.cast<float>()).cast<double>();
+	if (!x.allFinite()) return false;
+
+	double matrix_norm = _interpolation_matrix.cwiseAbs().rowwise().sum().maxCoeff(); // inf norm
+	double b_norm = _constraint_values.lpNorm<Infinity>();
+	double tolerance = std::sqrt((double)n)*std::numeric_limits<double>::epsilon();
+	double previous_error = std::numeric_limits<double>::infinity();
+	const int max_iterations = 30;
+
+	for (int j = 0; j < max_iterations; j++)
+	{
+		VectorXd residual = _constraint_values - _interpolation_matrix*x;
+		double residual_norm = residual.lpNorm<Infinity>();
+		// normwise backward error
+		double denominator = matrix_norm*x.lpNorm<Infinity>() + b_norm;
+		double backward_error = denominator > 0 ? residual_norm/denominator : residual_norm;
+		if (!(backward_error == backward_error)) return false;
+		if (backward_error <= tolerance)
+		{
+			weights = x;
+			return true;
+		}
+		// each step should gain at least a factor of 2, otherwise conditioning is too poor for float
+		if (backward_error > 0.5*previous_error) return false;
+		previous_error = backward_error;
+
+		// scale the residual before the cast so small corrections do not underflow in float
+		VectorXd correction = lu.solve((residual/residual_norm).cast<float>()).cast<double>()*residual_norm;
+		if (!correction.allFinite()) return false;
+		x += correction;
+		_refinement_iterations++;
+	}
+
+	return false;
+}
+
 bool Linear_LU_decomposition::validate_matrix_systems()
 {
 	// check if there are any NaN or INF values
@@ -66,71 +148,551 @@ bool Linear_LU_decomposition::check_solution()
 	return true;
 }
 
-Matrix <mpf_class, Dynamic, Dynamic> Quadratic_Predictor_Corrector::_convert_double_matrix_2_mpf(const MatrixXd &matrix)
+bool Linear_Cholesky_decomposition::solve()
+{
+	if (_constraint_values.rows() != _interpolation_matrix.rows()) return false;
+
+	LLT<MatrixXd> llt(_interpolation_matrix);
+	if (llt.info() == Success)
+	{
+		weights = llt.solve(_constraint_values);
+		if (weights.allFinite()) return true;
+	}
+
+	cout<<" Cholesky factorization failed (matrix not positive definite), using LU"<<endl;
+	weights = _interpolation_matrix.partialPivLu().solve(_constraint_values);
+	if (!weights.allFinite()) return false;
+
+	return true;
+}
+
+bool Linear_Cholesky_decomposition::validate_matrix_systems()
+{
+	if (_interpolation_matrix.allFinite()) return true;
+	else return false;
+}
+
+bool Linear_Krylov_Solver::solve()
+{
+	if (_constraint_values.rows() != _interpolation_matrix.rows()) return false;
+
+	int n = (int)_interpolation_matrix.rows();
+	int max_iterations = std::max(100, n/5);
+	double tolerance = 1e-12;
+	ComputationInfo info;
+	if (_symmetric_definite)
+	{
+		ConjugateGradient<MatrixXd, Lower|Upper, DiagonalPreconditioner<double> > cg;
+		cg.setTolerance(tolerance);
+		cg.setMaxIterations(max_iterations);
+		cg.compute(_interpolation_matrix);
+		weights = cg.solve(_constraint_values);
+		info = cg.info();
+		_iterations = (int)cg.iterations();
+	}
+	else
+	{
+		BiCGSTAB<MatrixXd, DiagonalPreconditioner<double> > bicgstab;
+		bicgstab.setTolerance(tolerance);
+		bicgstab.setMaxIterations(max_iterations);
+		bicgstab.compute(_interpolation_matrix);
+		weights = bicgstab.solve(_constraint_values);
+		info = bicgstab.info();
+		_iterations = (int)bicgstab.iterations();
+	}
+
+	if (info == Success && weights.allFinite())
+	{
+		cout<<" Krylov solver converged in "<<_iterations<<" iterations"<<endl;
+		return true;
+	}
+
+	cout<<" Krylov solver did not converge in "<<_iterations<<" iterations, using LU"<<endl;
+	weights = _interpolation_matrix.partialPivLu().solve(_constraint_values);
+	if (!weights.allFinite()) return false;
+
+	return true;
+}
+
+bool Linear_Krylov_Solver::validate_matrix_systems()
+{
+	if (_interpolation_matrix.allFinite()) return true;
+	else return false;
+}
+
+const double Linear_Sparse_LU::drop_tolerance = 1e-14;
+
+bool Linear_Sparse_LU::solve()
+{
+	if (_constraint_values.rows() != _interpolation_matrix.rows()) return false;
+
+	double max_element = _interpolation_matrix.cwiseAbs().maxCoeff();
+	SparseMatrix<double> sparse_matrix = _interpolation_matrix.sparseView(max_element, drop_tolerance);
+	sparse_matrix.makeCompressed();
+
+	SparseLU<SparseMatrix<double>, COLAMDOrdering<int> > lu;
+	lu.analyzePattern(sparse_matrix);
+	lu.factorize(sparse_matrix);
+	if (lu.info() == Success)
+	{
+		weights = lu.solve(_constraint_values);
+		// the dropped entries must not matter for the full system
+		if (weights.allFinite() &&
+			(_interpolation_matrix*weights - _constraint_values).norm() <= 1e-8*_constraint_values.norm()) return true;
+	}
+
+	cout<<" Sparse LU failed, using dense LU"<<endl;
+	weights = _interpolation_matrix.partialPivLu().solve(_constraint_values);
+	if (!weights.allFinite()) return false;
+
+	return true;
+}
+
+bool Linear_Sparse_LU::validate_matrix_systems()
+{
+	if (_interpolation_matrix.allFinite()) return true;
+	else return false;
+}
+
+const double Linear_Updatable_Solver::refactor_tolerance = 1e-9;
+
+MatrixXd Linear_Updatable_Solver::_select(const MatrixXd &matrix, const std::vector<int> &rows, const std::vector<int> &cols)
+{
+	MatrixXd selection((int)rows.size(), (int)cols.size());
+	for (int k = 0; k < (int)cols.size(); k++ ){
+		for (int j = 0; j < (int)rows.size(); j++ ) selection(j,k) = matrix(rows[j],cols[k]);
+	}
+	return selection;
+}
+
+bool Linear_Updatable_Solver::refactor()
+{
+	_updates = 0;
+	_factorizations++;
+	if (_interpolation_matrix.rows() == 0)
+	{
+		_inverse.resize(0,0);
+		return true;
+	}
+	PartialPivLU<MatrixXd> lu(_interpolation_matrix);
+	_inverse = lu.inverse();
+	if (!_inverse.allFinite())
+	{
+		_inverse.resize(0,0);
+		return false;
+	}
+	return true;
+}
+
+bool Linear_Updatable_Solver::solve()
+{
+	if (!validate_matrix_systems()) return false;
+	if (_inverse.rows() != _interpolation_matrix.rows() && !refactor()) return false;
+
+	double matrix_norm = _interpolation_matrix.norm();
+	double b_norm = _constraint_values.norm();
+	for (int attempt = 0; attempt < 2; attempt++ ){
+		// one step of iterative refinement against the stored matrix
+		weights = _inverse*_constraint_values;
+		weights += _inverse*(_constraint_values - _interpolation_matrix*weights);
+		// normwise backward error
+		double scale = matrix_norm*weights.norm() + b_norm;
+		double residual = scale > 0.0 ? (_constraint_values - _interpolation_matrix*weights).norm()/scale : 0.0;
+		if (weights.allFinite() && residual <= refactor_tolerance) return true;
+		// accuracy lost in the updates (or an ill conditioned system): start again from a factorization
+		if (attempt == 0 && _updates > 0)
+		{
+			cout<<" Updated inverse lost accuracy after "<<_updates<<" updates (residual = "<<residual<<"), refactoring"<<endl;
+			if (!refactor()) return false;
+		}
+		else return weights.allFinite();
+	}
+	return weights.allFinite();
+}
+
+bool Linear_Updatable_Solver::validate_matrix_systems()
+{
+	if (_interpolation_matrix.rows() != _interpolation_matrix.cols()) return false;
+	if (_constraint_values.rows() != _interpolation_matrix.rows()) return false;
+	if (_interpolation_matrix.allFinite()) return true;
+	else return false;
+}
+
+bool Linear_Updatable_Solver::append_constraints(const MatrixXd &columns, const MatrixXd &rows, const VectorXd &values)
+{
+	int n = size();
+	int k = (int)columns.cols();
+	if (k == 0) return true;
+	if (columns.rows() != n + k || rows.rows() != k || rows.cols() != n + k || values.rows() != k) return false;
+	if (_inverse.rows() != n && !refactor()) return false;
+
+	// | A B |-1   | A-1 + W S-1 V   -W S-1 |
+	// | C D |   = |    -S-1 V        S-1   |,  W = A-1 B, V = C A-1, S = D - C A-1 B
+	MatrixXd B = columns.topRows(n);
+	MatrixXd C = rows.leftCols(n);
+	MatrixXd W = _inverse*B;
+	MatrixXd V = C*_inverse;
+	MatrixXd S = columns.bottomRows(k) - C*W;
+	PartialPivLU<MatrixXd> s_lu(S);
+	// a (numerically) singular Schur complement means the new constraints depend on the current ones
+	if (!(s_lu.rcond() > std::numeric_limits<double>::epsilon())) return false;
+	MatrixXd S_inverse = s_lu.inverse();
+	MatrixXd W_S = W*S_inverse;
+
+	MatrixXd inverse(n + k, n + k);
+	inverse.topLeftCorner(n, n) = _inverse + W_S*V;
+	inverse.topRightCorner(n, k) = -W_S;
+	inverse.bottomLeftCorner(k, n) = -S_inverse*V;
+	inverse.bottomRightCorner(k, k) = S_inverse;
+	if (!inverse.allFinite()) return false;
+	_inverse.swap(inverse);
+
+	MatrixXd matrix(n + k, n + k);
+	matrix.topLeftCorner(n, n) = _interpolation_matrix;
+	matrix.rightCols(k) = columns;
+	matrix.bottomLeftCorner(k, n) = C;
+	_interpolation_matrix.swap(matrix);
+
+	VectorXd vector(n + k);
+	vector << _constraint_values, values;
+	_constraint_values.swap(vector);
+
+	_updates++;
+	return true;
+}
+
+bool Linear_Updatable_Solver::remove_constraints(const std::vector<int> &indices)
 {
-	int nrows = (int)matrix.rows();
-	int ncols = (int)matrix.cols();
+	int n = size();
+	if (indices.empty()) return true;
+	std::vector<bool> removed(n, false);
+	for (int j = 0; j < (int)indices.size(); j++ ){
+		if (indices[j] < 0 || indices[j] >= n) return false;
+		removed[indices[j]] = true;
+	}
+	std::vector<int> kept;
+	std::vector<int> gone;
+	for (int j = 0; j < n; j++ ){
+		if (removed[j]) gone.push_back(j);
+		else kept.push_back(j);
+	}
+	if (_inverse.rows() != n && !refactor()) return false;
+
+	// with the inverse partitioned as | E F | (kept, removed), the inverse of the kept block is E - F H-1 G
+	//                                 | G H |
+	MatrixXd H = _select(_inverse, gone, gone);
+	PartialPivLU<MatrixXd> h_lu(H);
+	if (!(h_lu.rcond() > std::numeric_limits<double>::epsilon())) return false;
+	MatrixXd inverse = _select(_inverse, kept, kept) - _select(_inverse, kept, gone)*h_lu.solve(_select(_inverse, gone, kept));
+	if (!inverse.allFinite()) return false;
+	_inverse.swap(inverse);
+
+	MatrixXd matrix = _select(_interpolation_matrix, kept, kept);
+	_interpolation_matrix.swap(matrix);
+	VectorXd vector((int)kept.size());
+	for (int j = 0; j < (int)kept.size(); j++ ) vector(j) = _constraint_values(kept[j]);
+	_constraint_values.swap(vector);
+
+	_updates++;
+	return true;
+}
 
-	Matrix <mpf_class, Dynamic, Dynamic> mpf_matrix(nrows, ncols);
+bool Linear_Updatable_Solver::update(const MatrixXd &matrix, const VectorXd &vector, const std::vector<int> &map)
+{
+	int n = size();
+	int m = (int)map.size();
+	if (matrix.rows() != m || matrix.cols() != m || vector.rows() != m) return false;
+
+	// new index of each current constraint and the new constraints
+	std::vector<int> position(n, -1);
+	std::vector<int> appended;
+	for (int j = 0; j < m; j++ ){
+		if (map[j] < 0) appended.push_back(j);
+		else
+		{
+			if (map[j] >= n || position[map[j]] != -1) return false;
+			position[map[j]] = j;
+		}
+	}
+	std::vector<int> removed;
+	std::vector<int> order; // order[i]: new index of constraint i of the updated system before reordering
+	for (int j = 0; j < n; j++ ){
+		if (position[j] < 0) removed.push_back(j);
+		else order.push_back(position[j]);
+	}
+	// too many changes: a new factorization is cheaper than the updates
+	if ((int)(removed.size() + appended.size()) > m/3)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+		return refactor();
+	}
 
-	for (int j = 0; j < nrows; j++ ){
-		for (int k = 0; k < ncols; k++ ){
-			mpf_matrix(j,k) = matrix(j,k);
+	bool updated = remove_constraints(removed);
+	if (updated && !appended.empty())
+	{
+		int n_kept = (int)order.size();
+		int k = (int)appended.size();
+		order.insert(order.end(), appended.begin(), appended.end());
+		MatrixXd columns(n_kept + k, k);
+		MatrixXd rows(k, n_kept + k);
+		VectorXd values(k);
+		for (int t = 0; t < k; t++ ){
+			for (int j = 0; j < n_kept + k; j++ ){
+				columns(j,t) = matrix(order[j],appended[t]);
+				rows(t,j) = matrix(appended[t],order[j]);
+			}
+			values(t) = vector(appended[t]);
 		}
+		updated = append_constraints(columns, rows, values);
+	}
+	if (!updated)
+	{
+		// singular intermediate system: factor the new one directly
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+		return refactor();
 	}
 
-	return mpf_matrix;
+	// permute to the new constraint order: P A PT has inverse P A-1 PT
+	std::vector<int> source(m);
+	for (int j = 0; j < m; j++ ) source[order[j]] = j;
+	MatrixXd inverse = _select(_inverse, source, source);
+	_inverse.swap(inverse);
+	_interpolation_matrix = matrix;
+	_constraint_values = vector;
+
+	return true;
 }
 
-Matrix <mpf_class, Dynamic, 1> Quadratic_Predictor_Corrector::_convert_double_vector_2_mpf(const VectorXd &vector)
+bool Linear_Least_Squares::solve()
 {
-	int nrows = (int)vector.rows();
-	Matrix <mpf_class, Dynamic, 1>  mpf_vector(nrows);
+	if (!validate_matrix_systems()) return false;
+
+	int n = (int)_design_matrix.rows();
+	int m = (int)_design_matrix.cols();
+	int n_r = std::min(std::max(_n_regularized, 0), m);
+
+	// null space of the side conditions: w = Z y satisfies C w = 0 for any y
+	MatrixXd null_space = MatrixXd::Identity(m, m);
+	if (_side_conditions.rows() > 0)
+	{
+		ColPivHouseholderQR<MatrixXd> side_qr(_side_conditions.transpose());
+		int rank = (int)side_qr.rank();
+		if (rank >= m) return false;
+		MatrixXd q = side_qr.householderQ();
+		null_space = q.rightCols(m - rank);
+	}
+	int m_free = (int)null_space.cols();
+
+	// | A Z             |       | b |
+	// | sqrt(lambda) Z_r| y  =  | 0 |
+	double lambda = m > 0 ? _regularization*_design_matrix.squaredNorm()/m : 0.0;
+	MatrixXd system(n + n_r, m_free);
+	system.topRows(n) = _design_matrix*null_space;
+	system.bottomRows(n_r) = std::sqrt(lambda)*null_space.topRows(n_r);
+	VectorXd rhs = VectorXd::Zero(n + n_r);
+	rhs.head(n) = _constraint_values;
+
+	ColPivHouseholderQR<MatrixXd> qr(system);
+	VectorXd y = qr.solve(rhs);
+	weights = null_space*y;
+	if (!weights.allFinite()) return false;
+
+	_rms_residual = n > 0 ? (_design_matrix*weights - _constraint_values).norm()/std::sqrt((double)n) : 0.0;
+	return true;
+}
 
-	for (int j = 0; j < nrows ; j++ ) mpf_vector(j) = vector(j);
-	return mpf_vector;
+bool Linear_Least_Squares::validate_matrix_systems()
+{
+	if (_constraint_values.rows() != _design_matrix.rows()) return false;
+	if (_design_matrix.rows() < _design_matrix.cols()) return false;
+	if (_side_conditions.rows() > 0 && _side_conditions.cols() != _design_matrix.cols()) return false;
+	if (_design_matrix.allFinite() && _side_conditions.allFinite()) return true;
+	else return false;
 }
 
-VectorXd Quadratic_Predictor_Corrector::_convert_mpf_vector_2_double(const Matrix <mpf_class, Dynamic, 1> &vector)
+bool Linear_Solver_Selector::is_definite_kernel(const model_parameters &m_parameters, const basic_parameters &b_parameters)
 {
-	int nrows = (int)vector.rows();
-	VectorXd v(nrows);
+	// polynomial side conditions make the system a saddle point problem (indefinite)
+	if (b_parameters.poly_term && b_parameters.n_poly_terms != 0) return false;
+	// the modified kernel is positive definite by construction
+	if (b_parameters.modified_basis) return true;
+	if (m_parameters.basis_type == Parameter_Types::Gaussian || m_parameters.basis_type == Parameter_Types::IMQ) return true;
+	return false;
+}
 
-	for (int j = 0; j < nrows; j++ ) v(j) = vector(j).get_d();
-	return v;
+double Linear_Solver_Selector::_predicted_gflops(const Linear_System_Estimate &estimate, const Parameter_Types::LinearSolver &type)
+{
+	double n = (double)estimate.n;
+	double flops = 0.0;
+	switch (type)
+	{
+	case Parameter_Types::Dense_Cholesky:
+		flops = n*n*n/3.0;
+		break;
+	case Parameter_Types::Iterative_Krylov:
+	{
+		// one (CG) or two (BiCGSTAB) dense matrix vector products per iteration
+		double matvecs = (estimate.symmetric && estimate.definite_kernel) ? 1.0 : 2.0;
+		flops = estimate.krylov_iterations*matvecs*2.0*n*n;
+		break;
+	}
+	case Parameter_Types::Sparse_LU:
+	{
+		// banded LU model: bandwidth taken as the average # of non zeros per row
+		double bandwidth = estimate.density*n;
+		flops = 2.0*n*bandwidth*bandwidth;
+		break;
+	}
+	default:
+		flops = 2.0*n*n*n/3.0;
+		break;
+	}
+	return flops/1e9;
 }
 
-Matrix <mpf_class, Dynamic, Dynamic> Quadratic_Predictor_Corrector::_get_hessian_matrix(const Matrix <mpf_class, Dynamic, Dynamic> &matrix)
+Linear_System_Estimate Linear_Solver_Selector::estimate(const MatrixXd &matrix, const bool &definite_kernel)
 {
-	int nrows = (int)matrix.rows();
-	int ncols = (int)matrix.cols();
-	Matrix <mpf_class, Dynamic, Dynamic> hessian(nrows, ncols);
+	Linear_System_Estimate estimate;
+	int n = (int)matrix.rows();
+	estimate.n = n;
+	estimate.memory_mb = 8.0*(double)n*(double)n/1048576.0;
+	estimate.definite_kernel = definite_kernel;
+	if (n == 0) return estimate;
+
+	double max_element = matrix.cwiseAbs().maxCoeff();
+	double symmetry_tolerance = 1e-10*max_element;
+	double drop = Linear_Sparse_LU::drop_tolerance*max_element;
+
+	// one pass: symmetry and density
+	bool symmetric = true;
+	double n_nonzero = 0.0;
+	for (int k = 0; k < n; k++ ){
+		for (int j = 0; j < n; j++ ){
+			if (std::fabs(matrix(j,k)) > drop) n_nonzero += 1.0;
+			if (symmetric && j > k && std::fabs(matrix(j,k) - matrix(k,j)) > symmetry_tolerance) symmetric = false;
+		}
+	}
+	estimate.symmetric = symmetric;
+	estimate.density = n_nonzero/((double)n*(double)n);
+
+	// 1-norm condition (Hager/Higham estimate of ||S^-1||_1 from the LU factors) of the principal sub-block S on evenly
+	// spaced rows and columns. For a symmetric definite matrix this is a lower bound of the condition of the whole matrix
+	// (eigenvalue interlacing), for RBF matrices often orders of magnitude below it as the sampled centers are further apart
+	int m = std::min(n, sample_size);
+	MatrixXd sample(m, m);
+	for (int k = 0; k < m; k++ )
+		for (int j = 0; j < m; j++ ) sample(j,k) = matrix((int)((long long)j*n/m), (int)((long long)k*n/m));
+	PartialPivLU<MatrixXd> sample_lu(sample);
+	double rcond = sample_lu.rcond();
+	if (rcond > 0.0) estimate.condition_estimate = 1.0/rcond;
+	else estimate.condition_estimate = std::numeric_limits<double>::infinity();
+
+	// Krylov iterations to reduce the residual by 1e-12, optimistic with the lower bound: 0.5*sqrt(cond)*ln(2/1e-12) (CG bound)
+	if (estimate.condition_estimate < std::numeric_limits<double>::infinity())
+		estimate.krylov_iterations = std::min(n, (int)std::ceil(0.5*std::sqrt(estimate.condition_estimate)*std::log(2e12)));
+	else estimate.krylov_iterations = n;
+
+	// automatic choice: the cheapest applicable solver. Sparse solvers are only worth their risk on larger systems.
+	// Krylov is left to an explicit m_parameters.linear_solver, the lower bound above can not tell its iteration count
+	estimate.choice = Parameter_Types::Dense_LU;
+	if (symmetric && definite_kernel) estimate.choice = Parameter_Types::Dense_Cholesky;
+	if (n >= 1000)
+	{
+		double best = _predicted_gflops(estimate, estimate.choice);
+		if (estimate.density <= 0.1 && _predicted_gflops(estimate, Parameter_Types::Sparse_LU) < best)
+		{
+			estimate.choice = Parameter_Types::Sparse_LU;
+		}
+	}
+	estimate.predicted_gflops = _predicted_gflops(estimate, estimate.choice);
+
+	return estimate;
+}
 
-	hessian = 2.0*matrix;
+System_Solver *Linear_Solver_Selector::create(const MatrixXd &matrix, const VectorXd &vector, const model_parameters &m_parameters, const basic_parameters &b_parameters)
+{
+	Linear_System_Estimate e = estimate(matrix, is_definite_kernel(m_parameters, b_parameters));
+	if (m_parameters.linear_solver != Parameter_Types::Automatic_selection)
+	{
+		e.choice = m_parameters.linear_solver;
+		e.predicted_gflops = _predicted_gflops(e, e.choice);
+	}
 
-	return hessian;
+	const char *names[] = {"dense LU","dense Cholesky","Krylov","sparse LU"};
+	cout<<" Linear solver: "<<names[e.choice]<<(m_parameters.linear_solver == Parameter_Types::Automatic_selection ? " (automatic)" : "")
+		<<", n = "<<e.n<<", memory = "<<e.memory_mb<<" MB, density = "<<e.density
+		<<", "<<(e.symmetric ? "symmetric" : "non-symmetric")<<(e.definite_kernel ? " definite" : "")
+		<<", condition lower bound = "<<e.condition_estimate<<", predicted cost = "<<e.predicted_gflops<<" GFLOP"<<endl;
+
+	switch (e.choice)
+	{
+	case Parameter_Types::Dense_Cholesky:
+		return new Linear_Cholesky_decomposition(matrix, vector);
+	case Parameter_Types::Iterative_Krylov:
+		return new Linear_Krylov_Solver(matrix, vector, e.symmetric && e.definite_kernel);
+	case Parameter_Types::Sparse_LU:
+		return new Linear_Sparse_LU(matrix, vector);
+	default:
+		return new Linear_LU_decomposition(matrix, vector, m_parameters.use_mixed_precision);
+	}
 }
 
 bool Quadratic_Predictor_Corrector::solve()
 {
 	int n = (int)_hessian_matrixD.rows();
 
-	//Matrix <mpf_class, Dynamic, 1> fvalues(n);
 	Matrix <double, Dynamic, 1> fvalues(n);
 
 	//if (!validate_matrix_systems()) return false;
 
-	//if (!Math_methods::quadratic_solver(_hessian_matrix,_equality_matrix,_inequality_matrix,_equality_vector,_inequality_vector,fvalues)) return false;
-
-	if (!Math_methods::quadratic_solver(_hessian_matrixD,_equality_matrixD,_inequality_matrixD,_equality_vectorD,_inequality_vectorD,fvalues)) return false;
+	if (_warm_start)
+	{
+		if (Math_methods::quadratic_solver(_hessian_matrixD,_equality_matrixD,_inequality_matrixD,_equality_vectorD,_inequality_vectorD,fvalues,_iterate,true,
+			_qp_parameters,_qp_result))
+		{
+			weights = fvalues;
+			return true;
+		}
+		// warm start failed, start again from the default starting point
+		_warm_start = false;
+	}
 
-	//weights = _convert_mpf_vector_2_double(fvalues);
+	if (!Math_methods::quadratic_solver(_hessian_matrixD,_equality_matrixD,_inequality_matrixD,_equality_vectorD,_inequality_vectorD,fvalues,_iterate,false,
+		_qp_parameters,_qp_result))
+	{
+		cout<<" "<<_qp_result.message<<endl;
+		return false;
+	}
+	if (_qp_result.status != QP_Result::Converged) cout<<" "<<_qp_result.message<<endl;
+	_cold_iterations = _iterate.iterations;
 
 	weights = fvalues;
 
 	return true;
 }
 
+bool Quadratic_Predictor_Corrector::set_warm_start(const Quadratic_Predictor_Corrector &previous, const std::vector<int> &variable_map,
+	const std::vector<int> &equality_map, const std::vector<int> &inequality_map)
+{
+	const QP_Iterate<double> &last = previous.get_iterate();
+	if (last.x.rows() == 0) return false; // previous solve did not succeed
+	if ((int)variable_map.size() != (int)_hessian_matrixD.rows() ||
+		(int)equality_map.size() != (int)_equality_matrixD.rows() ||
+		(int)inequality_map.size() != (int)_inequality_matrixD.rows()) return false;
+
+	// new multipliers and slacks are set to zero and are moved into the interior by the solver
+	_iterate.x = _map_vector(last.x,variable_map,0.0);
+	_iterate.y = _map_vector(last.y,equality_map,0.0);
+	_iterate.z = _map_vector(last.z,inequality_map,0.0);
+	_iterate.s = _map_vector(last.s,inequality_map,0.0);
+	_cold_iterations = previous._cold_iterations;
+	_warm_start = true;
+
+	return true;
+}
+
 bool Quadratic_Predictor_Corrector::validate_matrix_systems()
 {
 	if (!_interpolation_matrixD.allFinite()) return false;
@@ -141,18 +703,80 @@ bool Quadratic_Predictor_Corrector::validate_matrix_systems()
 	return true;
 }
 
+bool Quadratic_Active_Set::solve()
+{
+	int n = (int)_hessian_matrix.rows();
+
+	VectorXd fvalues(n);
+	if (!Math_methods::quadratic_solver_active_set(_hessian_matrix,_equality_matrix,_inequality_matrix,_equality_vector,_inequality_vector,fvalues)) return false;
+
+	weights = fvalues;
+
+	return true;
+}
+
+bool Quadratic_Active_Set::validate_matrix_systems()
+{
+	if (!_hessian_matrix.allFinite()) return false;
+
+	LLT<MatrixXd> lltofMatrix(_hessian_matrix);
+	if (lltofMatrix.info() == NumericalIssue) return false;
+
+	return true;
+}
+
 bool Quadratic_Predictor_Corrector_LOQO::solve()
 {
 	int n  = (int)_H.rows();
 
 	VectorXd w(n);
-	if (!Math_methods::quadratic_solver_loqo(_H,_A,_b,_r,w)) return false;
+	if (_warm_start)
+	{
+		if (Math_methods::quadratic_solver_loqo(_H,_A,_b,_r,w,_iterate,true,_qp_parameters,_qp_result))
+		{
+			weights = w;
+			return true;
+		}
+		// warm start failed, start again from the default starting point
+		_warm_start = false;
+	}
+
+	if (!Math_methods::quadratic_solver_loqo(_H,_A,_b,_r,w,_iterate,false,_qp_parameters,_qp_result))
+	{
+		cout<<" "<<_qp_result.message<<endl;
+		return false;
+	}
+	if (_qp_result.status != QP_Result::Converged) cout<<" "<<_qp_result.message<<endl;
+	_cold_iterations = _iterate.iterations;
 
 	weights = w;
 
 	return true;
 }
 
+bool Quadratic_Predictor_Corrector_LOQO::set_warm_start(const Quadratic_Predictor_Corrector_LOQO &previous, const std::vector<int> &map)
+{
+	const LOQO_Iterate &last = previous.get_iterate();
+	if (last.x.rows() == 0) return false; // previous solve did not succeed
+	if ((int)map.size() != (int)_H.rows() || (int)map.size() != (int)_A.rows()) return false;
+
+	// entries of new constraints are set to zero, the positive ones are moved into the interior by the solver
+	_iterate.x = _map_vector(last.x,map,0.0);
+	_iterate.y = _map_vector(last.y,map,0.0);
+	_iterate.g = _map_vector(last.g,map,0.0);
+	_iterate.z = _map_vector(last.z,map,0.0);
+	_iterate.t = _map_vector(last.t,map,0.0);
+	_iterate.s = _map_vector(last.s,map,0.0);
+	_iterate.v = _map_vector(last.v,map,0.0);
+	_iterate.w = _map_vector(last.w,map,0.0);
+	_iterate.p = _map_vector(last.p,map,0.0);
+	_iterate.q = _map_vector(last.q,map,0.0);
+	_cold_iterations = previous._cold_iterations;
+	_warm_start = true;
+
+	return true;
+}
+
 bool Quadratic_Predictor_Corrector_LOQO::validate_matrix_systems()
 {
 	if (!_H.allFinite()) return false;
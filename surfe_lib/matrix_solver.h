@@ -34,7 +34,8 @@
 #ifndef matrix_solver_h
 #define matrix_solver_h
 
-#include <gmpxx.h>
+#include <math_methods.h>
+#include <modelling_parameters.h>
 
 #include <vector>
 #include <fstream>
@@ -42,15 +43,21 @@
 #include <iostream>
 #include <iomanip>
 #include <Eigen/Core>
+#include <Eigen/Sparse>
 
 using namespace Eigen;
 using namespace std;
 
 class System_Solver {
+protected:
+	// re-index a solution vector of a previous solve: map[j] is the index in previous of entry j (-1 for new entries)
+	static VectorXd _map_vector(const VectorXd &previous, const std::vector<int> &map, const double &default_value);
 public:
 	System_Solver(){}
 	virtual ~System_Solver(){}
 	VectorXd weights;
+	// multiple right hand side solves: one column of weights per right hand side (weights is the first column)
+	MatrixXd weights_matrix;
 	virtual bool solve() = 0;
  	virtual bool validate_matrix_systems() = 0;
  	//virtual bool validate_constraint_vectors() = 0;
@@ -58,14 +65,25 @@ public:
 };
 
 class Linear_LU_decomposition : public System_Solver {
+public:
+	enum Precision {Double_precision,Mixed_precision};
 private:
 	MatrixXd _interpolation_matrix;
 	VectorXd _constraint_values;
+	MatrixXd _constraint_matrix; // several right hand sides sharing one factorization
+	// mixed precision: factor a float copy and refine against the double matrix
+	bool _mixed_precision;
+	Precision _precision_used;
+	int _refinement_iterations;
+	bool _solve_mixed_precision();
 public:
-	Linear_LU_decomposition(const MatrixXd &matrix, const VectorXd &vector)
+	Linear_LU_decomposition(const MatrixXd &matrix, const VectorXd &vector, const bool &mixed_precision = false)
 	{ 
 		_interpolation_matrix = matrix; 
 		_constraint_values = vector; 
+		_mixed_precision = mixed_precision;
+		_precision_used = Double_precision;
+		_refinement_iterations = 0;
 // 		std::ofstream file1("interpM.txt");
 // 		std::ofstream file2("consV.txt");
 // 		if (file1)
@@ -79,33 +97,198 @@ public:
 // 			file2.close();
 // 		}
 	}
-	Linear_LU_decomposition(){}
+	// one factorization for all the columns of vectors, the weights of column j are weights_matrix.col(j)
+	Linear_LU_decomposition(const MatrixXd &matrix, const MatrixXd &vectors)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_matrix = vectors;
+		if (vectors.cols() != 0) _constraint_values = vectors.col(0);
+		_mixed_precision = false;
+		_precision_used = Double_precision;
+		_refinement_iterations = 0;
+	}
+	Linear_LU_decomposition() : _mixed_precision(false), _precision_used(Double_precision), _refinement_iterations(0) {}
 	virtual ~Linear_LU_decomposition() {}
  	bool solve();
+	// which factorization produced the weights of the last solve() and how many refinement steps it took
+	Precision precision_used() const { return _precision_used; }
+	int refinement_iterations() const { return _refinement_iterations; }
  	bool validate_matrix_systems();
  	//bool validate_constraint_vectors();
  	bool check_solution();
 };
 
+// Cholesky factorization for symmetric positive definite systems (half the cost of LU).
+// Falls back to LU if the matrix turns out not to be positive definite.
+class Linear_Cholesky_decomposition : public System_Solver {
+private:
+	MatrixXd _interpolation_matrix;
+	VectorXd _constraint_values;
+public:
+	Linear_Cholesky_decomposition(const MatrixXd &matrix, const VectorXd &vector)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+	}
+	virtual ~Linear_Cholesky_decomposition() {}
+	bool solve();
+	bool validate_matrix_systems();
+};
+
+// Diagonally preconditioned Krylov solver on the dense matrix (conjugate gradient for symmetric
+// positive definite systems, BiCGSTAB otherwise). O(n^2) per iteration, so it only pays off for
+// large well conditioned systems. Falls back to LU if it does not converge.
+class Linear_Krylov_Solver : public System_Solver {
+private:
+	MatrixXd _interpolation_matrix;
+	VectorXd _constraint_values;
+	bool _symmetric_definite;
+	int _iterations;
+public:
+	Linear_Krylov_Solver(const MatrixXd &matrix, const VectorXd &vector, const bool &symmetric_definite)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+		_symmetric_definite = symmetric_definite;
+		_iterations = 0;
+	}
+	virtual ~Linear_Krylov_Solver() {}
+	bool solve();
+	bool validate_matrix_systems();
+	int iterations() const { return _iterations; }
+};
+
+// Sparse LU of the interpolation matrix with entries below drop_tolerance*max|a_ij| removed. Meant for
+// fast decaying kernels (e.g. narrow Gaussians) where most of the matrix underflows to zero.
+// Falls back to dense LU if the solution of the sparsified system does not satisfy the full system.
+class Linear_Sparse_LU : public System_Solver {
+private:
+	MatrixXd _interpolation_matrix;
+	VectorXd _constraint_values;
+public:
+	static const double drop_tolerance;
+	Linear_Sparse_LU(const MatrixXd &matrix, const VectorXd &vector)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+	}
+	virtual ~Linear_Sparse_LU() {}
+	bool solve();
+	bool validate_matrix_systems();
+};
+
+// Linear system that can gain and lose constraints without being refactored. The inverse of the matrix is
+// kept explicitly and updated with block (Schur complement) formulas: appending or removing k constraints
+// costs O(n^2 k) instead of the O(n^3) of a new factorization. Each solve applies one step of iterative
+// refinement against the stored matrix and refactors if the updates have lost too much accuracy.
+class Linear_Updatable_Solver : public System_Solver {
+private:
+	MatrixXd _interpolation_matrix;
+	MatrixXd _inverse;
+	VectorXd _constraint_values;
+	int _updates; // updates since the last factorization
+	int _factorizations;
+	static MatrixXd _select(const MatrixXd &matrix, const std::vector<int> &rows, const std::vector<int> &cols);
+public:
+	static const double refactor_tolerance; // backward error above which the inverse is recomputed
+	Linear_Updatable_Solver(const MatrixXd &matrix, const VectorXd &vector)
+	{
+		_interpolation_matrix = matrix;
+		_constraint_values = vector;
+		_updates = 0;
+		_factorizations = 0;
+	}
+	virtual ~Linear_Updatable_Solver() {}
+	bool solve();
+	bool validate_matrix_systems();
+	bool refactor();
+	// appends k constraints after the current n: columns are the new (n + k) x k columns of the matrix
+	// (including the k x k diagonal block), rows the new k x (n + k) rows. The symmetric version uses rows = columnsT.
+	bool append_constraints(const MatrixXd &columns, const MatrixXd &rows, const VectorXd &values);
+	bool append_constraints(const MatrixXd &columns, const VectorXd &values) { return append_constraints(columns, columns.transpose(), values); }
+	// removes the constraints (rows and columns) at indices, the others keep their order
+	bool remove_constraints(const std::vector<int> &indices);
+	// brings the system to matrix and vector with removals and appends: map[j] is the index in the current system
+	// of constraint j (-1 for new constraints). Constraints kept must have the same matrix entries.
+	bool update(const MatrixXd &matrix, const VectorXd &vector, const std::vector<int> &map);
+	int size() const { return (int)_interpolation_matrix.rows(); }
+	const MatrixXd &inverse() const { return _inverse; }
+	int updates() const { return _updates; }
+	int factorizations() const { return _factorizations; }
+};
+
+// Least squares fit of more constraints than unknowns: min |A w - b|^2 + lambda |w_r|^2 subject to C w = 0, where w_r are
+// the first n_regularized weights and lambda = regularization*|A|^2/m. The side conditions are removed with a null space
+// basis of C and the remaining problem is solved by column pivoting QR: O(N m^2) for an N x m matrix A.
+class Linear_Least_Squares : public System_Solver {
+private:
+	MatrixXd _design_matrix;
+	VectorXd _constraint_values;
+	MatrixXd _side_conditions;
+	int _n_regularized;
+	double _regularization;
+	double _rms_residual;
+public:
+	Linear_Least_Squares(const MatrixXd &matrix, const VectorXd &vector, const MatrixXd &side_conditions, const int &n_regularized, const double &regularization)
+	{
+		_design_matrix = matrix;
+		_constraint_values = vector;
+		_side_conditions = side_conditions;
+		_n_regularized = n_regularized;
+		_regularization = regularization;
+		_rms_residual = 0;
+	}
+	virtual ~Linear_Least_Squares() {}
+	bool solve();
+	bool validate_matrix_systems();
+	// root mean square of A w - b after the solve
+	double rms_residual() const { return _rms_residual; }
+};
+
+// Size, structure and conditioning of a linear system used to choose its solver
+struct Linear_System_Estimate{
+	int n;
+	double memory_mb; // dense storage of the matrix
+	double density; // fraction of entries above Linear_Sparse_LU::drop_tolerance
+	bool symmetric;
+	bool definite_kernel; // kernel (and constraints) give a positive definite matrix
+	double condition_estimate; // 1-norm condition estimate of a sampled principal sub-block (a lower bound), infinity if singular
+	int krylov_iterations; // predicted # of Krylov iterations (from condition_estimate)
+	double predicted_gflops; // predicted cost of the chosen solver
+	Parameter_Types::LinearSolver choice;
+	Linear_System_Estimate() : n(0), memory_mb(0), density(1), symmetric(false), definite_kernel(false),
+		condition_estimate(0), krylov_iterations(0), predicted_gflops(0), choice(Parameter_Types::Dense_LU) {}
+};
+
+// Chooses among dense LU, Cholesky and sparse LU with a simple flop count model, Krylov only on request
+class Linear_Solver_Selector {
+private:
+	static double _predicted_gflops(const Linear_System_Estimate &estimate, const Parameter_Types::LinearSolver &type);
+public:
+	// rows and columns of the sub-block factored for the condition estimate
+	static const int sample_size = 256;
+	// O(n^2) pass over the matrix plus the factorization of a sample_size sub-block, negligible next to any O(n^3) factorization
+	static Linear_System_Estimate estimate(const MatrixXd &matrix, const bool &definite_kernel);
+	// true if the kernel and constraints of the problem give a positive definite interpolation matrix
+	static bool is_definite_kernel(const model_parameters &m_parameters, const basic_parameters &b_parameters);
+	// creates the solver requested by m_parameters.linear_solver (or the automatic choice) and logs the decision
+	static System_Solver *create(const MatrixXd &matrix, const VectorXd &vector, const model_parameters &m_parameters, const basic_parameters &b_parameters);
+};
+
 class Quadratic_Predictor_Corrector : public System_Solver {
 private:
-	mpf_class _largest_element;
 	MatrixXd _interpolation_matrixD;
 	MatrixXd _hessian_matrixD;
 	MatrixXd _equality_matrixD;
 	MatrixXd _inequality_matrixD;
 	VectorXd _equality_vectorD;
 	VectorXd _inequality_vectorD;
-	Matrix <mpf_class, Dynamic, Dynamic> _hessian_matrix;
-	Matrix <mpf_class, Dynamic, Dynamic> _interpolation_matrix;
-	Matrix <mpf_class, Dynamic, Dynamic> _equality_matrix;
-	Matrix <mpf_class, Dynamic, Dynamic> _inequality_matrix;
-	Matrix <mpf_class, Dynamic, 1> _equality_vector;
-	Matrix <mpf_class, Dynamic, 1> _inequality_vector;
-	Matrix <mpf_class, Dynamic, Dynamic> _convert_double_matrix_2_mpf(const MatrixXd &matrix);
-	Matrix <mpf_class, Dynamic, 1> _convert_double_vector_2_mpf(const VectorXd &vector);
-	VectorXd _convert_mpf_vector_2_double(const Matrix <mpf_class, Dynamic, 1> &vector);
-	Matrix <mpf_class, Dynamic, Dynamic> _get_hessian_matrix(const Matrix <mpf_class, Dynamic, Dynamic> &matrix);
+	// warm start
+	QP_Iterate<double> _iterate;
+	bool _warm_start;
+	int _cold_iterations; // # of iterations of the last cold start (carried through warm starts)
+	QP_Parameters _qp_parameters;
+	QP_Result _qp_result;
 public:
 	Quadratic_Predictor_Corrector(const MatrixXd &interpolation_matrix,
 		                          const MatrixXd &equality_matrix,
@@ -119,11 +302,8 @@ public:
 		_inequality_matrixD = inequality_matrix;
 		_equality_vectorD = equality_vector;
 		_inequality_vectorD = inequality_vector;
-// 		_interpolation_matrix = _convert_double_matrix_2_mpf(interpolation_matrix);
-// 		_equality_matrix = _convert_double_matrix_2_mpf(equality_matrix);
-// 		_inequality_matrix = _convert_double_matrix_2_mpf(inequality_matrix);
-// 		_equality_vector = _convert_double_vector_2_mpf(equality_vector);
-// 		_inequality_vector = _convert_double_vector_2_mpf(inequality_vector);
+		_warm_start = false;
+		_cold_iterations = 0;
 
 // 		std::ofstream file1("interpM.txt");
 // 		std::ofstream file2("ieM.txt");
@@ -160,15 +340,59 @@ public:
 	}
 	bool solve();
 	bool validate_matrix_systems();
+	// start the next solve from the final iterate of a previous solve of a similar problem
+	// the maps give the index of each variable / equality / inequality in the previous problem (-1 if new)
+	bool set_warm_start(const Quadratic_Predictor_Corrector &previous, const std::vector<int> &variable_map,
+		const std::vector<int> &equality_map, const std::vector<int> &inequality_map);
+	const QP_Iterate<double> &get_iterate() const { return _iterate; }
+	int iterations() const { return _iterate.iterations; }
+	int iterations_saved() const { return _warm_start ? _cold_iterations - _iterate.iterations : 0; }
+	// stopping rule and limits of the interior point iterations, and the outcome of the last solve
+	void set_parameters(const QP_Parameters &parameters) { _qp_parameters = parameters; }
+	const QP_Result &result() const { return _qp_result; }
 
 };
 
+// Same problem as Quadratic_Predictor_Corrector solved with a dual active set method. Cheaper when
+// only a few of the inequality constraints are active at the solution.
+class Quadratic_Active_Set : public System_Solver {
+private:
+	MatrixXd _hessian_matrix;
+	MatrixXd _equality_matrix;
+	MatrixXd _inequality_matrix;
+	VectorXd _equality_vector;
+	VectorXd _inequality_vector;
+public:
+	Quadratic_Active_Set(const MatrixXd &interpolation_matrix,
+		                 const MatrixXd &equality_matrix,
+						 const MatrixXd &inequality_matrix,
+						 const VectorXd &equality_vector,
+						 const VectorXd &inequality_vector)
+	{
+		_hessian_matrix = 2.0*interpolation_matrix;
+		_equality_matrix = equality_matrix;
+		_inequality_matrix = inequality_matrix;
+		_equality_vector = equality_vector;
+		_inequality_vector = inequality_vector;
+	}
+	bool solve();
+	bool validate_matrix_systems();
+	// heuristic used for Parameter_Types::Automatic
+	static bool is_preferred(const int &n_inequality, const int &n_constraints) { return 4*n_inequality <= n_constraints; }
+};
+
 class Quadratic_Predictor_Corrector_LOQO : public System_Solver {
 private:
 	MatrixXd _H;
 	MatrixXd _A;
 	VectorXd _b;
 	VectorXd _r;
+	// warm start
+	LOQO_Iterate _iterate;
+	bool _warm_start;
+	int _cold_iterations; // # of iterations of the last cold start (carried through warm starts)
+	QP_Parameters _qp_parameters;
+	QP_Result _qp_result;
 public:
 	Quadratic_Predictor_Corrector_LOQO(
 		const MatrixXd &interpolation_matrix,
@@ -180,6 +404,8 @@ public:
 		_A = inequality_matrix;
 		_b = constraints;
 		_r = constraints_ranges;
+		_warm_start = false;
+		_cold_iterations = 0;
 
 		// 		// Debug
 		//  		cout<<" Hessian matrix:\n"<< _H << endl;
@@ -190,6 +416,14 @@ public:
 	}
 	bool solve();
 	bool validate_matrix_systems();
+	// start the next solve from the final iterate of a previous solve of a similar problem
+	// map gives the index of each constraint (and weight) in the previous problem (-1 if new)
+	bool set_warm_start(const Quadratic_Predictor_Corrector_LOQO &previous, const std::vector<int> &map);
+	const LOQO_Iterate &get_iterate() const { return _iterate; }
+	int iterations() const { return _iterate.iterations; }
+	int iterations_saved() const { return _warm_start ? _cold_iterations - _iterate.iterations : 0; }
+	void set_parameters(const QP_Parameters &parameters) { _qp_parameters = parameters; }
+	const QP_Result &result() const { return _qp_result; }
 };
 
 #endif
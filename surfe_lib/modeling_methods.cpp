@@ -39,6 +39,9 @@
 #include <lajaunie.h>
 #include <stratigraphic_surfaces.h>
 #include <continuous_property.h>
+#include <treecode.h>
+#include <out_of_core_solver.h>
+#include <classification.h>
 
 #include <algorithm>
 #include <vector>
@@ -46,6 +49,10 @@
 #include <iomanip>
 #include <fstream>
 #include <time.h>
+#include <cmath>
+#include <limits>
+#include <future>
+#include <cstring>
 
 double round(double d)
 {
@@ -80,7 +87,7 @@ bool GRBF_Modelling_Methods::_update_interface_iso_values()
 	return true;
 }
 
-void GRBF_Modelling_Methods::_Progress( char message[], const int &step, const int &total )
+void GRBF_Modelling_Methods::_Progress( const char *message, const int &step, const int &total )
 {
 	//progress width
 	const int pwidth = 72;
@@ -116,6 +123,266 @@ bool GRBF_Modelling_Methods::setup_basis_functions()
 	return true;
 }
 
+bool GRBF_Modelling_Methods::_expand_modified_kernel(std::vector<Interface> &centers, VectorXd &center_weights, VectorXd &poly_weights)
+{
+	Modified_Kernel *modified_kernel = dynamic_cast<Modified_Kernel *>(kernel);
+	if (modified_kernel == NULL || rbf_kernel == NULL || solver == NULL) return false;
+	Lagrangian_Polynomial_Basis *lpb = modified_kernel->lagrangian_basis();
+	if ((int)lpb->unisolvent_subset_points.size() != 4) return false;
+
+	// With the Lagrange polynomials p_j of the unisolvent points x_j the modified kernel is
+	//   K(x,y) = phi(x,y) - sum_j p_j(x) phi(x_j,y) - sum_j p_j(y) phi(x,x_j) + sum_j p_j(x) p_j(y) + sum_j!=k p_j(x) p_k(y) phi(x_j,x_k)
+	// so the interpolant s(x) = sum_i w_i L_i K(x,.) is also
+	//   s(x) = sum_i w_i L_i phi(x,.) - sum_j d_j phi(x,x_j) + sum_j e_j p_j(x)
+	// with d_j = sum_i w_i L_i p_j, c_j = sum_i w_i L_i phi(x_j,.) and e_j = d_j - c_j + sum_k!=j phi(x_j,x_k) d_k
+	centers = lpb->unisolvent_subset_points;
+	bool poly_term = b_parameters.poly_term;
+	b_parameters.poly_term = false;
+	VectorXd d(4);
+	VectorXd c(4);
+	for (int j = 0; j < 4; j++ ){
+		Lagrange_Polynomial_Kernel polynomial_kernel(lpb, j);
+		kernel = &polynomial_kernel;
+		Evaluation_Point origin(0.0, 0.0, 0.0);
+		eval_scalar_interpolant_at_point(origin);
+		d(j) = origin.scalar_field();
+		kernel = rbf_kernel;
+		Interface center = centers[j];
+		eval_scalar_interpolant_at_point(center);
+		c(j) = center.scalar_field();
+	}
+	kernel = modified_kernel;
+	b_parameters.poly_term = poly_term;
+
+	VectorXd e = d - c;
+	for (int j = 0; j < 4; j++ ){
+		for (int k = 0; k < 4; k++ ){
+			if (k == j) continue;
+			rbf_kernel->set_points(centers[j], centers[k]);
+			e(j) += rbf_kernel->basis()*d(k);
+		}
+	}
+	center_weights = -d;
+
+	// sum_j e_j p_j in the monomials of Poly_First
+	Evaluation_Point origin(0.0, 0.0, 0.0);
+	Matrix <extended_float, Dynamic, 1> p0 = lpb->poly(&origin);
+	Matrix <extended_float, Dynamic, 1> px = lpb->poly_dx(&origin);
+	Matrix <extended_float, Dynamic, 1> py = lpb->poly_dy(&origin);
+	Matrix <extended_float, Dynamic, 1> pz = lpb->poly_dz(&origin);
+	poly_weights = VectorXd::Zero(4);
+	for (int j = 0; j < 4; j++ ){
+		extended_float ax = px(j), ay = py(j), az = pz(j), a0 = p0(j);
+		poly_weights(0) += e(j)*ax.get_d();
+		poly_weights(1) += e(j)*ay.get_d();
+		poly_weights(2) += e(j)*az.get_d();
+		poly_weights(3) += e(j)*a0.get_d();
+	}
+
+	return poly_weights.allFinite() && center_weights.allFinite();
+}
+
+bool GRBF_Modelling_Methods::_unisolvent_interface_indices(std::vector<int> &indices)
+{
+	Modified_Kernel *modified_kernel = dynamic_cast<Modified_Kernel *>(kernel);
+	if (modified_kernel == NULL) return false;
+	Lagrangian_Polynomial_Basis *lpb = modified_kernel->lagrangian_basis();
+	int list = lpb->unisolvent_subset_list;
+	if (list < 0 || list >= (int)b_input.interface_point_lists->size()) return false;
+
+	// interface_point_lists[list] holds the interface points of its level in b_input.itrface order
+	const std::vector<Interface> &points = b_input.interface_point_lists->at(list);
+	std::vector<int> list_indices;
+	for (int k = 0; k < (int)b_input.itrface->size(); k++ ){
+		if (b_input.itrface->at(k).level() == points[0].level()) list_indices.push_back(k);
+	}
+	if (list_indices.size() != points.size()) return false;
+
+	indices.clear();
+	for (int j = 0; j < (int)lpb->unisolvent_subset_indices.size(); j++ ){
+		int index = lpb->unisolvent_subset_indices[j];
+		if (index < 0 || index >= (int)list_indices.size()) return false;
+		indices.push_back(list_indices[index]);
+	}
+	return true;
+}
+
+double GRBF_Modelling_Methods::_constraint_extent()
+{
+	std::vector<Point*> points;
+	for (int j = 0; j < (int)b_input.inequality->size(); j++ ) points.push_back(&b_input.inequality->at(j));
+	for (int j = 0; j < (int)b_input.itrface->size(); j++ ) points.push_back(&b_input.itrface->at(j));
+	for (int j = 0; j < (int)b_input.planar->size(); j++ ) points.push_back(&b_input.planar->at(j));
+	for (int j = 0; j < (int)b_input.tangent->size(); j++ ) points.push_back(&b_input.tangent->at(j));
+	if (points.empty()) return 0.0;
+
+	double lower[3] = { points[0]->x(), points[0]->y(), points[0]->z() };
+	double upper[3] = { lower[0], lower[1], lower[2] };
+	for (int j = 1; j < (int)points.size(); j++ ){
+		double p[3] = { points[j]->x(), points[j]->y(), points[j]->z() };
+		for (int k = 0; k < 3; k++ ){
+			lower[k] = std::min(lower[k], p[k]);
+			upper[k] = std::max(upper[k], p[k]);
+		}
+	}
+	return sqrt((upper[0] - lower[0])*(upper[0] - lower[0]) + (upper[1] - lower[1])*(upper[1] - lower[1]) + (upper[2] - lower[2])*(upper[2] - lower[2]));
+}
+
+bool Radial_Matrix_Geometry::assemble(const RBFKernel *kernel, MatrixXd &matrix) const
+{
+	int n = (int)r2.rows();
+	if (matrix.rows() < n || matrix.cols() < n) return false;
+	VectorXd phi(n);
+	VectorXd dphi(n);
+	VectorXd ddphi(n);
+	for (int j = 0; j < n; j++ ){
+		if (!kernel->radial_profile(n, r2.col(j).data(), phi.data(), dphi.data(), ddphi.data())) return false;
+		// d = p_i - p_j: the derivative along v_j of p_j is -dphi*d.v_j, along v_i of p_i dphi*d.v_i = -dphi*offsets(j,i)
+		for (int i = 0; i < n; i++ ){
+			if (!derivative[i] && !derivative[j]) matrix(i,j) = phi(i);
+			else if (!derivative[i]) matrix(i,j) = -dphi(i)*offsets(i,j);
+			else if (!derivative[j]) matrix(i,j) = -dphi(i)*offsets(j,i);
+			else matrix(i,j) = -dphi(i)*directions.col(i).dot(directions.col(j)) + ddphi(i)*offsets(j,i)*offsets(i,j);
+		}
+	}
+	return true;
+}
+
+bool GRBF_Modelling_Methods::_leave_one_out_residuals(const MatrixXd &interpolation_matrix, const VectorXd &equality_values, const int &n_e,
+	VectorXd &residuals)
+{
+	// Rippa (1999): the error at constraint i of the interpolant fitted without it is c_i/(A-1)ii.
+	// The polynomial rows are kept, so this also holds for the augmented (saddle point) systems.
+	int n = (int)interpolation_matrix.rows();
+	PartialPivLU<MatrixXd> lu(interpolation_matrix);
+	VectorXd weights = lu.solve(equality_values);
+	// (A-1)ii from solves with the unit vectors of the constraint rows, a panel at a time: no inverse is formed
+	const int panel = 256;
+	residuals.resize(n_e);
+	for (int first = 0; first < n_e; first += panel){
+		int count = std::min(panel, n_e - first);
+		MatrixXd columns = lu.solve(MatrixXd::Identity(n, n).middleCols(first, count));
+		for (int k = 0; k < count; k++ ){
+			double diagonal = columns(first + k,k);
+			if (diagonal == 0.0) return false;
+			residuals(first + k) = weights(first + k)/diagonal;
+		}
+	}
+	return residuals.allFinite();
+}
+
+bool GRBF_Modelling_Methods::leave_one_out_residuals(VectorXd &residuals)
+{
+	if (b_parameters.problem_type != Parameter_Types::Linear || kernel == NULL) return false;
+	int n_e = b_parameters.n_equality;
+	int n_p = b_parameters.n_poly_terms;
+	if (n_e < 2) return false;
+
+	VectorXd equality_values(n_e + n_p);
+	if (!get_equality_values(equality_values)) return false;
+	MatrixXd interpolation_matrix(n_e + n_p, n_e + n_p);
+	if (!get_interpolation_matrix(interpolation_matrix)) return false;
+
+	return _leave_one_out_residuals(interpolation_matrix, equality_values, n_e, residuals);
+}
+
+double GRBF_Modelling_Methods::_leave_one_out_error(const double &shape_parameter, const Radial_Matrix_Geometry *geometry,
+	MatrixXd &interpolation_matrix, const VectorXd &equality_values)
+{
+	if (!rbf_kernel->set_shape_parameter(shape_parameter)) return std::numeric_limits<double>::infinity();
+	if (geometry != NULL)
+	{
+		if (!geometry->assemble(rbf_kernel, interpolation_matrix)) return std::numeric_limits<double>::infinity();
+	}
+	else if (!get_interpolation_matrix(interpolation_matrix)) return std::numeric_limits<double>::infinity();
+	VectorXd residuals;
+	if (!_leave_one_out_residuals(interpolation_matrix, equality_values, b_parameters.n_equality, residuals)) return std::numeric_limits<double>::infinity();
+	return sqrt(residuals.squaredNorm()/(double)residuals.size());
+}
+
+bool GRBF_Modelling_Methods::optimize_shape_parameter(const double &lower, const double &upper, double &shape_parameter, double &loocv_error)
+{
+	if (rbf_kernel == NULL || !(lower > 0.0) || !(upper > lower)) return false;
+	if (!rbf_kernel->set_shape_parameter(m_parameters.shape_parameter))
+	{
+		error_msg.append(" The kernel has no shape parameter.");
+		return false;
+	}
+	int n_e = b_parameters.n_equality;
+	int n_p = b_parameters.n_poly_terms;
+	if (b_parameters.problem_type != Parameter_Types::Linear || kernel == NULL || n_e < 2) return false;
+
+	// the constraints and the polynomial blocks are the same for every trial: the pairwise geometry of the constraints
+	// is computed once and each trial only applies the kernel's radial profile to it
+	VectorXd equality_values(n_e + n_p);
+	MatrixXd interpolation_matrix(n_e + n_p, n_e + n_p);
+	if (!get_equality_values(equality_values) || !get_interpolation_matrix(interpolation_matrix)) return false;
+	Radial_Matrix_Geometry geometry;
+	const Radial_Matrix_Geometry *trial_geometry = _get_radial_matrix_geometry(geometry) ? &geometry : NULL;
+
+	// the error is not unimodal in general: bracket the minimum with a coarse scan in log(shape parameter) first
+	const int n_scan = 8;
+	double a = log(lower);
+	double b = log(upper);
+	double step = (b - a)/(double)(n_scan - 1);
+	std::vector<double> scan(n_scan);
+	int best = 0;
+	for (int j = 0; j < n_scan; j++ ){
+		scan[j] = _leave_one_out_error(exp(a + j*step), trial_geometry, interpolation_matrix, equality_values);
+		if (scan[j] < scan[best]) best = j;
+	}
+	if (!(scan[best] < std::numeric_limits<double>::infinity()))
+	{
+		rbf_kernel->set_shape_parameter(m_parameters.shape_parameter);
+		return false;
+	}
+	double best_t = a + best*step;
+	double best_error = scan[best];
+
+	// golden section search in the bracket around the best scan point, to 1% in the shape parameter
+	const double golden = 0.5*(sqrt(5.0) - 1.0);
+	double x0 = a + std::max(best - 1, 0)*step;
+	double x3 = a + std::min(best + 1, n_scan - 1)*step;
+	double x1 = x3 - golden*(x3 - x0);
+	double x2 = x0 + golden*(x3 - x0);
+	double f1 = _leave_one_out_error(exp(x1), trial_geometry, interpolation_matrix, equality_values);
+	double f2 = _leave_one_out_error(exp(x2), trial_geometry, interpolation_matrix, equality_values);
+	for (int iter = 0; iter < 30 && x3 - x0 > 0.01; iter++ ){
+		if (f1 < f2)
+		{
+			x3 = x2;
+			x2 = x1;
+			f2 = f1;
+			x1 = x3 - golden*(x3 - x0);
+			f1 = _leave_one_out_error(exp(x1), trial_geometry, interpolation_matrix, equality_values);
+		}
+		else
+		{
+			x0 = x1;
+			x1 = x2;
+			f1 = f2;
+			x2 = x0 + golden*(x3 - x0);
+			f2 = _leave_one_out_error(exp(x2), trial_geometry, interpolation_matrix, equality_values);
+		}
+	}
+	if (f1 < best_error)
+	{
+		best_error = f1;
+		best_t = x1;
+	}
+	if (f2 < best_error)
+	{
+		best_error = f2;
+		best_t = x2;
+	}
+
+	shape_parameter = exp(best_t);
+	loocv_error = best_error;
+	m_parameters.shape_parameter = shape_parameter;
+	rbf_kernel->set_shape_parameter(shape_parameter);
+	return true;
+}
+
 bool GRBF_Modelling_Methods::check_interpolant()
 {
 	for (int j = 0; j < b_input.itrface->size(); j++ ){
@@ -146,44 +413,839 @@ bool GRBF_Modelling_Methods::check_interpolant()
 	return true;
 }
 
-bool GRBF_Modelling_Methods::evaluate_scalar_interpolant()
+Tiled_Evaluator *GRBF_Modelling_Methods::_new_tiled_evaluator(const int &n_fields)
+{
+	RBFKernel *rbf = dynamic_cast<RBFKernel *>(kernel);
+	if (rbf == NULL) return NULL;
+	Tiled_Evaluator *evaluator = new Tiled_Evaluator(rbf, n_fields);
+	if (!evaluator->supported())
+	{
+		delete evaluator;
+		return NULL;
+	}
+	return evaluator;
+}
+
+bool GRBF_Modelling_Methods::_prepare_evaluation()
 {
 	if (solver == NULL) return false;
-	else
+	if ((int)solver->weights.size() == 0) return false;
+	if (b_parameters.modified_basis)
 	{
-		if ((int)solver->weights.size() == 0) return false;
+		if (!convert_modified_kernel_to_rbf_kernel())
+		{
+			error_msg.append(" QPP solution conversion to Linear Failure.");
+			return false;
+		}
+	}
+	return true;
+}
+
+bool GRBF_Modelling_Methods::evaluate_scalar_interpolant()
+{
+	if (!_prepare_evaluation()) return false;
+
+	int N = (int)b_input.evaluation_pts->size();
+	_evaluation_error = 0.0;
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	if (evaluator != NULL && m_parameters.evaluation_tolerance > 0.0)
+	{
+		Treecode_Evaluator treecode(*evaluator);
+		if (treecode.supported())
+		{
+			cout<<" Computing Scalar field (treecode): ";
+			if (!treecode.evaluate(*b_input.evaluation_pts, m_parameters.evaluation_tolerance))
+				cout<<"Warning: error tolerance not met, ";
+			_evaluation_error = treecode.error_estimate();
+			cout<<"degree "<<treecode.degree()<<", estimated error "<<_evaluation_error<<endl;
+			delete evaluator;
+			return true;
+		}
+	}
+	if (evaluator != NULL)
+	{
+		// blocks of evaluation points against all the packed centers, a block per thread at a time
+		int n_blocks = (N + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+		int done = 0;
+		#pragma omp parallel for schedule(dynamic)
+		for (int j = 0; j < n_blocks; j++ ){
+			int begin = j*Tiled_Evaluator::point_block;
+			int end = std::min(N, begin + (int)Tiled_Evaluator::point_block);
+			evaluator->evaluate(*b_input.evaluation_pts, begin, end);
+#pragma omp atomic
+			done++;
+			int step = (100*done) / n_blocks;
+#pragma omp critical
+			_Progress(" Computing Scalar field: ", step, 100 );
+		}
+		cout<<endl;
+		delete evaluator;
+		return true;
+	}
+	int add = 0;
+	int vv = round((double)N / 72.0); // 72.0 is the width of the progress bar 
+	double factor = (100.0*(double)vv) / (double)N;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int j = 0; j < N; j++ ){
+		eval_scalar_interpolant_at_point(b_input.evaluation_pts->at(j));
+		//eval_vector_interpolant_at_point(b_input.evaluation_pts->at(j));
+		if ( j % vv == 0 )
+		{
+#pragma omp atomic
+			add++;
+			int step = factor * add;
+#pragma omp critical
+			_Progress(" Computing Scalar field: ", step, 100 );
+		}
+	}
+	cout<<endl;
+	return true;
+}
+
+bool GRBF_Modelling_Methods::evaluate_scalar_and_vector_interpolant()
+{
+	if (!_prepare_evaluation()) return false;
+
+	int N = (int)b_input.evaluation_pts->size();
+	_evaluation_error = 0.0;
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	int n_blocks = (N + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+	int done = 0;
+	#pragma omp parallel for schedule(dynamic)
+	for (int j = 0; j < n_blocks; j++ ){
+		int begin = j*Tiled_Evaluator::point_block;
+		int end = std::min(N, begin + (int)Tiled_Evaluator::point_block);
+		if (evaluator != NULL) evaluator->evaluate(*b_input.evaluation_pts, begin, end, true);
 		else
 		{
-			if (b_parameters.modified_basis)
+			for (int k = begin; k < end; k++ ){
+				eval_scalar_interpolant_at_point(b_input.evaluation_pts->at(k));
+				eval_vector_interpolant_at_point(b_input.evaluation_pts->at(k));
+			}
+		}
+#pragma omp atomic
+		done++;
+		int step = (100*done) / n_blocks;
+#pragma omp critical
+		_Progress(" Computing Scalar and Vector fields: ", step, 100 );
+	}
+	cout<<endl;
+	if (evaluator != NULL) delete evaluator;
+	return true;
+}
+
+template <typename T>
+void GRBF_Modelling_Methods::_evaluate_grid_nodes(const Tiled_Evaluator *evaluator, const double *origin, const double *spacing, const int *dims,
+	const long long *nodes, const long long &n, T *out, const bool &progress, T *gradients)
+{
+	int n_fields = n_scalar_fields();
+	long long n_blocks = (n + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+	long long done = 0;
+	#pragma omp parallel for schedule(dynamic)
+	for (long long j = 0; j < n_blocks; j++ ){
+		long long begin = j*Tiled_Evaluator::point_block;
+		long long end = std::min(n, begin + (long long)Tiled_Evaluator::point_block);
+		if (evaluator != NULL) evaluator->evaluate_grid(origin, spacing, dims, nodes, begin, end, out, gradients);
+		else
+		{
+			// point by point, one evaluation point reused for the nodes of the block
+			for (long long k = begin; k < end; k++ ){
+				long long m = (nodes != NULL) ? nodes[k] : k;
+				Evaluation_Point p(origin[0] + (double)(m % dims[0])*spacing[0], origin[1] + (double)((m / dims[0]) % dims[1])*spacing[1],
+					origin[2] + (double)(m / ((long long)dims[0]*dims[1]))*spacing[2]);
+				eval_scalar_interpolant_at_point(p);
+				if (n_fields > 1) for (int f = 0; f < n_fields; f++ ) out[(size_t)m*n_fields + f] = (T)p.scalar_field(f);
+				else out[m] = (T)p.scalar_field();
+				if (gradients != NULL)
+				{
+					// the vector field is the gradient of the first field
+					eval_vector_interpolant_at_point(p);
+					gradients[(size_t)m*n_fields*3] = (T)p.nx_interp();
+					gradients[(size_t)m*n_fields*3 + 1] = (T)p.ny_interp();
+					gradients[(size_t)m*n_fields*3 + 2] = (T)p.nz_interp();
+				}
+			}
+		}
+		if (progress)
+		{
+#pragma omp atomic
+			done++;
+			int step = (int)((100*done) / n_blocks);
+#pragma omp critical
+			_Progress(" Computing Scalar field: ", step, 100 );
+		}
+	}
+	if (progress) cout<<endl;
+}
+
+template <typename T>
+bool GRBF_Modelling_Methods::_evaluate_on_grid(const double *origin, const double *spacing, const int *dims, T *out)
+{
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0)
+	{
+		error_msg.append(" Empty evaluation grid.");
+		return false;
+	}
+	if (!_prepare_evaluation()) return false;
+
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	_evaluation_error = 0.0;
+	_evaluate_grid_nodes(evaluator, origin, spacing, dims, (const long long *)NULL, (long long)dims[0]*dims[1]*dims[2], out, true);
+	if (evaluator != NULL) delete evaluator;
+	return true;
+}
+
+template <typename T>
+bool GRBF_Modelling_Methods::_evaluate_gradient_on_grid(const double *origin, const double *spacing, const int *dims, T *out, T *gradients,
+	T *dip, T *strike)
+{
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0)
+	{
+		error_msg.append(" Empty evaluation grid.");
+		return false;
+	}
+	if (!_prepare_evaluation()) return false;
+
+	int n_fields = n_scalar_fields();
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	if (evaluator == NULL && n_fields > 1)
+	{
+		error_msg.append(" Gradients of several scalar fields need an isotropic kernel.");
+		return false;
+	}
+	_evaluation_error = 0.0;
+	long long N = (long long)dims[0]*dims[1]*dims[2];
+	// dip and strike without gradients from the caller still need the gradients
+	std::vector<T> gradient_buffer;
+	if (gradients == NULL && (dip != NULL || strike != NULL))
+	{
+		gradient_buffer.resize((size_t)N*n_fields*3);
+		gradients = gradient_buffer.data();
+	}
+	_evaluate_grid_nodes(evaluator, origin, spacing, dims, (const long long *)NULL, N, out, true, gradients);
+	if (dip != NULL || strike != NULL)
+	{
+		// orientation of the planes normal to the gradients, same convention as the planar constraints
+		#pragma omp parallel for schedule(dynamic, 4096)
+		for (long long m = 0; m < N*n_fields; m++ ){
+			double g[3] = { (double)gradients[3*m], (double)gradients[3*m + 1], (double)gradients[3*m + 2] };
+			double norm = sqrt(g[0]*g[0] + g[1]*g[1] + g[2]*g[2]);
+			double plane_dip = 0.0;
+			double plane_strike = 0.0;
+			if (norm > 0.0)
 			{
-				if (!convert_modified_kernel_to_rbf_kernel())
+				Planar orientation(0.0, 0.0, 0.0, g[0] / norm, g[1] / norm, g[2] / norm);
+				plane_dip = orientation.dip();
+				plane_strike = orientation.strike();
+			}
+			if (dip != NULL) dip[m] = (T)plane_dip;
+			if (strike != NULL) strike[m] = (T)plane_strike;
+		}
+	}
+	if (evaluator != NULL) delete evaluator;
+	return true;
+}
+
+bool GRBF_Modelling_Methods::evaluate_gradient_on_grid(const double origin[3], const double spacing[3], const int dims[3], double *out, double *gradients,
+	double *dip, double *strike)
+{
+	return _evaluate_gradient_on_grid(origin, spacing, dims, out, gradients, dip, strike);
+}
+
+bool GRBF_Modelling_Methods::evaluate_gradient_on_grid(const double origin[3], const double spacing[3], const int dims[3], float *out, float *gradients,
+	float *dip, float *strike)
+{
+	return _evaluate_gradient_on_grid(origin, spacing, dims, out, gradients, dip, strike);
+}
+
+bool GRBF_Modelling_Methods::_evaluate_stream(const long long &n_points, const std::function<bool(const long long &, const int &, double *)> &load,
+	const std::string &output_file, const int &chunk_size, const bool &single_precision)
+{
+	if (n_points <= 0 || chunk_size <= 0) return false;
+	if (!_prepare_evaluation()) return false;
+
+	int n_fields = n_scalar_fields();
+	size_t value_bytes = single_precision ? sizeof(float) : sizeof(double);
+	Mapped_File output;
+	if (!output.open(output_file, (size_t)n_points*n_fields*value_bytes))
+	{
+		error_msg.append(" Could not create the output file " + output_file + ".");
+		return false;
+	}
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	_evaluation_error = 0.0;
+	int n_chunks = (int)((n_points + chunk_size - 1) / chunk_size);
+	std::vector<double> xyz[2];
+	std::vector<double> values[2];
+	for (int b = 0; b < 2; b++ )
+	{
+		xyz[b].resize(3*(size_t)std::min((long long)chunk_size, n_points));
+		values[b].resize((size_t)std::min((long long)chunk_size, n_points)*n_fields);
+	}
+	// chunk c: points [c*chunk_size, c*chunk_size + size), buffers c % 2
+	std::function<bool(int)> read = [&](int c) -> bool {
+		long long first = (long long)c*chunk_size;
+		return load(first, (int)std::min((long long)chunk_size, n_points - first), &xyz[c % 2][0]);
+	};
+	std::function<bool(int)> write = [&](int c) -> bool {
+		long long first = (long long)c*chunk_size;
+		int n = (int)std::min((long long)chunk_size, n_points - first);
+		char *view = output.view((size_t)first*n_fields*value_bytes, (size_t)n*n_fields*value_bytes);
+		if (view == NULL) return false;
+		const double *v = &values[c % 2][0];
+		if (single_precision) for (size_t k = 0; k < (size_t)n*n_fields; k++ ) ((float*)view)[k] = (float)v[k];
+		else memcpy(view, v, (size_t)n*n_fields*sizeof(double));
+		return true;
+	};
+
+	bool ok = true;
+	std::future<bool> reading = std::async(std::launch::async, read, 0);
+	std::future<bool> writing;
+	for (int c = 0; c < n_chunks && ok; c++ ){
+		if (!reading.get())
+		{
+			error_msg.append(" Could not read the evaluation points.");
+			ok = false;
+			break;
+		}
+		if (c + 1 < n_chunks) reading = std::async(std::launch::async, read, c + 1);
+		// the write of chunk c - 2 (same buffers) finished before chunk c - 1 was queued
+		int n = (int)std::min((long long)chunk_size, n_points - (long long)c*chunk_size);
+		const double *points = &xyz[c % 2][0];
+		double *out = &values[c % 2][0];
+		int n_blocks = (n + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+		#pragma omp parallel for schedule(dynamic)
+		for (int j = 0; j < n_blocks; j++ ){
+			int begin = j*Tiled_Evaluator::point_block;
+			int end = std::min(n, begin + (int)Tiled_Evaluator::point_block);
+			if (evaluator != NULL) evaluator->evaluate_points(points, begin, end, out);
+			else
+			{
+				for (int k = begin; k < end; k++ ){
+					Evaluation_Point p(points[3*k], points[3*k + 1], points[3*k + 2]);
+					eval_scalar_interpolant_at_point(p);
+					if (n_fields > 1) for (int f = 0; f < n_fields; f++ ) out[(size_t)k*n_fields + f] = p.scalar_field(f);
+					else out[k] = p.scalar_field();
+				}
+			}
+		}
+		if (writing.valid() && !writing.get())
+		{
+			error_msg.append(" Could not write " + output_file + ".");
+			ok = false;
+		}
+		writing = std::async(std::launch::async, write, c);
+		_Progress(" Computing Scalar field: ", (100*(c + 1)) / n_chunks, 100 );
+	}
+	cout<<endl;
+	if (reading.valid()) reading.get();
+	if (writing.valid() && !writing.get() && ok)
+	{
+		error_msg.append(" Could not write " + output_file + ".");
+		ok = false;
+	}
+	output.close();
+	if (evaluator != NULL) delete evaluator;
+	return ok;
+}
+
+bool GRBF_Modelling_Methods::evaluate_file(const std::string &points_file, const std::string &output_file, const int &chunk_size,
+	const bool &single_precision)
+{
+	Mapped_File input;
+	if (!input.open(points_file) || input.size() == 0 || input.size() % (3*sizeof(double)) != 0)
+	{
+		error_msg.append(" " + points_file + " is not a file of x, y, z doubles.");
+		return false;
+	}
+	long long n_points = (long long)(input.size() / (3*sizeof(double)));
+	return _evaluate_stream(n_points, [&](const long long &first, const int &n, double *xyz) -> bool {
+		const char *view = input.view((size_t)first*3*sizeof(double), (size_t)n*3*sizeof(double));
+		if (view == NULL) return false;
+		memcpy(xyz, view, (size_t)n*3*sizeof(double));
+		return true;
+	}, output_file, chunk_size, single_precision);
+}
+
+bool GRBF_Modelling_Methods::evaluate_grid_to_file(const double origin[3], const double spacing[3], const int dims[3], const std::string &output_file,
+	const int &chunk_size, const bool &single_precision)
+{
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0)
+	{
+		error_msg.append(" Empty evaluation grid.");
+		return false;
+	}
+	long long n_points = (long long)dims[0]*dims[1]*dims[2];
+	return _evaluate_stream(n_points, [&](const long long &first, const int &n, double *xyz) -> bool {
+		for (int k = 0; k < n; k++ ){
+			long long node = first + k;
+			xyz[3*k] = origin[0] + (double)(node % dims[0])*spacing[0];
+			xyz[3*k + 1] = origin[1] + (double)((node / dims[0]) % dims[1])*spacing[1];
+			xyz[3*k + 2] = origin[2] + (double)(node / ((long long)dims[0]*dims[1]))*spacing[2];
+		}
+		return true;
+	}, output_file, chunk_size, single_precision);
+}
+
+template <typename T>
+bool GRBF_Modelling_Methods::_evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double *origin, const double *spacing,
+	const int *dims, T *out)
+{
+	if (methods.empty() || dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0) return false;
+	int n_fields = 0;
+	for (int m = 0; m < (int)methods.size(); m++ )
+	{
+		if (!methods[m]->_prepare_evaluation()) return false;
+		methods[m]->_evaluation_error = 0.0;
+		n_fields += methods[m]->n_scalar_fields();
+	}
+	long long N = (long long)dims[0]*dims[1]*dims[2];
+
+	std::vector<Tiled_Evaluator *> evaluators(methods.size());
+	std::vector<const Tiled_Evaluator *> parts;
+	for (int m = 0; m < (int)methods.size(); m++ )
+	{
+		evaluators[m] = methods[m]->get_tiled_evaluator();
+		if (evaluators[m] != NULL) parts.push_back(evaluators[m]);
+	}
+	Tiled_Evaluator *merged = NULL;
+	if (parts.size() == methods.size()) merged = Tiled_Evaluator::merge(parts);
+	for (int m = 0; m < (int)methods.size(); m++ ) if (evaluators[m] != NULL) delete evaluators[m];
+	if (merged != NULL)
+	{
+		cout<<" Batch of "<<methods.size()<<" interpolants: "<<merged->n_centers()<<" shared centers"<<endl;
+		methods[0]->_evaluate_grid_nodes(merged, origin, spacing, dims, (const long long *)NULL, N, out, true);
+		delete merged;
+		return true;
+	}
+
+	// different kernels: one interpolant at a time, interleaved
+	std::vector<T> values;
+	int first = 0;
+	for (int m = 0; m < (int)methods.size(); m++ )
+	{
+		int n_m = methods[m]->n_scalar_fields();
+		values.resize((size_t)N*n_m);
+		if (!methods[m]->_evaluate_on_grid(origin, spacing, dims, &values[0])) return false;
+		for (long long n = 0; n < N; n++ )
+			for (int f = 0; f < n_m; f++ ) out[n*n_fields + first + f] = values[n*n_m + f];
+		first += n_m;
+	}
+	return true;
+}
+
+bool GRBF_Modelling_Methods::evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double origin[3], const double spacing[3],
+	const int dims[3], double *out)
+{
+	return _evaluate_batch_on_grid(methods, origin, spacing, dims, out);
+}
+
+bool GRBF_Modelling_Methods::evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double origin[3], const double spacing[3],
+	const int dims[3], float *out)
+{
+	return _evaluate_batch_on_grid(methods, origin, spacing, dims, out);
+}
+
+// a cell of the narrow band octree: nodes lower[d] <= i_d <= upper[d]
+struct Grid_Cell {
+	int lower[3];
+	int upper[3];
+};
+
+// corner node c (bit d: upper side along axis d) of a cell
+static long long _corner_node(const Grid_Cell &cell, const int &c, const int *dims)
+{
+	long long i = (c & 1) ? cell.upper[0] : cell.lower[0];
+	long long j = (c & 2) ? cell.upper[1] : cell.lower[1];
+	long long k = (c & 4) ? cell.upper[2] : cell.lower[2];
+	return i + dims[0]*(j + dims[1]*k);
+}
+
+// cells of at most this many node spacings along every axis are judged from the first order estimate of the field,
+// a heuristic: a feature thinner than the curvature the estimate ignores can be missed unless safety covers it
+static const int _near_iso_small_cell = 4;
+
+// false if the field can not reach any iso value inside the cell. Every point of the cell is within the half diagonal r
+// of the cell center c, so with the Hessian bound H the field stays within |grad(c)|*r + H*r^2/2 of its value at c.
+// Small cells use the first order estimate |grad(c)|*r instead, no bound. The margin is times safety
+template <typename T>
+static bool _may_cross(const Grid_Cell &cell, const T *out, const int *dims, const double *spacing, const std::vector<double> &iso_values,
+	Evaluation_Point &center, const double &hessian, const double &safety)
+{
+	double r2 = 0.0;
+	bool small = true;
+	for (int d = 0; d < 3; d++ )
+	{
+		double length = (cell.upper[d] - cell.lower[d])*spacing[d];
+		r2 += 0.25*length*length;
+		if (cell.upper[d] - cell.lower[d] > _near_iso_small_cell) small = false;
+	}
+	double gradient = sqrt(center.nx_interp()*center.nx_interp() + center.ny_interp()*center.ny_interp() + center.nz_interp()*center.nz_interp());
+	double margin = safety*gradient*sqrt(r2);
+	if (!small) margin += safety*0.5*hessian*r2;
+	double lower = center.scalar_field() - margin;
+	double upper = center.scalar_field() + margin;
+	for (int c = 0; c < 8; c++ )
+	{
+		double f = (double)out[_corner_node(cell, c, dims)];
+		lower = std::min(lower, f);
+		upper = std::max(upper, f);
+	}
+	for (int k = 0; k < (int)iso_values.size(); k++ )
+		if (lower <= iso_values[k] && upper >= iso_values[k]) return true;
+	return false;
+}
+
+template <typename T>
+bool GRBF_Modelling_Methods::_evaluate_on_grid_near_iso(const double *origin, const double *spacing, const int *dims, T *out,
+	unsigned char *evaluated, const int &coarse_step, const double &safety)
+{
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0 || coarse_step < 1)
+	{
+		error_msg.append(" Empty evaluation grid.");
+		return false;
+	}
+	Tiled_Evaluator *evaluator = NULL;
+	double hessian = std::numeric_limits<double>::infinity();
+	if (n_scalar_fields() == 1 && b_input.interface_iso_values != NULL && !b_input.interface_iso_values->empty())
+	{
+		if (!_prepare_evaluation()) return false;
+		evaluator = get_tiled_evaluator();
+	}
+	if (evaluator != NULL)
+	{
+		// farthest a grid point can be from a center: diagonal of the box around the grid and the centers
+		const Packed_Centers &centers = evaluator->centers();
+		double lower[3] = { origin[0], origin[1], origin[2] };
+		double upper[3];
+		for (int d = 0; d < 3; d++ ) upper[d] = origin[d] + (dims[d] - 1)*spacing[d];
+		double c_max = 0.0;
+		for (int j = 0; j < centers.size(); j++ )
+		{
+			double p[3] = { centers.x[j], centers.y[j], centers.z[j] };
+			for (int d = 0; d < 3; d++ )
+			{
+				lower[d] = std::min(lower[d], p[d]);
+				upper[d] = std::max(upper[d], p[d]);
+			}
+			c_max = std::max(c_max, fabs(centers.c[j]));
+		}
+		double r2 = c_max*c_max;
+		for (int d = 0; d < 3; d++ ) r2 += (upper[d] - lower[d])*(upper[d] - lower[d]);
+		hessian = evaluator->hessian_bound(sqrt(r2));
+	}
+	if (evaluator == NULL)
+	{
+		// no iso surfaces to narrow the band to, or no gradients at the cell centers
+		if (!_evaluate_on_grid(origin, spacing, dims, out)) return false;
+		if (evaluated != NULL) for (size_t n = 0; n < (size_t)dims[0]*dims[1]*dims[2]; n++ ) evaluated[n] = 1;
+		return true;
+	}
+
+	_evaluation_error = 0.0;
+	std::vector<double> iso_values = *b_input.interface_iso_values;
+	long long N = (long long)dims[0]*dims[1]*dims[2];
+	// 0: not evaluated, 1: evaluated, 2: queued for evaluation
+	std::vector<unsigned char> state(N, 0);
+
+	// coarse cells of coarse_step nodes, the last ones along an axis may be shorter
+	std::vector<Grid_Cell> cells;
+	std::vector<int> starts[3];
+	for (int d = 0; d < 3; d++ )
+	{
+		for (int i = 0; i < dims[d] - 1; i += coarse_step) starts[d].push_back(i);
+		if (starts[d].empty()) starts[d].push_back(0);
+	}
+	for (int k = 0; k < (int)starts[2].size(); k++ )
+		for (int j = 0; j < (int)starts[1].size(); j++ )
+			for (int i = 0; i < (int)starts[0].size(); i++ )
+			{
+				Grid_Cell cell;
+				int index[3] = { i, j, k };
+				for (int d = 0; d < 3; d++ )
 				{
-					error_msg.append(" QPP solution conversion to Linear Failure.");
-					return false;
+					cell.lower[d] = starts[d][index[d]];
+					cell.upper[d] = std::min(cell.lower[d] + coarse_step, dims[d] - 1);
 				}
+				cells.push_back(cell);
 			}
+	std::vector<long long> queue;
+	for (int c = 0; c < (int)cells.size(); c++ )
+		for (int corner = 0; corner < 8; corner++ )
+		{
+			long long n = _corner_node(cells[c], corner, dims);
+			if (state[n] == 0)
+			{
+				state[n] = 2;
+				queue.push_back(n);
+			}
+		}
 
-			int N = (int)b_input.evaluation_pts->size();
-			int add = 0;
-			int vv = round((double)N / 72.0); // 72.0 is the width of the progress bar 
-			double factor = (100.0*(double)vv) / (double)N;
+	// refine the cells that may hold an iso value one level at a time, the new corners of a level evaluated together
+	std::vector<Grid_Cell> far_cells;
+	while (true)
+	{
+		std::sort(queue.begin(), queue.end());
+		_evaluate_grid_nodes(evaluator, origin, spacing, dims, queue.empty() ? NULL : &queue[0], (long long)queue.size(), out, false);
+		for (size_t q = 0; q < queue.size(); q++ ) state[queue[q]] = 1;
+		queue.clear();
 
-			#pragma omp parallel for schedule(dynamic)
-			for (int j = 0; j < N; j++ ){
-				eval_scalar_interpolant_at_point(b_input.evaluation_pts->at(j));
-				//eval_vector_interpolant_at_point(b_input.evaluation_pts->at(j));
-				if ( j % vv == 0 )
+		// cells with nodes between their corners, and their centers with the gradient
+		std::vector<Grid_Cell> split_cells;
+		for (int c = 0; c < (int)cells.size(); c++ )
+		{
+			const Grid_Cell &cell = cells[c];
+			if (cell.upper[0] - cell.lower[0] > 1 || cell.upper[1] - cell.lower[1] > 1 || cell.upper[2] - cell.lower[2] > 1)
+				split_cells.push_back(cell);
+		}
+		cells.swap(split_cells);
+		if (cells.empty()) break;
+		std::vector<Evaluation_Point> centers;
+		for (int c = 0; c < (int)cells.size(); c++ )
+		{
+			double p[3];
+			for (int d = 0; d < 3; d++ ) p[d] = origin[d] + 0.5*(cells[c].lower[d] + cells[c].upper[d])*spacing[d];
+			centers.push_back(Evaluation_Point(p[0], p[1], p[2]));
+		}
+		int n_blocks = ((int)centers.size() + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+		#pragma omp parallel for schedule(dynamic)
+		for (int b = 0; b < n_blocks; b++ )
+			evaluator->evaluate(centers, b*Tiled_Evaluator::point_block, std::min((int)centers.size(), (b + 1)*Tiled_Evaluator::point_block), true);
+
+		std::vector<Grid_Cell> children;
+		for (int c = 0; c < (int)cells.size(); c++ )
+		{
+			const Grid_Cell &cell = cells[c];
+			if (!_may_cross(cell, out, dims, spacing, iso_values, centers[c], hessian, safety))
+			{
+				far_cells.push_back(cell);
+				continue;
+			}
+			// split the axes longer than one node spacing in halves
+			int split[3][3];
+			int n_parts[3];
+			for (int d = 0; d < 3; d++ )
+			{
+				split[d][0] = cell.lower[d];
+				if (cell.upper[d] - cell.lower[d] > 1)
 				{
-#pragma omp atomic
-					add++;
-					int step = factor * add;
-#pragma omp critical
-					_Progress(" Computing Scalar field: ", step, 100 );
+					split[d][1] = (cell.lower[d] + cell.upper[d]) / 2;
+					split[d][2] = cell.upper[d];
+					n_parts[d] = 2;
+				}
+				else
+				{
+					split[d][1] = cell.upper[d];
+					n_parts[d] = 1;
 				}
 			}
-			cout<<endl;
+			for (int k = 0; k < n_parts[2]; k++ )
+				for (int j = 0; j < n_parts[1]; j++ )
+					for (int i = 0; i < n_parts[0]; i++ )
+					{
+						Grid_Cell child;
+						int part[3] = { i, j, k };
+						for (int d = 0; d < 3; d++ )
+						{
+							child.lower[d] = split[d][part[d]];
+							child.upper[d] = split[d][part[d] + 1];
+						}
+						for (int corner = 0; corner < 8; corner++ )
+						{
+							long long n = _corner_node(child, corner, dims);
+							if (state[n] == 0)
+							{
+								state[n] = 2;
+								queue.push_back(n);
+							}
+						}
+						children.push_back(child);
+					}
 		}
+		cells.swap(children);
+	}
+
+	// nodes left inside the cells without iso surfaces: trilinear interpolation of the corners. The leaf cells tile the
+	// grid, a node on a face shared by several of them belongs to the cell it is a lower corner of (upper corners only on
+	// the last node of an axis), so that every node is written by one thread
+	#pragma omp parallel for schedule(dynamic)
+	for (int c = 0; c < (int)far_cells.size(); c++ )
+	{
+		const Grid_Cell &cell = far_cells[c];
+		double f[8];
+		for (int corner = 0; corner < 8; corner++ ) f[corner] = (double)out[_corner_node(cell, corner, dims)];
+		int last[3];
+		for (int d = 0; d < 3; d++ ) last[d] = (cell.upper[d] == dims[d] - 1) ? cell.upper[d] : cell.upper[d] - 1;
+		for (int k = cell.lower[2]; k <= last[2]; k++ )
+			for (int j = cell.lower[1]; j <= last[1]; j++ )
+				for (int i = cell.lower[0]; i <= last[0]; i++ )
+				{
+					long long n = i + dims[0]*(j + (long long)dims[1]*k);
+					if (state[n] == 1) continue;
+					double t[3];
+					int index[3] = { i, j, k };
+					for (int d = 0; d < 3; d++ )
+						t[d] = (cell.upper[d] > cell.lower[d]) ? (double)(index[d] - cell.lower[d]) / (cell.upper[d] - cell.lower[d]) : 0.0;
+					double value = 0.0;
+					for (int corner = 0; corner < 8; corner++ )
+					{
+						double weight = 1.0;
+						for (int d = 0; d < 3; d++ ) weight *= (corner & (1 << d)) ? t[d] : 1.0 - t[d];
+						value += weight*f[corner];
+					}
+					out[n] = (T)value;
+				}
 	}
+	long long n_evaluated = 0;
+	for (long long n = 0; n < N; n++ )
+	{
+		if (state[n] == 1) n_evaluated++;
+		if (evaluated != NULL) evaluated[n] = (state[n] == 1) ? 1 : 0;
+	}
+	cout<<" Computing Scalar field near the iso surfaces: "<<n_evaluated<<" of "<<N<<" nodes evaluated"<<endl;
+	if (evaluator != NULL) delete evaluator;
+	return true;
+}
+
+bool GRBF_Modelling_Methods::evaluate_on_grid(const double origin[3], const double spacing[3], const int dims[3], double *out)
+{
+	return _evaluate_on_grid(origin, spacing, dims, out);
+}
+
+bool GRBF_Modelling_Methods::evaluate_on_grid(const double origin[3], const double spacing[3], const int dims[3], float *out)
+{
+	return _evaluate_on_grid(origin, spacing, dims, out);
+}
+
+bool GRBF_Modelling_Methods::evaluate_on_grid_near_iso(const double origin[3], const double spacing[3], const int dims[3], double *out,
+	unsigned char *evaluated, const int &coarse_step, const double &safety)
+{
+	return _evaluate_on_grid_near_iso(origin, spacing, dims, out, evaluated, coarse_step, safety);
+}
+
+bool GRBF_Modelling_Methods::evaluate_on_grid_near_iso(const double origin[3], const double spacing[3], const int dims[3], float *out,
+	unsigned char *evaluated, const int &coarse_step, const double &safety)
+{
+	return _evaluate_on_grid_near_iso(origin, spacing, dims, out, evaluated, coarse_step, safety);
+}
+
+Evaluation_Tile_Cache *GRBF_Modelling_Methods::create_tile_cache(const double origin[3], const double spacing[3], const int &tile_size,
+	const size_t &max_bytes, const int &n_prefetch_threads)
+{
+	if (tile_size < 1)
+	{
+		error_msg.append(" Tile size must be positive.");
+		return NULL;
+	}
+	if (!_prepare_evaluation()) return NULL;
+	return new Evaluation_Tile_Cache(this, get_tiled_evaluator(), origin, spacing, tile_size, max_bytes, n_prefetch_threads);
+}
+
+bool GRBF_Modelling_Methods::classify_on_grid(const double origin[3], const double spacing[3], const int dims[3], unsigned char *units)
+{
+	if (n_scalar_fields() != 1 || b_input.interface_iso_values == NULL || b_input.interface_iso_values->empty() ||
+		b_input.interface_iso_values->size() > 255)
+	{
+		error_msg.append(" Classification needs a single scalar field with 1 to 255 interface iso values.");
+		return false;
+	}
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0)
+	{
+		error_msg.append(" Empty evaluation grid.");
+		return false;
+	}
+	if (!_prepare_evaluation()) return false;
+
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	_evaluation_error = 0.0;
+	std::vector<double> iso_values = *b_input.interface_iso_values;
+	std::sort(iso_values.begin(), iso_values.end());
+	if (evaluator != NULL)
+	{
+		Lithology_Classifier classifier(*evaluator);
+		if (classifier.supported() && classifier.classify_grid(origin, spacing, dims, iso_values, units))
+		{
+			cout<<" Classifying grid nodes: "<<std::setprecision(3)<<100.0*classifier.exact_fraction()<<"% of the kernel sums computed"<<endl;
+			delete evaluator;
+			return true;
+		}
+	}
+	// exact field, one plane of nodes at a time
+	int plane_dims[3] = { dims[0], dims[1], 1 };
+	int n_plane = dims[0]*dims[1];
+	std::vector<double> plane(n_plane);
+	for (int k = 0; k < dims[2]; k++ ){
+		double plane_origin[3] = { origin[0], origin[1], origin[2] + k*spacing[2] };
+		_evaluate_grid_nodes(evaluator, plane_origin, spacing, plane_dims, (const long long *)NULL, n_plane, &plane[0], false);
+		for (int n = 0; n < n_plane; n++ )
+			units[(size_t)k*n_plane + n] = (unsigned char)(std::upper_bound(iso_values.begin(), iso_values.end(), plane[n]) - iso_values.begin());
+		_Progress(" Classifying grid nodes: ", (100*(k + 1)) / dims[2], 100 );
+	}
+	cout<<endl;
+	if (evaluator != NULL) delete evaluator;
+	return true;
+}
+
+bool GRBF_Modelling_Methods::extract_iso_surfaces(const double origin[3], const double spacing[3], const int dims[3], std::vector<Iso_Surface_Mesh> &meshes)
+{
+	if (n_scalar_fields() != 1 || b_input.interface_iso_values == NULL || b_input.interface_iso_values->empty())
+	{
+		error_msg.append(" Iso surfaces need a single scalar field with interface iso values.");
+		return false;
+	}
+	if (dims[0] < 2 || dims[1] < 2 || dims[2] < 2)
+	{
+		error_msg.append(" Iso surface grid needs at least 2 nodes along each axis.");
+		return false;
+	}
+	if (!_prepare_evaluation()) return false;
+
+	Tiled_Evaluator *evaluator = get_tiled_evaluator();
+	_evaluation_error = 0.0;
+	Iso_Surface_Extractor extractor(origin, spacing, dims, *b_input.interface_iso_values);
+	std::vector<Iso_Surface_Mesh> &surfaces = extractor.meshes();
+	std::vector<double> plane(dims[0]*dims[1]);
+	int plane_dims[3] = { dims[0], dims[1], 1 };
+	for (int k = 0; k < dims[2]; k++ )
+	{
+		double plane_origin[3] = { origin[0], origin[1], origin[2] + k*spacing[2] };
+		_evaluate_grid_nodes(evaluator, plane_origin, spacing, plane_dims, (const long long *)NULL, dims[0]*dims[1], &plane[0], false);
+		extractor.add_plane(&plane[0]);
+		// normals of the new vertices: gradients from the evaluator in blocks, point by point without one
+		for (int s = 0; s < (int)surfaces.size(); s++ )
+		{
+			Iso_Surface_Mesh &mesh = surfaces[s];
+			int first = (int)mesh.normals.size() / 3;
+			mesh.normals.resize(mesh.vertices.size());
+			std::vector<Evaluation_Point> pts;
+			for (int v = first; v < mesh.n_vertices(); v++ ) pts.push_back(Evaluation_Point(mesh.vertices[3*v], mesh.vertices[3*v + 1], mesh.vertices[3*v + 2]));
+			if (evaluator != NULL)
+			{
+				int n_blocks = ((int)pts.size() + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+				#pragma omp parallel for schedule(dynamic)
+				for (int b = 0; b < n_blocks; b++ )
+					evaluator->evaluate(pts, b*Tiled_Evaluator::point_block, std::min((int)pts.size(), (b + 1)*Tiled_Evaluator::point_block), true);
+			}
+			else
+			{
+				#pragma omp parallel for schedule(dynamic, 64)
+				for (int v = 0; v < (int)pts.size(); v++ ) eval_vector_interpolant_at_point(pts[v]);
+			}
+			for (int v = 0; v < (int)pts.size(); v++ ){
+				Evaluation_Point &p = pts[v];
+				double norm = sqrt(p.nx_interp()*p.nx_interp() + p.ny_interp()*p.ny_interp() + p.nz_interp()*p.nz_interp());
+				if (norm == 0.0) norm = 1.0;
+				mesh.normals[3*(first + v)] = p.nx_interp() / norm;
+				mesh.normals[3*(first + v) + 1] = p.ny_interp() / norm;
+				mesh.normals[3*(first + v) + 2] = p.nz_interp() / norm;
+			}
+		}
+		_Progress(" Extracting iso surfaces: ", (100*(k + 1)) / dims[2], 100 );
+	}
+	cout<<endl;
+	meshes.swap(surfaces);
+	if (evaluator != NULL) delete evaluator;
 	return true;
 }
 
@@ -220,6 +1282,36 @@ bool GRBF_Modelling_Methods::run_algorithm()
 		return false;
 	}
 	cout<<"done!"<<endl;
+	if (m_parameters.auto_shape_parameter && b_parameters.problem_type == Parameter_Types::Linear &&
+		rbf_kernel->set_shape_parameter(m_parameters.shape_parameter))
+	{
+		cout<<" Leave one out cross validation of the shape parameter..."<<endl;
+		// search range from the extent of the constraints, in the units of the kernel's parameter: 1/length for
+		// the Gaussian exp(-(e r)^2), length^2 for MQ and IMQ (c + r^2)^(+-1/2). Anisotropic kernels measure
+		// r in the transformed space, so the extent says nothing about their parameter and they are not searched
+		double extent = _constraint_extent();
+		double lower = 0.0, upper = 0.0;
+		if (extent > 0.0 && !m_parameters.model_global_anisotropy)
+		{
+			if (m_parameters.basis_type == Parameter_Types::Gaussian)
+			{
+				lower = 0.1/extent;
+				upper = 100.0/extent;
+			}
+			else if (m_parameters.basis_type == Parameter_Types::MQ || m_parameters.basis_type == Parameter_Types::IMQ)
+			{
+				lower = (0.1*extent)*(0.1*extent);
+				upper = (100.0*extent)*(100.0*extent);
+			}
+		}
+		double shape_parameter = m_parameters.shape_parameter;
+		double loocv_error = 0.0;
+		if (upper > 0.0 && optimize_shape_parameter(lower, upper, shape_parameter, loocv_error))
+		{
+			cout<<" Shape parameter = "<<shape_parameter<<", RMS leave one out error = "<<loocv_error<<endl;
+		}
+		else cout<<" Leave one out cross validation failed, keeping shape parameter = "<<m_parameters.shape_parameter<<endl;
+	}
 	cout<<" Solve mathematical problem...";
 	if (!setup_system_solver())
 	{
@@ -40,11 +40,29 @@
 #include <modelling_input.h>
 #include <matrix_solver.h>
 #include <basis.h>
+#include <tiled_evaluation.h>
+#include <iso_surface.h>
+#include <tile_cache.h>
 #include <Eigen/Core>
 
+#include <string>
+#include <functional>
+
 using namespace std;
 using namespace Eigen;
 
+// Pairwise geometry of the center block of an interpolation matrix whose rows and columns are point values or
+// directional derivatives of an isotropic kernel: the block for another radial profile (e.g. a new shape parameter)
+// is assembled without going through the constraints again
+struct SURFE_LIB_EXPORT Radial_Matrix_Geometry {
+	MatrixXd r2; // squared distances between the constraint points
+	MatrixXd offsets; // offsets(i,j) = (p_i - p_j).v_j, v_j the direction of a derivative constraint j, 0 for point values
+	MatrixXd directions; // 3 x n, v_j
+	std::vector<bool> derivative; // constraint j is the derivative along v_j
+	// writes the block with the radial profile of kernel to the top left of matrix, false if the kernel is not isotropic
+	bool assemble(const RBFKernel *kernel, MatrixXd &matrix) const;
+};
+
 // Abstract base class
 class SURFE_LIB_EXPORT GRBF_Modelling_Methods {
 protected:
@@ -53,12 +71,47 @@ protected:
 	basic_parameters b_parameters; // algorithm parameters
 	Basic_input b_input; // algorithm input
 	int _iteration; // for greedy progress
+	double _evaluation_error; // estimated maximum error of the last scalar field evaluation, 0 if exact
 	// METHODS
 	bool _update_interface_iso_values(); // this is to prep for output. Is the computed scalar field value using the interpolant @ interface_test_points for iso surface extraction
-	void _Progress(char message[], const int &step, const int &total);
+	void _Progress(const char *message, const int &step, const int &total);
 	bool _output_greedy_debug_objects();
 	void _SetIteration(const int &iter) { _iteration = iter; }
+	double _constraint_extent(); // diagonal of the bounding box of the constraints
+	// RMS leave one out residual, infinity on failure. With a geometry only its block of interpolation_matrix is assembled
+	// again, otherwise the whole matrix
+	double _leave_one_out_error(const double &shape_parameter, const Radial_Matrix_Geometry *geometry, MatrixXd &interpolation_matrix,
+		const VectorXd &equality_values);
+	// Rippa's residuals of the first n_e rows of the system
+	static bool _leave_one_out_residuals(const MatrixXd &interpolation_matrix, const VectorXd &equality_values, const int &n_e,
+		VectorXd &residuals);
+	// false if the interpolation matrix is not made of point values and derivatives of rbf_kernel
+	virtual bool _get_radial_matrix_geometry(Radial_Matrix_Geometry &) { return false; }
+	// modified kernel solution rewritten for the plain rbf kernel without a new solve: the weights of the constraints are
+	// unchanged, plus point centers at the unisolvent points of the Lagrange basis and a linear polynomial (x, y, z, 1)
+	bool _expand_modified_kernel(std::vector<Interface> &centers, VectorXd &center_weights, VectorXd &poly_weights);
+	// b_input.itrface indices of the unisolvent points of the modified kernel, false if one is not an interface point
+	bool _unisolvent_interface_indices(std::vector<int> &indices);
+	// empty evaluator for the kernel, NULL if the kernel can not be evaluated in tiles
+	Tiled_Evaluator *_new_tiled_evaluator(const int &n_fields = 1);
+	// false if there is no solution to evaluate. Modified kernel solutions are converted to the rbf kernel first
+	bool _prepare_evaluation();
+	// nodes[0, n) of the grid (all the nodes if nodes is NULL) with the evaluator, point by point if NULL
+	template <typename T> void _evaluate_grid_nodes(const Tiled_Evaluator *evaluator, const double *origin, const double *spacing, const int *dims,
+		const long long *nodes, const long long &n, T *out, const bool &progress, T *gradients = NULL);
+	template <typename T> bool _evaluate_on_grid(const double *origin, const double *spacing, const int *dims, T *out);
+	// n_points points evaluated a chunk at a time: load(first, n, xyz) gives the coordinates of points [first, first + n)
+	// and runs while the previous chunk is evaluated, the values of a chunk are written while the next one is evaluated
+	bool _evaluate_stream(const long long &n_points, const std::function<bool(const long long &, const int &, double *)> &load,
+		const std::string &output_file, const int &chunk_size, const bool &single_precision);
+	template <typename T> static bool _evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double *origin,
+		const double *spacing, const int *dims, T *out);
+	template <typename T> bool _evaluate_gradient_on_grid(const double *origin, const double *spacing, const int *dims, T *out, T *gradients,
+		T *dip, T *strike);
+	template <typename T> bool _evaluate_on_grid_near_iso(const double *origin, const double *spacing, const int *dims, T *out,
+		unsigned char *evaluated, const int &coarse_step, const double &safety);
 public:
+	GRBF_Modelling_Methods() : _evaluation_error(0.0) {}
 	// Destructor
 	virtual ~GRBF_Modelling_Methods(){}
 	// Methods
@@ -71,9 +124,75 @@ public:
 	bool setup_basis_functions();
 	bool check_interpolant();
 	bool evaluate_scalar_interpolant();
+	// scalar field(s) and vector field (gradient) of the evaluation points in one pass over the centers
+	bool evaluate_scalar_and_vector_interpolant();
+	double evaluation_error_estimate() const { return _evaluation_error; }
+	// scalar field(s) at the nodes of the regular grid origin + (i, j, k)*spacing, 0 <= i < dims[0] ..., without
+	// evaluation points: node i + dims[0]*(j + dims[1]*k) is written to out[node*n_scalar_fields() + field].
+	// out is allocated by the caller
+	bool evaluate_on_grid(const double origin[3], const double spacing[3], const int dims[3], double *out);
+	bool evaluate_on_grid(const double origin[3], const double spacing[3], const int dims[3], float *out);
+	// out of core evaluation of the points of a binary file of x, y, z doubles: n_scalar_fields() values per point are
+	// written to output_file (doubles, or floats if single_precision; created or overwritten). Memory is bounded by
+	// chunk_size points whatever the file size: a chunk is evaluated while the next one is read and the previous one
+	// written, each through a memory mapped view
+	bool evaluate_file(const std::string &points_file, const std::string &output_file, const int &chunk_size = 1048576,
+		const bool &single_precision = false);
+	// same for the nodes of a regular grid (see evaluate_on_grid), generated chunk by chunk
+	bool evaluate_grid_to_file(const double origin[3], const double spacing[3], const int dims[3], const std::string &output_file,
+		const int &chunk_size = 1048576, const bool &single_precision = false);
+	// query service for interactive viewers over the solved interpolant (caller deletes, before changing or deleting the
+	// interpolant): tiles of tile_size^3 nodes of the grids origin + (i, j, k)*spacing*2^level evaluated on demand, at most
+	// max_bytes of them cached, the neighbours of a query prefetched by n_prefetch_threads. NULL if there is no solution
+	Evaluation_Tile_Cache *create_tile_cache(const double origin[3], const double spacing[3], const int &tile_size = 32,
+		const size_t &max_bytes = 268435456, const int &n_prefetch_threads = 2);
+	// several solved interpolants on the same grid: out[node*K + k], K the total # of their scalar fields, in order.
+	// Isotropic kernels that are the same for all are evaluated once per node and center in common (e.g. realisations
+	// of one data set), each kernel value reaching every interpolant through a small weight matrix. Otherwise each
+	// interpolant is evaluated in turn
+	static bool evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double origin[3], const double spacing[3],
+		const int dims[3], double *out);
+	static bool evaluate_batch_on_grid(const std::vector<GRBF_Modelling_Methods *> &methods, const double origin[3], const double spacing[3],
+		const int dims[3], float *out);
+	// evaluate_on_grid plus the gradients, gradients[(node*n_scalar_fields() + field)*3 + axis], from the same sweep over
+	// the centers. dip and strike (optional, degrees, one per node and field) of the planes normal to the gradients,
+	// gradients may be NULL then
+	bool evaluate_gradient_on_grid(const double origin[3], const double spacing[3], const int dims[3], double *out, double *gradients,
+		double *dip = NULL, double *strike = NULL);
+	bool evaluate_gradient_on_grid(const double origin[3], const double spacing[3], const int dims[3], float *out, float *gradients,
+		float *dip = NULL, float *strike = NULL);
+	// unit of every node of the regular grid of evaluate_on_grid: units[node] = # of interface iso values <= scalar field.
+	// Single scalar field interpolants with at most 255 iso values. Far from the contacts a node stops as soon as its unit
+	// is certain, from bounds on the centers not summed yet (Lithology_Classifier). Where that does not pay (e.g. kernels
+	// growing with the distance) or is not supported, the field is evaluated one plane of nodes at a time
+	bool classify_on_grid(const double origin[3], const double spacing[3], const int dims[3], unsigned char *units);
+	// triangle meshes of the interface iso surfaces on the regular grid of evaluate_on_grid, by marching tetrahedra while
+	// the grid is evaluated one plane of nodes at a time: two planes are held, not the grid. Vertex normals are the
+	// normalized gradients of the interpolant. Single scalar field interpolants
+	bool extract_iso_surfaces(const double origin[3], const double spacing[3], const int dims[3], std::vector<Iso_Surface_Mesh> &meshes);
+	// evaluate_on_grid for iso surface extraction: an octree of cells of coarse_step nodes is refined only where a cell may
+	// hold one of the interface iso values, judged from the value and gradient at its center. Cells of more than 4 node
+	// spacings add the kernel's bound on the Hessian of the field (Tiled_Evaluator::hessian_bound): with safety >= 1 such a
+	// cell is skipped only if it can not hold an iso value. Smaller cells only add the first order change, so for them
+	// safety is the only guard against curvature, and a feature thinner than a few nodes can be interpolated away. The
+	// other nodes are trilinear interpolations of the corners of their cell, evaluated[node] (optional) is 0 for those.
+	// Single scalar field interpolants with iso values and an isotropic kernel, evaluate_on_grid otherwise
+	bool evaluate_on_grid_near_iso(const double origin[3], const double spacing[3], const int dims[3], double *out,
+		unsigned char *evaluated = NULL, const int &coarse_step = 16, const double &safety = 2.0);
+	bool evaluate_on_grid_near_iso(const double origin[3], const double spacing[3], const int dims[3], float *out,
+		unsigned char *evaluated = NULL, const int &coarse_step = 16, const double &safety = 2.0);
+	// # of scalar fields of the interpolant
+	virtual int n_scalar_fields() const { return 1; }
 	bool evaluate_vector_interpolant();
 	bool run_algorithm();
 	bool run_greedy_algorithm();
+	// leave one out residuals of the equality constraints from one factorization (Rippa): e_i = c_i/(A-1)ii.
+	// Linear problems, after the basis functions are set up.
+	bool leave_one_out_residuals(VectorXd &residuals);
+	// shape parameter in [lower, upper] minimizing the RMS leave one out residual (log spaced scan, then golden
+	// section search). The processed input and the kernel (e.g. the modified basis) are shared by all the trials, and
+	// where the method supports it the pairwise geometry of the constraints as well (Radial_Matrix_Geometry)
+	bool optimize_shape_parameter(const double &lower, const double &upper, double &shape_parameter, double &loocv_error);
 	bool get_equality_matrix(const MatrixXd &interpolation_matrix, MatrixXd &equality_matrix);
 	virtual bool get_interpolation_matrix(MatrixXd &interpolation_matrix) = 0;
 	virtual bool get_equality_values(VectorXd &equality_values) = 0;
@@ -87,6 +206,9 @@ public:
 	virtual bool append_greedy_input(Basic_input &input) = 0;
 	virtual bool convert_modified_kernel_to_rbf_kernel() = 0;
 	virtual GRBF_Modelling_Methods *clone() = 0;
+	// centers and weights of the solved interpolant packed for tiled evaluation (caller deletes),
+	// NULL if the method or the kernel is not supported: evaluation then goes point by point
+	virtual Tiled_Evaluator *get_tiled_evaluator() { return NULL; }
 	// Attributes
 	System_Solver *solver;
 	Kernel *kernel;
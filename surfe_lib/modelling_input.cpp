@@ -503,6 +503,34 @@ int furtherest_neighbour_index( const std::vector < Point > &pts1, const std::ve
 	return index;
 }
 
+void farthest_point_order( const std::vector < Point > &pts, const int &n, std::vector<int> &order, std::vector<double> &radius )
+{
+	order.clear();
+	radius.clear();
+	int N = (int)pts.size();
+	if (N == 0) return;
+
+	std::vector<double> distance(N, DBL_MAX); // to the closest point already in the order, -1 once in the order
+	int next = 0;
+	for (int k = 0; k < std::min(n, N); k++ ){
+		order.push_back(next);
+		radius.push_back(distance[next]);
+		distance[next] = -1.0;
+		int current = next;
+		double farthest = -1.0;
+		for (int j = 0; j < N; j++ ){
+			if (distance[j] < 0.0) continue;
+			double dist = distance_btw_pts(pts[current], pts[j]);
+			if (dist < distance[j]) distance[j] = dist;
+			if (distance[j] > farthest)
+			{
+				farthest = distance[j];
+				next = j;
+			}
+		}
+	}
+}
+
 double avg_nn_distance( const std::vector < Point > &pts )
 {
 	double average_nn_distance = 0.0;
@@ -67,6 +67,7 @@ public:
 	void set_scalar_field(const double &scalar_field_value) { _scalar_field = scalar_field_value; }
 	double scalar_field(const int &i) const { return _field[i]; }
 	void set_scalar_field_list(const double &scalar_field_value) { _field.push_back(scalar_field_value); }
+	void set_scalar_fields(const std::vector<double> &scalar_field_values) { _field = scalar_field_values; }
 	int get_field_list_size() { return (int)_field.size(); }
 	void set_vector_field(const double &nx, const double &ny, const double &nz) { _field_normal[0] = nx; _field_normal[1] = ny; _field_normal[2] = nz; }
 	double nx_interp() const { return _field_normal[0]; }
@@ -90,6 +91,7 @@ private:
 	double _level;
 	double _residual;
 	double _level_bound[2];
+	std::vector<double> _property_values; // several properties sampled at this point (empty: level() only)
 public:
 	Interface(const double &x_coord,
 		const double &y_coord,
@@ -107,7 +109,11 @@ public:
 	double level_lower_bound() const { return _level_bound[0]; }
 	double level_upper_bound() const { return _level_bound[1]; }
 	void setResidual(const double &res) { _residual = res; }
-	void setLevel(const double &v) { _level = v; }
+	void setLevel(const double &v) { _level = v; if (!_property_values.empty()) _property_values[0] = v; }
+	// multiple properties (e.g. assay grades and densities) at the same location. level() is the first property
+	int n_properties() const { return _property_values.empty() ? 1 : (int)_property_values.size(); }
+	double property_value(const int &i) const { return _property_values.empty() ? _level : _property_values[i]; }
+	void setPropertyValues(const std::vector<double> &values) { _property_values = values; if (!values.empty()) _level = values[0]; }
 	void setLevelBounds(const double &level_uncertainty) { _level_bound[0] = -1.0*level_uncertainty; _level_bound[1] = level_uncertainty; }
 };
 
@@ -324,6 +330,9 @@ std::vector<int> get_n_nearest_neighbours_to_point(const int &n, const Point &p,
 int furtherest_neighbour_index(const Point &p, const std::vector < Point > &pts);
 int furtherest_neighbour_index(const std::vector < Point > &pts1, const std::vector < Point > &pts2);
 double avg_nn_distance(const std::vector < Point > &pts);
+// first n points of a farthest point ordering of pts (each point is the farthest from the ones before it), O(N n).
+// radius[k] is the distance from pts[order[k]] to the points before it: the fill distance of the first k points (radius[0] = DBL_MAX)
+void farthest_point_order(const std::vector < Point > &pts, const int &n, std::vector<int> &order, std::vector<double> &radius);
 bool Find_STL_Vector_Indices_FurtherestTwoPoints(const std::vector< Point> &pts, int (&TwoIndexes)[2]);
 int Find_STL_Vector_Index_ofPointClosestToOtherPointWithinDistance(const Point &p, const std::vector< Point > &pts, const double &dist);
 void calculate_bounds(const std::vector< Point > &pts, double (&bounds)[6]);
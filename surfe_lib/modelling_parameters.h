@@ -36,6 +36,8 @@
 
 #include <surfe_lib_module.h>
 
+#include <string>
+
 #define D2R 0.01745329251994329576923690768489 // degrees to radians conversion factor
 #define R2D 57.295779513082320876798154814105  // radians to degrees conversion factor
 
@@ -45,6 +47,8 @@ struct SURFE_LIB_EXPORT Parameter_Types{
 	enum FirstDerivatives {DX,DY,DZ};
 	enum RBF {Cubic,Gaussian,MQ,IMQ,TPS,R};
 	enum SolverType {Linear,Quadratic};
+	enum QPSolver {Interior_point,Active_set,Automatic};
+	enum LinearSolver {Dense_LU,Dense_Cholesky,Iterative_Krylov,Sparse_LU,Automatic_selection};
 	enum ModelType {Single_surface,Lajaunie_approach,Stratigraphic_horizons,Continuous_property,Vector_field};
 	enum AXIS {Xaxis,Yaxis,Zaxis};
 };
@@ -73,12 +77,36 @@ struct SURFE_LIB_EXPORT model_parameters{
 	bool use_restricted_range;
 	double interface_uncertainty;
 	double angular_uncertainty;
+	// quadratic (inequality) problems: interior point by default, automatic (opt-in) uses the active set
+	// solver when there are few inequalities
+	Parameter_Types::QPSolver qp_solver;
+	// linear problems: automatic selection picks the solver from the size, structure and conditioning of the system
+	Parameter_Types::LinearSolver linear_solver;
+	// linear problems: factor in float32 and recover double accuracy by iterative refinement
+	bool use_mixed_precision;
+	// isotropic Gaussian, MQ and IMQ linear problems: choose the shape parameter by leave one out cross validation
+	bool auto_shape_parameter;
+	// linear problems: matrices larger than this are factored out of core in a scratch file (0: a quarter of the physical memory)
+	double out_of_core_memory_mb;
+	// directory of the out of core scratch file (empty: system temporary directory)
+	std::string scratch_directory;
+	// linear single surface problems with more constraint locations than this are fitted by least squares with the weights
+	// of this many centers (farthest point sampling of the constraint locations). 0: every constraint is a center
+	int reduced_centers;
+	// relative ridge regularization of the reduced center weights
+	double reduced_center_regularization;
+	// evaluation grids: maximum absolute error allowed in the scalar field for the approximate treecode evaluation
+	// (0: exact evaluation)
+	double evaluation_tolerance;
 
 	// initialization ...
 	model_parameters() : model_type(Parameter_Types::Single_surface), min_stratigraphic_thickness(0),
 		use_interface_data(true), use_planar_data(true), use_tangent(false), use_inequality(false),
 		basis_type(Parameter_Types::Cubic), shape_parameter(100), polynomial_order(1),
-		advanced_parameters(false), model_global_anisotropy(false), use_greedy(false), use_restricted_range(false), interface_uncertainty(0), angular_uncertainty(0) {}
+		advanced_parameters(false), model_global_anisotropy(false), use_greedy(false), use_restricted_range(false), interface_uncertainty(0), angular_uncertainty(0),
+		qp_solver(Parameter_Types::Interior_point), linear_solver(Parameter_Types::Automatic_selection), use_mixed_precision(false),
+		auto_shape_parameter(false), out_of_core_memory_mb(0), reduced_centers(0), reduced_center_regularization(1e-10),
+		evaluation_tolerance(0) {}
 };
 
 struct SURFE_LIB_EXPORT basic_parameters{
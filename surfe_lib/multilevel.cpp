@@ -0,0 +1,285 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <multilevel.h>
+#include <single_surface.h>
+#include <continuous_property.h>
+
+#include <iostream>
+#include <cmath>
+#include <algorithm>
+
+// a method keeps a shallow copy of its input and frees the vectors: only the Basic_input itself is deleted here
+static void _release_input(Basic_input *input)
+{
+	input->inequality = NULL;
+	input->itrface = NULL;
+	input->planar = NULL;
+	input->tangent = NULL;
+	input->evaluation_pts = NULL;
+	input->interface_iso_values = NULL;
+	input->interface_point_lists = NULL;
+	input->interface_test_points = NULL;
+	delete input;
+}
+
+Multilevel_Modelling::Multilevel_Modelling(const model_parameters &m_p, const Basic_input &basic_i, const multilevel_parameters &ml_p)
+{
+	_m_parameters = m_p;
+	_b_input = basic_i;
+	_ml_parameters = ml_p;
+}
+
+Multilevel_Modelling::~Multilevel_Modelling()
+{
+	for (int j = 0; j < (int)_levels.size(); j++ ) delete _levels[j];
+}
+
+bool Multilevel_Modelling::_setup_levels()
+{
+	if (_m_parameters.model_type != Parameter_Types::Single_surface && _m_parameters.model_type != Parameter_Types::Continuous_property)
+	{
+		error_msg.append(" Multilevel modelling needs a single surface or continuous property model.");
+		return false;
+	}
+	// residuals are only defined for equality constraints, and anisotropic kernels would be built from residual normals
+	if ((int)_b_input.inequality->size() != 0 || _m_parameters.use_restricted_range || _m_parameters.model_global_anisotropy)
+	{
+		error_msg.append(" Multilevel modelling needs isotropic kernels and equality constraints only.");
+		return false;
+	}
+	if ((int)_b_input.itrface->size() < 2)
+	{
+		error_msg.append(" Multilevel modelling needs at least two interface points.");
+		return false;
+	}
+	if (_b_input.itrface->at(0).n_properties() != 1)
+	{
+		error_msg.append(" Multilevel modelling supports one property at a time.");
+		return false;
+	}
+
+	// nested levels: every level is a prefix of the farthest point order of the constraint locations
+	std::vector<Point> locations;
+	for (int j = 0; j < (int)_b_input.itrface->size(); j++ ) locations.push_back(_b_input.itrface->at(j));
+	for (int j = 0; j < (int)_b_input.planar->size(); j++ ) locations.push_back(_b_input.planar->at(j));
+	for (int j = 0; j < (int)_b_input.tangent->size(); j++ ) locations.push_back(_b_input.tangent->at(j));
+	int N = (int)locations.size();
+	farthest_point_order(locations, N, _order, _radius);
+
+	_level_sizes.clear();
+	_level_sizes.push_back(N);
+	int n = N;
+	double coarsening = std::max(_ml_parameters.coarsening, 1.5);
+	while ((int)_level_sizes.size() < _ml_parameters.max_levels && (int)ceil(n/coarsening) >= _ml_parameters.min_locations){
+		n = (int)ceil(n/coarsening);
+		_level_sizes.push_back(n);
+	}
+	std::reverse(_level_sizes.begin(), _level_sizes.end());
+
+	return true;
+}
+
+double Multilevel_Modelling::_level_shape_parameter(const int &level)
+{
+	// point spacing of the level: mean distance of the second half of its locations to the locations before them
+	// (the last one alone is closer to the smallest separation than to a typical one)
+	int n = _level_sizes[level];
+	double spacing = 0.0;
+	for (int j = n/2; j < n; j++ ) spacing += _radius[j];
+	spacing /= (n - n/2);
+	double scale = _ml_parameters.support*spacing;
+	if (scale <= 0.0) return _m_parameters.shape_parameter;
+
+	if (_m_parameters.basis_type == Parameter_Types::Gaussian) return 1.0/scale; // exp(-(e r)^2)
+	else if (_m_parameters.basis_type == Parameter_Types::MQ || _m_parameters.basis_type == Parameter_Types::IMQ) return scale*scale; // (c + r^2)^(+-1/2)
+	else return _m_parameters.shape_parameter; // scale free kernels (cubic, TPS, R)
+}
+
+bool Multilevel_Modelling::_get_level_input(const int &level, Basic_input &input)
+{
+	int n_i = (int)_b_input.itrface->size();
+	int n_p = (int)_b_input.planar->size();
+	int n = _level_sizes[level];
+
+	// interface points are required by the methods: at least two per level
+	std::vector<int> locations(_order.begin(), _order.begin() + n);
+	int n_interface = 0;
+	for (int j = 0; j < n; j++ ) if (_order[j] < n_i) n_interface++;
+	for (int j = n; j < (int)_order.size() && n_interface < 2; j++ ){
+		if (_order[j] < n_i)
+		{
+			locations.push_back(_order[j]);
+			n_interface++;
+		}
+	}
+	std::sort(locations.begin(), locations.end());
+
+	// constraint values are the residuals of the levels already solved
+	for (int j = 0; j < (int)locations.size(); j++ ){
+		int index = locations[j];
+		if (index < n_i)
+		{
+			Interface itrface = _b_input.itrface->at(index);
+			eval_scalar_interpolant_at_point(itrface);
+			itrface.setLevel(itrface.level() - itrface.scalar_field());
+			input.itrface->push_back(itrface);
+		}
+		else if (index < n_i + n_p)
+		{
+			Planar planar = _b_input.planar->at(index - n_i);
+			eval_vector_interpolant_at_point(planar);
+			planar.setNormal(planar.nx() - planar.nx_interp(), planar.ny() - planar.ny_interp(), planar.nz() - planar.nz_interp());
+			input.planar->push_back(planar);
+		}
+		else
+		{
+			Tangent tangent = _b_input.tangent->at(index - n_i - n_p);
+			eval_vector_interpolant_at_point(tangent);
+			double inner_product = tangent.tx()*tangent.nx_interp() + tangent.ty()*tangent.ny_interp() + tangent.tz()*tangent.nz_interp();
+			tangent.setInnerProductConstraint(tangent.inner_product_constraint() - inner_product);
+			input.tangent->push_back(tangent);
+		}
+	}
+
+	return true;
+}
+
+bool Multilevel_Modelling::solve_next_level()
+{
+	if (_level_sizes.empty() && !_setup_levels()) return false;
+	int level = (int)_levels.size();
+	if (level >= n_levels()) return false;
+
+	Basic_input *input = new Basic_input;
+	if (!_get_level_input(level, *input))
+	{
+		delete input;
+		return false;
+	}
+	int n = (int)(input->itrface->size() + input->planar->size() + input->tangent->size());
+
+	model_parameters parameters = _m_parameters;
+	parameters.shape_parameter = _level_shape_parameter(level);
+	parameters.use_greedy = false;
+	GRBF_Modelling_Methods *method;
+	if (parameters.model_type == Parameter_Types::Single_surface) method = new Single_Surface(parameters, *input);
+	else method = new Continuous_Property(parameters, *input);
+	_release_input(input);
+
+	cout<<" Multilevel: level "<<level + 1<<" of "<<n_levels()<<", "<<n<<" constraint locations, shape parameter = "<<parameters.shape_parameter<<endl;
+	if (!method->process_input_data() || !method->get_method_parameters() || !method->setup_basis_functions() || !method->setup_system_solver())
+	{
+		error_msg.append(" Multilevel level failure:");
+		error_msg.append(method->error_msg);
+		delete method;
+		return false;
+	}
+	_levels.push_back(method);
+	_shape_parameters.push_back(parameters.shape_parameter);
+
+	return true;
+}
+
+bool Multilevel_Modelling::run_algorithm()
+{
+	if (_level_sizes.empty() && !_setup_levels()) return false;
+	while (n_solved_levels() < n_levels()){
+		if (!solve_next_level()) return false;
+	}
+	cout<<" Multilevel: RMS constraint residual = "<<rms_residual()<<endl;
+
+	return evaluate_scalar_interpolant();
+}
+
+void Multilevel_Modelling::eval_scalar_interpolant_at_point(Point &p, const int &levels)
+{
+	int n = levels < 0 ? (int)_levels.size() : std::min(levels, (int)_levels.size());
+	double sum = 0.0;
+	for (int j = 0; j < n; j++ ){
+		_levels[j]->eval_scalar_interpolant_at_point(p);
+		sum += p.scalar_field();
+	}
+	p.set_scalar_field(sum);
+}
+
+void Multilevel_Modelling::eval_vector_interpolant_at_point(Point &p, const int &levels)
+{
+	int n = levels < 0 ? (int)_levels.size() : std::min(levels, (int)_levels.size());
+	double sum[3] = {0.0, 0.0, 0.0};
+	for (int j = 0; j < n; j++ ){
+		_levels[j]->eval_vector_interpolant_at_point(p);
+		sum[0] += p.nx_interp();
+		sum[1] += p.ny_interp();
+		sum[2] += p.nz_interp();
+	}
+	p.set_vector_field(sum[0], sum[1], sum[2]);
+}
+
+bool Multilevel_Modelling::evaluate_scalar_interpolant(const int &levels)
+{
+	if (_levels.empty()) return false;
+
+	int N = (int)_b_input.evaluation_pts->size();
+	#pragma omp parallel for schedule(dynamic)
+	for (int j = 0; j < N; j++ ) eval_scalar_interpolant_at_point(_b_input.evaluation_pts->at(j), levels);
+
+	return true;
+}
+
+double Multilevel_Modelling::rms_residual()
+{
+	double sum = 0.0;
+	int n = 0;
+	for (int j = 0; j < (int)_b_input.itrface->size(); j++ ){
+		Interface itrface = _b_input.itrface->at(j);
+		eval_scalar_interpolant_at_point(itrface);
+		sum += pow(itrface.level() - itrface.scalar_field(), 2);
+		n++;
+	}
+	for (int j = 0; j < (int)_b_input.planar->size(); j++ ){
+		Planar planar = _b_input.planar->at(j);
+		eval_vector_interpolant_at_point(planar);
+		sum += pow(planar.nx() - planar.nx_interp(), 2) + pow(planar.ny() - planar.ny_interp(), 2) + pow(planar.nz() - planar.nz_interp(), 2);
+		n += 3;
+	}
+	for (int j = 0; j < (int)_b_input.tangent->size(); j++ ){
+		Tangent tangent = _b_input.tangent->at(j);
+		eval_vector_interpolant_at_point(tangent);
+		double inner_product = tangent.tx()*tangent.nx_interp() + tangent.ty()*tangent.ny_interp() + tangent.tz()*tangent.nz_interp();
+		sum += pow(tangent.inner_product_constraint() - inner_product, 2);
+		n++;
+	}
+
+	return n > 0 ? sqrt(sum/n) : 0.0;
+}
@@ -0,0 +1,91 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef multilevel_h
+#define multilevel_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <modeling_methods.h>
+
+#include <string>
+#include <vector>
+
+// Coarse to fine schedule of Multilevel_Modelling
+struct SURFE_LIB_EXPORT multilevel_parameters{
+	int max_levels;
+	double coarsening; // ratio of the # of constraint locations of consecutive levels
+	int min_locations; // # of constraint locations of the coarsest level (at least)
+	double support; // Gaussian, MQ and IMQ kernels: kernel scale in units of the point spacing of the level
+	multilevel_parameters() : max_levels(4), coarsening(4), min_locations(20), support(3) {}
+};
+
+// Multilevel interpolation: the coarsest level interpolates a thinned subset of the constraints with a wide kernel,
+// every finer level interpolates the residuals of the levels before it on more constraints with a narrower kernel
+// and the finest level uses all of them. The interpolant is the sum of the levels. Each level is an ordinary
+// GRBF_Modelling_Methods problem (linear single surface or continuous property models) whose constraint values
+// are residuals. Levels can be solved one at a time, the partial sums are previews of the final model.
+class SURFE_LIB_EXPORT Multilevel_Modelling {
+private:
+	model_parameters _m_parameters;
+	multilevel_parameters _ml_parameters;
+	Basic_input _b_input;
+	// constraint locations (interfaces, then planars, then tangents) in farthest point order
+	std::vector<int> _order;
+	std::vector<double> _radius;
+	std::vector<int> _level_sizes; // # of constraint locations of each level (a prefix of _order)
+	std::vector<GRBF_Modelling_Methods *> _levels;
+	std::vector<double> _shape_parameters;
+	bool _setup_levels();
+	bool _get_level_input(const int &level, Basic_input &input);
+	double _level_shape_parameter(const int &level);
+public:
+	Multilevel_Modelling(const model_parameters &m_p, const Basic_input &basic_i, const multilevel_parameters &ml_p = multilevel_parameters());
+	~Multilevel_Modelling();
+	// solves the next finer level, false when every level is solved or on failure (error_msg)
+	bool solve_next_level();
+	// all the levels, then the evaluation points
+	bool run_algorithm();
+	int n_levels() const { return (int)_level_sizes.size(); }
+	int n_solved_levels() const { return (int)_levels.size(); }
+	// sum of the first levels solved (all of them by default)
+	void eval_scalar_interpolant_at_point(Point &p, const int &levels = -1);
+	void eval_vector_interpolant_at_point(Point &p, const int &levels = -1);
+	bool evaluate_scalar_interpolant(const int &levels = -1);
+	std::vector<Evaluation_Point> *get_evaluation_points_output() const { return _b_input.evaluation_pts; }
+	// RMS misfit of the equality constraints by the sum of the levels solved
+	double rms_residual();
+	std::string error_msg;
+};
+
+#endif
@@ -0,0 +1,552 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <out_of_core_solver.h>
+
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <cstring>
+#include <cstdlib>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+Mapped_Scratch_File::Mapped_Scratch_File() : _data(NULL), _bytes(0),
+#ifdef _WIN32
+	_file(NULL), _mapping(NULL)
+#else
+	_file(-1)
+#endif
+{
+}
+
+bool Mapped_Scratch_File::open(const std::string &directory, const size_t &n_doubles)
+{
+	close();
+	if (n_doubles == 0) return false;
+	_bytes = n_doubles*sizeof(double);
+
+#ifdef _WIN32
+	std::string dir = directory;
+	if (dir.empty())
+	{
+		char temp_path[MAX_PATH];
+		if (GetTempPathA(MAX_PATH, temp_path) == 0) return false;
+		dir = temp_path;
+	}
+	char file_name[MAX_PATH];
+	if (GetTempFileNameA(dir.c_str(), "srf", 0, file_name) == 0) return false;
+	// deleted by the system when the last handle is closed
+	HANDLE file = CreateFileA(file_name, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+		FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	_file = file;
+	unsigned long long bytes = (unsigned long long)_bytes;
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, (DWORD)(bytes >> 32), (DWORD)(bytes & 0xffffffffULL), NULL);
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	_mapping = mapping;
+	_data = (double*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, _bytes);
+	if (_data == NULL)
+	{
+		close();
+		return false;
+	}
+#else
+	std::string dir = directory;
+	if (dir.empty())
+	{
+		const char *temp_path = getenv("TMPDIR");
+		dir = temp_path != NULL ? temp_path : "/tmp";
+	}
+	std::string path = dir + "/surfe_scratch_XXXXXX";
+	std::vector<char> file_name(path.begin(), path.end());
+	file_name.push_back('\0');
+	_file = mkstemp(&file_name[0]);
+	if (_file < 0) return false;
+	// the file is removed by the system once it is unmapped and closed
+	unlink(&file_name[0]);
+	if (ftruncate(_file, (off_t)_bytes) != 0)
+	{
+		close();
+		return false;
+	}
+	void *data = mmap(NULL, _bytes, PROT_READ | PROT_WRITE, MAP_SHARED, _file, 0);
+	if (data == MAP_FAILED)
+	{
+		close();
+		return false;
+	}
+	_data = (double*)data;
+#endif
+
+	return true;
+}
+
+void Mapped_Scratch_File::close()
+{
+#ifdef _WIN32
+	if (_data != NULL) UnmapViewOfFile(_data);
+	if (_mapping != NULL) CloseHandle((HANDLE)_mapping);
+	if (_file != NULL) CloseHandle((HANDLE)_file);
+	_mapping = NULL;
+	_file = NULL;
+#else
+	if (_data != NULL) munmap(_data, _bytes);
+	if (_file >= 0) ::close(_file);
+	_file = -1;
+#endif
+	_data = NULL;
+	_bytes = 0;
+}
+
+Mapped_File::Mapped_File() : _size(0), _writable(false), _view(NULL), _view_bytes(0),
+#ifdef _WIN32
+	_file(NULL), _mapping(NULL)
+#else
+	_file(-1)
+#endif
+{
+}
+
+bool Mapped_File::open(const std::string &path, const size_t &bytes)
+{
+	close();
+	_writable = (bytes > 0);
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), _writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, _writable ? 0 : FILE_SHARE_READ, NULL,
+		_writable ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) return false;
+	_file = file;
+	if (_writable) _size = bytes;
+	else
+	{
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size))
+		{
+			close();
+			return false;
+		}
+		_size = (size_t)file_size.QuadPart;
+		if (_size == 0) return true;
+	}
+	unsigned long long size = (unsigned long long)_size;
+	HANDLE mapping = CreateFileMappingA(file, NULL, _writable ? PAGE_READWRITE : PAGE_READONLY, (DWORD)(size >> 32), (DWORD)(size & 0xffffffffULL), NULL);
+	if (mapping == NULL)
+	{
+		close();
+		return false;
+	}
+	_mapping = mapping;
+#else
+	_file = ::open(path.c_str(), _writable ? O_RDWR | O_CREAT | O_TRUNC : O_RDONLY, 0644);
+	if (_file < 0) return false;
+	if (_writable)
+	{
+		_size = bytes;
+		if (ftruncate(_file, (off_t)_size) != 0)
+		{
+			close();
+			return false;
+		}
+	}
+	else
+	{
+		off_t end = lseek(_file, 0, SEEK_END);
+		if (end < 0)
+		{
+			close();
+			return false;
+		}
+		_size = (size_t)end;
+	}
+#endif
+
+	return true;
+}
+
+void Mapped_File::_release_view()
+{
+	if (_view == NULL) return;
+#ifdef _WIN32
+	UnmapViewOfFile(_view);
+#else
+	munmap(_view, _view_bytes);
+#endif
+	_view = NULL;
+	_view_bytes = 0;
+}
+
+char *Mapped_File::view(const size_t &offset, const size_t &bytes)
+{
+	_release_view();
+	if (bytes == 0 || offset + bytes > _size) return NULL;
+	// views start at a multiple of the allocation granularity
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	size_t granularity = (size_t)info.dwAllocationGranularity;
+#else
+	size_t granularity = (size_t)sysconf(_SC_PAGE_SIZE);
+#endif
+	size_t start = (offset / granularity)*granularity;
+	_view_bytes = offset + bytes - start;
+#ifdef _WIN32
+	unsigned long long first = (unsigned long long)start;
+	_view = (char*)MapViewOfFile((HANDLE)_mapping, _writable ? FILE_MAP_WRITE : FILE_MAP_READ, (DWORD)(first >> 32), (DWORD)(first & 0xffffffffULL), _view_bytes);
+#else
+	void *data = mmap(NULL, _view_bytes, _writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, _file, (off_t)start);
+	_view = (data == MAP_FAILED) ? NULL : (char*)data;
+#endif
+	if (_view == NULL)
+	{
+		_view_bytes = 0;
+		return NULL;
+	}
+	return _view + (offset - start);
+}
+
+void Mapped_File::close()
+{
+	_release_view();
+#ifdef _WIN32
+	if (_mapping != NULL) CloseHandle((HANDLE)_mapping);
+	if (_file != NULL) CloseHandle((HANDLE)_file);
+	_mapping = NULL;
+	_file = NULL;
+#else
+	if (_file >= 0) ::close(_file);
+	_file = -1;
+#endif
+	_size = 0;
+}
+
+double Out_Of_Core_Solver::physical_memory_mb()
+{
+#ifdef _WIN32
+	MEMORYSTATUSEX status;
+	status.dwLength = sizeof(status);
+	if (GlobalMemoryStatusEx(&status)) return (double)status.ullTotalPhys/1048576.0;
+	return 0.0;
+#else
+	long pages = sysconf(_SC_PHYS_PAGES);
+	long page_size = sysconf(_SC_PAGE_SIZE);
+	if (pages > 0 && page_size > 0) return (double)pages*(double)page_size/1048576.0;
+	return 0.0;
+#endif
+}
+
+bool Out_Of_Core_Solver::is_required(const int &n, const double &memory_limit_mb)
+{
+	// the in core path holds about three copies of the matrix (assembly, solver copy and factorization)
+	double limit = memory_limit_mb > 0.0 ? memory_limit_mb : 0.25*physical_memory_mb();
+	if (limit <= 0.0) return false;
+	return 8.0*(double)n*(double)n/1048576.0 > limit;
+}
+
+void Out_Of_Core_Solver::_read_panel(const int &k, const int &first_row, const int &n_rows, MatrixXd &panel) const
+{
+	int w = _panel_columns(k);
+	panel.resize(n_rows, w);
+	const double *columns = _scratch.data() + (size_t)_n*(size_t)_panel_start(k);
+	for (int c = 0; c < w; c++ ) std::memcpy(panel.col(c).data(), columns + (size_t)c*(size_t)_n + first_row, (size_t)n_rows*sizeof(double));
+}
+
+void Out_Of_Core_Solver::_write_panel(const int &k, const int &first_row, const MatrixXd &panel)
+{
+	int w = _panel_columns(k);
+	int n_rows = (int)panel.rows();
+	double *columns = _scratch.data() + (size_t)_n*(size_t)_panel_start(k);
+	for (int c = 0; c < w; c++ ) std::memcpy(columns + (size_t)c*(size_t)_n + first_row, panel.col(c).data(), (size_t)n_rows*sizeof(double));
+}
+
+void Out_Of_Core_Solver::_apply_pivots(const int &first, const int &last, const int &row_offset, MatrixXd &panel) const
+{
+	for (int j = first; j < last; j++ ){
+		int p = _pivots[j];
+		if (p != j) panel.row(j - row_offset).swap(panel.row(p - row_offset));
+	}
+}
+
+bool Out_Of_Core_Solver::_stream_panels(const std::vector<Panel_Read> &reads, const std::function<bool(const Panel_Read &, MatrixXd &)> &apply)
+{
+	// double buffering: the next panel is read from the scratch file while the current one is used
+	MatrixXd buffers[2];
+	std::future<void> pending;
+	int n_reads = (int)reads.size();
+	if (n_reads == 0) return true;
+	pending = std::async(std::launch::async, &Out_Of_Core_Solver::_read_panel, this, reads[0].panel, reads[0].first_row, reads[0].n_rows, std::ref(buffers[0]));
+	for (int j = 0; j < n_reads; j++ ){
+		pending.get();
+		if (j + 1 < n_reads)
+		{
+			const Panel_Read &next = reads[j + 1];
+			pending = std::async(std::launch::async, &Out_Of_Core_Solver::_read_panel, this, next.panel, next.first_row, next.n_rows, std::ref(buffers[(j + 1) % 2]));
+		}
+		if (!apply(reads[j], buffers[j % 2]))
+		{
+			if (pending.valid()) pending.get();
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Out_Of_Core_Solver::_assemble()
+{
+	MatrixXd panel;
+	for (int k = 0; k < _n_panels; k++ ){
+		if (!_assembler->get_columns(_panel_start(k), _panel_columns(k), panel)) return false;
+		if (panel.rows() != _n || !panel.allFinite()) return false;
+		_write_panel(k, 0, panel);
+	}
+	return true;
+}
+
+bool Out_Of_Core_Solver::_factor_lu()
+{
+	// left looking LU with partial pivoting: P A = L U. Each panel is updated with all the panels to its left,
+	// then factored. The row interchanges of a panel are applied lazily to the panels on its left when they are read.
+	_pivots.resize(_n);
+	for (int j = 0; j < _n; j++ ) _pivots[j] = j;
+
+	MatrixXd panel;
+	for (int j = 0; j < _n_panels; j++ ){
+		int c0 = _panel_start(j);
+		int w = _panel_columns(j);
+		_read_panel(j, 0, _n, panel);
+		_apply_pivots(0, c0, 0, panel);
+
+		std::vector<Panel_Read> reads;
+		for (int k = 0; k < j; k++ ) reads.push_back(Panel_Read(k, _panel_start(k), _n - _panel_start(k)));
+		bool updated = _stream_panels(reads, [&](const Panel_Read &read, MatrixXd &L) -> bool {
+			int r0 = read.first_row;
+			int bk = _panel_columns(read.panel);
+			int below = _n - r0 - bk;
+			_apply_pivots(r0 + bk, c0, r0, L);
+			// U(k,j) = L(k,k)^-1 A(k,j), A(below,j) -= L(below,k) U(k,j)
+			L.topRows(bk).triangularView<UnitLower>().solveInPlace(panel.middleRows(r0, bk));
+			if (below > 0) panel.bottomRows(below).noalias() -= L.bottomRows(below)*panel.middleRows(r0, bk);
+			return true;
+		});
+		if (!updated) return false;
+
+		// factor rows [c0, n) of the panel, pivoting over all the remaining rows
+		for (int c = 0; c < w; c++ ){
+			int row = c0 + c;
+			int p = 0;
+			double pivot = panel.col(c).segment(row, _n - row).cwiseAbs().maxCoeff(&p);
+			if (!(pivot > 0.0) || !std::isfinite(pivot)) return false; // singular
+			p += row;
+			_pivots[row] = p;
+			if (p != row) panel.row(row).swap(panel.row(p));
+			int below = _n - row - 1;
+			if (below > 0)
+			{
+				panel.col(c).tail(below) /= panel(row, c);
+				if (c + 1 < w) panel.block(row + 1, c + 1, below, w - c - 1).noalias() -= panel.col(c).tail(below)*panel.row(row).segment(c + 1, w - c - 1);
+			}
+		}
+		_write_panel(j, 0, panel);
+
+		if (progress) progress(j + 1, _n_panels);
+	}
+	return true;
+}
+
+bool Out_Of_Core_Solver::_factor_cholesky()
+{
+	// left looking Cholesky A = L LT, only the lower triangle of each panel (rows [c0, n)) is used
+	MatrixXd panel;
+	for (int j = 0; j < _n_panels; j++ ){
+		int c0 = _panel_start(j);
+		int w = _panel_columns(j);
+		int below = _n - c0 - w;
+		_read_panel(j, c0, _n - c0, panel);
+
+		std::vector<Panel_Read> reads;
+		for (int k = 0; k < j; k++ ) reads.push_back(Panel_Read(k, c0, _n - c0));
+		bool updated = _stream_panels(reads, [&](const Panel_Read &, MatrixXd &L) -> bool {
+			// A(c0:n,j) -= L(c0:n,k) L(j,k)T
+			panel.noalias() -= L*L.topRows(w).transpose();
+			return true;
+		});
+		if (!updated) return false;
+
+		LLT<MatrixXd> llt(panel.topRows(w));
+		if (llt.info() != Success) return false; // not positive definite
+		panel.topRows(w) = llt.matrixL();
+		// L(below,j) = A(below,j) L(j,j)^-T
+		if (below > 0) llt.matrixU().solveInPlace<OnTheRight>(panel.bottomRows(below));
+		_write_panel(j, c0, panel);
+
+		if (progress) progress(j + 1, _n_panels);
+	}
+	return true;
+}
+
+bool Out_Of_Core_Solver::_solve_lu(const VectorXd &b, VectorXd &x)
+{
+	x = b;
+	for (int j = 0; j < _n; j++ ) if (_pivots[j] != j) std::swap(x(j), x(_pivots[j]));
+
+	// L y = P b
+	std::vector<Panel_Read> reads;
+	for (int k = 0; k < _n_panels; k++ ) reads.push_back(Panel_Read(k, _panel_start(k), _n - _panel_start(k)));
+	bool forward = _stream_panels(reads, [&](const Panel_Read &read, MatrixXd &L) -> bool {
+		int r0 = read.first_row;
+		int bk = _panel_columns(read.panel);
+		int below = _n - r0 - bk;
+		_apply_pivots(r0 + bk, _n, r0, L);
+		L.topRows(bk).triangularView<UnitLower>().solveInPlace(x.segment(r0, bk));
+		if (below > 0) x.tail(below).noalias() -= L.bottomRows(below)*x.segment(r0, bk);
+		return true;
+	});
+	if (!forward) return false;
+
+	// U x = y, the U part of panel k is rows [0, r0 + bk)
+	reads.clear();
+	for (int k = _n_panels - 1; k >= 0; k-- ) reads.push_back(Panel_Read(k, 0, _panel_start(k) + _panel_columns(k)));
+	bool backward = _stream_panels(reads, [&](const Panel_Read &read, MatrixXd &U) -> bool {
+		int r0 = _panel_start(read.panel);
+		int bk = _panel_columns(read.panel);
+		U.bottomRows(bk).triangularView<Upper>().solveInPlace(x.segment(r0, bk));
+		if (r0 > 0) x.head(r0).noalias() -= U.topRows(r0)*x.segment(r0, bk);
+		return true;
+	});
+	return backward;
+}
+
+bool Out_Of_Core_Solver::_solve_cholesky(const VectorXd &b, VectorXd &x)
+{
+	x = b;
+
+	// L y = b
+	std::vector<Panel_Read> reads;
+	for (int k = 0; k < _n_panels; k++ ) reads.push_back(Panel_Read(k, _panel_start(k), _n - _panel_start(k)));
+	bool forward = _stream_panels(reads, [&](const Panel_Read &read, MatrixXd &L) -> bool {
+		int r0 = read.first_row;
+		int bk = _panel_columns(read.panel);
+		int below = _n - r0 - bk;
+		L.topRows(bk).triangularView<Lower>().solveInPlace(x.segment(r0, bk));
+		if (below > 0) x.tail(below).noalias() -= L.bottomRows(below)*x.segment(r0, bk);
+		return true;
+	});
+	if (!forward) return false;
+
+	// LT x = y
+	std::reverse(reads.begin(), reads.end());
+	bool backward = _stream_panels(reads, [&](const Panel_Read &read, MatrixXd &L) -> bool {
+		int r0 = read.first_row;
+		int bk = _panel_columns(read.panel);
+		int below = _n - r0 - bk;
+		if (below > 0) x.segment(r0, bk).noalias() -= L.bottomRows(below).transpose()*x.tail(below);
+		L.topRows(bk).triangularView<Lower>().transpose().solveInPlace(x.segment(r0, bk));
+		return true;
+	});
+	return backward;
+}
+
+bool Out_Of_Core_Solver::solve()
+{
+	if (_assembler == NULL) return false;
+	_n = _assembler->size();
+	if (_n == 0 || _constraint_values.rows() != _n) return false;
+	_panel_width = std::max(1, std::min(_panel_width, _n));
+	_n_panels = (_n + _panel_width - 1)/_panel_width;
+
+	cout<<" Out of core "<<(_cholesky ? "Cholesky" : "LU")<<": n = "<<_n<<", scratch file = "<<8.0*(double)_n*(double)_n/1048576.0
+		<<" MB, "<<_n_panels<<" panels of "<<_panel_width<<" columns"<<endl;
+	if (!_scratch.open(_scratch_directory, (size_t)_n*(size_t)_n))
+	{
+		cout<<" Out of core solver: could not create the scratch file"<<endl;
+		return false;
+	}
+
+	bool factored = false;
+	if (!_assemble())
+	{
+		_scratch.close();
+		return false;
+	}
+	if (_cholesky)
+	{
+		factored = _factor_cholesky();
+		if (!factored)
+		{
+			// the factorization overwrote part of the matrix, assemble it again for LU
+			cout<<" Out of core Cholesky failed (matrix not positive definite), using LU"<<endl;
+			_cholesky = false;
+			if (!_assemble())
+			{
+				_scratch.close();
+				return false;
+			}
+		}
+	}
+	if (!_cholesky) factored = _factor_lu();
+
+	VectorXd x;
+	bool solved = false;
+	if (factored)
+	{
+		if (_cholesky) solved = _solve_cholesky(_constraint_values, x);
+		else solved = _solve_lu(_constraint_values, x);
+	}
+	_scratch.close();
+	_assembler = NULL;
+	if (!solved || !x.allFinite()) return false;
+
+	weights = x;
+	return true;
+}
+
+bool Out_Of_Core_Solver::validate_matrix_systems()
+{
+	if (_assembler == NULL) return false;
+	return _assembler->size() == (int)_constraint_values.rows();
+}
@@ -0,0 +1,159 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef out_of_core_solver_h
+#define out_of_core_solver_h
+
+#include <matrix_solver.h>
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <Eigen/Core>
+
+// Supplies column blocks of a matrix that is too large to be assembled in memory
+class Matrix_Column_Assembler {
+public:
+	virtual ~Matrix_Column_Assembler(){}
+	virtual int size() const = 0;
+	// columns [first, first + count) of the matrix. columns is resized to size() x count
+	virtual bool get_columns(const int &first, const int &count, MatrixXd &columns) = 0;
+};
+
+// Scratch file mapped into the address space. The file is removed when it is closed.
+class Mapped_Scratch_File {
+private:
+	double *_data;
+	size_t _bytes;
+#ifdef _WIN32
+	void *_file;
+	void *_mapping;
+#else
+	int _file;
+#endif
+public:
+	Mapped_Scratch_File();
+	~Mapped_Scratch_File() { close(); }
+	bool open(const std::string &directory, const size_t &n_doubles);
+	void close();
+	double *data() const { return _data; }
+};
+
+// Binary file mapped one view (a byte range) at a time, so that the memory used does not grow with the file
+class Mapped_File {
+private:
+	size_t _size;
+	bool _writable;
+	char *_view; // mapping of the current view, from an allocation granularity boundary
+	size_t _view_bytes;
+#ifdef _WIN32
+	void *_file;
+	void *_mapping;
+#else
+	int _file;
+#endif
+	void _release_view();
+public:
+	Mapped_File();
+	~Mapped_File() { close(); }
+	// an existing file for reading (bytes = 0), or a file of bytes bytes created (or overwritten) for writing
+	bool open(const std::string &path, const size_t &bytes = 0);
+	void close();
+	size_t size() const { return _size; }
+	// bytes [offset, offset + bytes) of the file, valid until the next view or close. NULL if out of the file
+	char *view(const size_t &offset, const size_t &bytes);
+};
+
+// Out of core dense solver for systems whose matrix does not fit in memory.
+// The matrix is assembled one column panel at a time from a Matrix_Column_Assembler into a memory mapped
+// scratch file and factored with a left looking panel algorithm (LU with partial pivoting, or Cholesky for
+// positive definite matrices). Only two panels (n x panel_width) are held in memory and the next panel is
+// read from the scratch file by a background thread while the current one is applied with BLAS-3 updates.
+// I/O is O(n^3/panel_width) doubles, so wider panels are faster as long as they fit in memory.
+class Out_Of_Core_Solver : public System_Solver {
+private:
+	Matrix_Column_Assembler *_assembler;
+	VectorXd _constraint_values;
+	std::string _scratch_directory;
+	bool _cholesky;
+	int _n;
+	int _panel_width;
+	int _n_panels;
+	Mapped_Scratch_File _scratch;
+	std::vector<int> _pivots; // row interchanges, row j was swapped with row _pivots[j] (LAPACK ipiv convention)
+	struct Panel_Read{
+		int panel;
+		int first_row;
+		int n_rows;
+		Panel_Read(const int &k, const int &first, const int &rows) : panel(k), first_row(first), n_rows(rows) {}
+	};
+
+	int _panel_start(const int &k) const { return k*_panel_width; }
+	int _panel_columns(const int &k) const { return std::min(_panel_width, _n - k*_panel_width); }
+	// rows [first_row, first_row + n_rows) of panel k
+	void _read_panel(const int &k, const int &first_row, const int &n_rows, MatrixXd &panel) const;
+	void _write_panel(const int &k, const int &first_row, const MatrixXd &panel);
+	// reads the panels in order with one panel of read ahead and passes each to apply
+	bool _stream_panels(const std::vector<Panel_Read> &reads, const std::function<bool(const Panel_Read &, MatrixXd &)> &apply);
+	// row interchanges j in [first, last) applied to panel rows (panel row 0 is matrix row row_offset)
+	void _apply_pivots(const int &first, const int &last, const int &row_offset, MatrixXd &panel) const;
+	bool _assemble();
+	bool _factor_lu();
+	bool _factor_cholesky();
+	bool _solve_lu(const VectorXd &b, VectorXd &x);
+	bool _solve_cholesky(const VectorXd &b, VectorXd &x);
+public:
+	// assembler must stay valid until solve() returns
+	Out_Of_Core_Solver(Matrix_Column_Assembler *assembler, const VectorXd &vector, const std::string &scratch_directory,
+		const bool &cholesky, const int &panel_width = 512)
+	{
+		_assembler = assembler;
+		_constraint_values = vector;
+		_scratch_directory = scratch_directory;
+		_cholesky = cholesky;
+		_n = 0;
+		_panel_width = panel_width;
+		_n_panels = 0;
+	}
+	virtual ~Out_Of_Core_Solver() {}
+	// optional, called with (panels factored, total panels) as the factorization proceeds
+	std::function<void(const int &, const int &)> progress;
+	bool solve();
+	bool validate_matrix_systems();
+	// true if a dense n x n matrix exceeds memory_limit_mb (0: a quarter of the physical memory)
+	static bool is_required(const int &n, const double &memory_limit_mb);
+	static double physical_memory_mb();
+};
+
+#endif
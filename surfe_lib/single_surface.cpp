@@ -53,12 +53,12 @@ bool Single_Surface::_get_polynomial_matrix_block(MatrixXd &poly_matrix)
 
 	p_basis = create_polynomial_basis(m_parameters.polynomial_order);
 
-	if ((int)poly_matrix.rows() != b_parameters.n_poly_terms ) return false;
+	if ((int)poly_matrix.rows() != (int)b_parameters.n_poly_terms ) return false;
 	// for interface points ...
 	for (int j = 0; j < nl; j++ ){
 		p_basis->set_point(b_input.itrface->at(j));
 		VectorXd b = p_basis->basis();
-		if ((int)b.rows() != b_parameters.n_poly_terms ) return false;
+		if ((int)b.rows() != (int)b_parameters.n_poly_terms ) return false;
 		for (int k = 0; k < (int)b.rows(); k++ ) poly_matrix(k,j) = b(k);
 	}
 	// for planar points ...
@@ -67,7 +67,7 @@ bool Single_Surface::_get_polynomial_matrix_block(MatrixXd &poly_matrix)
 		VectorXd bx = p_basis->dx();
 		VectorXd by = p_basis->dy();
 		VectorXd bz = p_basis->dz();
-		if ((int)bx.rows() != b_parameters.n_poly_terms ) return false;
+		if ((int)bx.rows() != (int)b_parameters.n_poly_terms ) return false;
 		for (int k = 0; k < (int)bx.rows(); k++ ){
 			poly_matrix(k,nl + 3*j) = bx(k);
 			poly_matrix(k,nl + 3*j + 1) = by(k);
@@ -80,7 +80,7 @@ bool Single_Surface::_get_polynomial_matrix_block(MatrixXd &poly_matrix)
 		VectorXd bx = p_basis->dx();
 		VectorXd by = p_basis->dy();
 		VectorXd bz = p_basis->dz();
-		if ((int)bx.rows() != b_parameters.n_poly_terms ) return false;
+		if ((int)bx.rows() != (int)b_parameters.n_poly_terms ) return false;
 		for (int k = 0; k < (int)bx.rows(); k++ ){
 			poly_matrix(k,nl + 3 * n_p + j) = b_input.tangent->at(j).tx()*bx(k) + b_input.tangent->at(j).ty()*by(k) + b_input.tangent->at(j).tz()*bz(k);
 		}
@@ -123,6 +123,42 @@ Single_Surface::Single_Surface(const model_parameters& m_p, const Basic_input& b
 	b_input = basic_i;
 
 	_iteration = 0;
+	_last_qpc = NULL;
+	_last_loqo = NULL;
+	_last_linear = NULL;
+	p_basis = NULL;
+	_use_reduced_centers = false;
+}
+
+GRBF_Modelling_Methods *Single_Surface::clone()
+{
+	Single_Surface *copy = new Single_Surface(*this);
+	// the warm start solvers belong to this model, a copy updating them in place would change this model's weights
+	copy->_last_qpc = NULL;
+	copy->_last_loqo = NULL;
+	copy->_last_linear = NULL;
+	return copy;
+}
+
+bool Single_Surface::_get_warm_start_map(const basic_parameters &previous, std::vector<int> &map)
+{
+	// constraints are ordered by type [inequality, interface, planar (3 per point), tangent] and
+	// the greedy algorithm only appends constraints to the end of each type
+	int n_prev[4] = { (int)previous.n_inequality, (int)previous.n_interface, 3*(int)previous.n_planar, (int)previous.n_tangent };
+	int n_curr[4] = { (int)b_parameters.n_inequality, (int)b_parameters.n_interface, 3*(int)b_parameters.n_planar, (int)b_parameters.n_tangent };
+
+	map.clear();
+	int offset = 0;
+	for (int j = 0; j < 4; j++ ){
+		if (n_curr[j] < n_prev[j]) return false;
+		for (int k = 0; k < n_curr[j]; k++ ){
+			if (k < n_prev[j]) map.push_back(offset + k);
+			else map.push_back(-1);
+		}
+		offset += n_prev[j];
+	}
+
+	return true;
 }
 
 
@@ -173,6 +209,7 @@ bool Single_Surface::setup_system_solver()
 	// 2) What type of RBF is used 
 	// 3) Smoothing -> maybe use least squares / right now we are doing matrix smoothing
 
+	_use_reduced_centers = false;
 	int n_ie  = b_parameters.n_inequality;
 	int n_e   = b_parameters.n_equality;
 	int n_c   = b_parameters.n_constraints;
@@ -191,12 +228,17 @@ bool Single_Surface::setup_system_solver()
 			inequality_matrix = interpolation_matrix;
 
 			Quadratic_Predictor_Corrector_LOQO *qpc = new Quadratic_Predictor_Corrector_LOQO(interpolation_matrix,inequality_matrix,b,r);
+			std::vector<int> map;
+			if (_last_loqo != NULL && _get_warm_start_map(_last_qp_parameters,map)) qpc->set_warm_start(*_last_loqo,map);
 			if (!qpc->solve())
 			{
 				error_msg.append(" LOQO Quadratic Solver failure.");
 				return false;
 			}
 			solver = qpc;
+			_last_loqo = qpc;
+			_last_qpc = NULL;
+			_last_qp_parameters = b_parameters;
 		}
 		else
 		{
@@ -215,31 +257,122 @@ bool Single_Surface::setup_system_solver()
 			MatrixXd equality_matrix(n_e,n_c);
 			if (!get_equality_matrix(interpolation_matrix,equality_matrix)) return false;
 
-			Quadratic_Predictor_Corrector *qpc = new Quadratic_Predictor_Corrector(interpolation_matrix,equality_matrix,inequality_matrix,equality_values,inequality_values);
-			if (!qpc->solve())
+			bool use_active_set = m_parameters.qp_solver == Parameter_Types::Active_set ||
+				(m_parameters.qp_solver == Parameter_Types::Automatic && Quadratic_Active_Set::is_preferred(n_ie,n_c));
+			if (use_active_set)
 			{
-				error_msg.append(" Predictor-Corrector Quadratic Solver failure.");
-				return false;
+				Quadratic_Active_Set *qas = new Quadratic_Active_Set(interpolation_matrix,equality_matrix,inequality_matrix,equality_values,inequality_values);
+				if (qas->solve())
+				{
+					solver = qas;
+					_last_qpc = NULL;
+					_last_loqo = NULL;
+				}
+				else
+				{
+					// degenerate active set, fall back to the interior point solver
+					delete qas;
+					use_active_set = false;
+				}
+			}
+			if (!use_active_set)
+			{
+				Quadratic_Predictor_Corrector *qpc = new Quadratic_Predictor_Corrector(interpolation_matrix,equality_matrix,inequality_matrix,equality_values,inequality_values);
+				std::vector<int> map;
+				if (_last_qpc != NULL && _get_warm_start_map(_last_qp_parameters,map))
+				{
+					// weights and constraints share the same ordering, the inequalities come first
+					int n_ie_prev = _last_qp_parameters.n_inequality;
+					std::vector<int> inequality_map(map.begin(),map.begin() + n_ie);
+					std::vector<int> equality_map;
+					for (int j = n_ie; j < (int)map.size(); j++ ) equality_map.push_back(map[j] < 0 ? -1 : map[j] - n_ie_prev);
+					qpc->set_warm_start(*_last_qpc,map,equality_map,inequality_map);
+				}
+				if (!qpc->solve())
+				{
+					error_msg.append(" Predictor-Corrector Quadratic Solver failure.");
+					return false;
+				}
+				solver = qpc;
+				_last_qpc = qpc;
+				_last_loqo = NULL;
+				_last_qp_parameters = b_parameters;
 			}
-			solver = qpc;
 		}
 	}
 	else // Linear 
 	{
+		// far more constraints than the surface needs: N x M least squares on M centers instead of the N x N system
+		int n_locations = b_parameters.n_interface + b_parameters.n_planar + b_parameters.n_tangent;
+		if (m_parameters.reduced_centers > 0 && !m_parameters.use_greedy && n_locations > m_parameters.reduced_centers)
+			return _setup_reduced_center_solver();
+
 		int n_p = b_parameters.n_poly_terms;
 		VectorXd equality_values(n_e + n_p);
 		get_equality_values(equality_values);
 
+		if (Out_Of_Core_Solver::is_required(n_e + n_p, m_parameters.out_of_core_memory_mb))
+		{
+			// the matrix does not fit in memory: it is assembled panel by panel into a scratch file and factored there
+			MatrixXd poly_matrix;
+			if (b_parameters.poly_term)
+			{
+				poly_matrix.resize(n_p, n_c);
+				if (!_get_polynomial_matrix_block(poly_matrix)) return false;
+			}
+			Single_Surface_Columns columns(this, poly_matrix, n_e + n_p);
+			Out_Of_Core_Solver *ooc = new Out_Of_Core_Solver(&columns, equality_values, m_parameters.scratch_directory,
+				Linear_Solver_Selector::is_definite_kernel(m_parameters, b_parameters));
+			ooc->progress = [this](const int &step, const int &total) {
+				_Progress(" Factoring out of core: ", step, total);
+			};
+			bool solved = ooc->solve();
+			cout<<endl;
+			if (!solved)
+			{
+				error_msg.append(" Out of core Linear Solver failure.");
+				return false;
+			}
+			solver = ooc;
+			return true;
+		}
+
 		MatrixXd interpolation_matrix(n_e + n_p, n_e + n_p);
 		if (!get_interpolation_matrix(interpolation_matrix)) return false;
 
-		Linear_LU_decomposition *llu = new Linear_LU_decomposition(interpolation_matrix,equality_values);
-		if (!llu->solve())
+		if (m_parameters.use_greedy)
 		{
-			error_msg.append(" Linear Solver failure.");
-			return false;
+			// greedy iterations add a few constraints at a time: O(n^2 k) update of the previous system
+			Linear_Updatable_Solver *lus = NULL;
+			std::vector<int> map;
+			if (_last_linear != NULL && (int)_last_linear_parameters.n_poly_terms == n_p && _get_warm_start_map(_last_linear_parameters,map))
+			{
+				// polynomial terms stay at the end
+				int n_c_prev = _last_linear_parameters.n_inequality + _last_linear_parameters.n_interface +
+					3*_last_linear_parameters.n_planar + _last_linear_parameters.n_tangent;
+				for (int j = 0; j < n_p; j++ ) map.push_back(n_c_prev + j);
+				if (_last_linear->update(interpolation_matrix,equality_values,map)) lus = _last_linear;
+			}
+			if (lus == NULL) lus = new Linear_Updatable_Solver(interpolation_matrix,equality_values);
+			if (!lus->solve())
+			{
+				error_msg.append(" Linear Solver failure.");
+				return false;
+			}
+			solver = lus;
+			_last_linear = lus;
+			_last_linear_parameters = b_parameters;
+		}
+		else
+		{
+			System_Solver *llu = Linear_Solver_Selector::create(interpolation_matrix,equality_values,m_parameters,b_parameters);
+			if (!llu->solve())
+			{
+				error_msg.append(" Linear Solver failure.");
+				return false;
+			}
+			solver = llu;
 		}
-		solver = llu;
 	}
 
 	//check_interpolant();
@@ -427,79 +560,33 @@ bool Single_Surface::convert_modified_kernel_to_rbf_kernel()
 {
 	if (rbf_kernel == NULL || kernel == NULL) return false;
 
-	// prep for linear prob...
-	// set the constraints...
-	// temp container for interface points needed for cases where inequalities are used
-	// b/c inequalities are turned into 'interface points' (they do not actually represent horizon interfaces points though)
-	std::vector<Interface> *temp_itr = new std::vector<Interface>();
-	for (int j = 0; j < b_input.inequality->size(); j++ ){
-		Evaluation_Point test_point(b_input.inequality->at(j).x(),b_input.inequality->at(j).y(),b_input.inequality->at(j).z());
-		// debug
-		// cout<<" Inequality["<<j<<"]: "<<endl;
-		eval_scalar_interpolant_at_point(test_point);
-		// cout<<"	Scalar field = "<<test_point.scalar_field()<<endl;
-		Interface itr_point(test_point.x(),test_point.y(),test_point.z(),test_point.scalar_field());
-		temp_itr->push_back(itr_point);
-	}
-	for (int j = 0; j < b_input.itrface->size(); j++ ){
-		Evaluation_Point test_point(b_input.itrface->at(j).x(),b_input.itrface->at(j).y(),b_input.itrface->at(j).z());
-		// debug
-		//cout<<" Interface["<<j<<"]: "<<endl;
-		eval_scalar_interpolant_at_point(test_point);
-		//cout<<"	Scalar field = "<<test_point.scalar_field()<<endl;
-		b_input.itrface->at(j).setLevel(test_point.scalar_field());
-
-		Interface itr_point(test_point.x(),test_point.y(),test_point.z(),test_point.scalar_field());
-		temp_itr->push_back(itr_point);
-	}
-	for (int j = 0; j < b_input.planar->size(); j++ ){
-		eval_vector_interpolant_at_point(b_input.planar->at(j));
-		// debug
-// 		cout<<" Planar["<<j<<"]: "<<endl;
-// 		cout<<"	Nx = "<<b_input.planar->at(j).nx()<<" Nx interpolated = "<<b_input.planar->at(j).nx_interp()<<endl;
-// 		cout<<"	Ny = "<<b_input.planar->at(j).ny()<<" Ny interpolated = "<<b_input.planar->at(j).ny_interp()<<endl;
-// 		cout<<"	Nz = "<<b_input.planar->at(j).nz()<<" Nz interpolated = "<<b_input.planar->at(j).nz_interp()<<endl;
-		double normal[3] = {b_input.planar->at(j).nx_interp(),b_input.planar->at(j).ny_interp(),b_input.planar->at(j).nz_interp()};
-		b_input.planar->at(j).setNormal(normal[0],normal[1],normal[2]);
-	}
-	for (int j = 0; j < b_input.tangent->size(); j++ ){
-		eval_vector_interpolant_at_point(b_input.tangent->at(j));
-// 		cout<<" Tangent["<<j<<"]: "<<endl;
-// 		cout<<"	Tx = "<<b_input.tangent->at(j).tx()<<" Nx interpolated = "<<b_input.tangent->at(j).nx_interp()<<endl;
-// 		cout<<"	Ty = "<<b_input.tangent->at(j).ty()<<" Ny interpolated = "<<b_input.tangent->at(j).ny_interp()<<endl;
-// 		cout<<"	Tz = "<<b_input.tangent->at(j).tz()<<" Nz interpolated = "<<b_input.tangent->at(j).nz_interp()<<endl;
-// 		cout<<" Tx*nx + Ty*ny + Tz*nz = "<<b_input.tangent->at(j).tx()*b_input.tangent->at(j).nx_interp() + b_input.tangent->at(j).ty()*b_input.tangent->at(j).ny_interp() +
-// 			b_input.tangent->at(j).tz()*b_input.tangent->at(j).nz_interp()<<endl;
-		double vf[3] = {b_input.tangent->at(j).nx_interp(),b_input.tangent->at(j).ny_interp(),b_input.tangent->at(j).nz_interp()};
-		double inner_product = vf[0]*b_input.tangent->at(j).tx() + vf[1]*b_input.tangent->at(j).ty() + vf[2]*b_input.tangent->at(j).tz();
-		b_input.tangent->at(j).setInnerProductConstraint(inner_product);
-	}
+	std::vector<Interface> centers;
+	VectorXd center_weights;
+	VectorXd poly_weights;
+	if (!_expand_modified_kernel(centers, center_weights, poly_weights)) return false;
+
+	// the unisolvent points are interface points: their weights go to the matching interface constraints
+	std::vector<int> center_indices;
+	if (!_unisolvent_interface_indices(center_indices)) return false;
+	int n_ie = b_parameters.n_inequality;
+	int n_c = b_parameters.n_constraints;
+	VectorXd weights(n_c + 4);
+	weights.head(n_c) = solver->weights.head(n_c);
+	weights.tail(4) = poly_weights;
+	for (int j = 0; j < (int)center_indices.size(); j++ ) weights(n_ie + center_indices[j]) += center_weights(j);
 
 	// switch from modified kernel to normal rbf kernel
 	kernel = rbf_kernel;
+	delete p_basis;
+	p_basis = new Poly_First;
 
-	b_input.inequality->clear();
-	b_input.itrface->clear();
-	b_input.itrface = temp_itr;
-
-	int n_p = b_parameters.n_poly_terms;
 	if (m_parameters.use_restricted_range) b_parameters.restricted_range = false;
-	b_parameters.n_interface = (int)b_input.itrface->size();
-	b_parameters.n_inequality = (int)b_input.inequality->size();
 	b_parameters.n_equality = b_parameters.n_interface + 3*b_parameters.n_planar + b_parameters.n_tangent;
 	b_parameters.poly_term = true;
+	b_parameters.n_poly_terms = 4;
 	b_parameters.modified_basis = false;
 	b_parameters.problem_type = Parameter_Types::Linear;
-	int n_e = b_parameters.n_equality;
-	VectorXd equality_values(n_e + n_p);
-	get_equality_values(equality_values);
-
-	MatrixXd interpolation_matrix(n_e + n_p, n_e + n_p);
-	if (!get_interpolation_matrix(interpolation_matrix)) return false;
-
-	Linear_LU_decomposition *llu = new Linear_LU_decomposition(interpolation_matrix,equality_values);
-	if (!llu->solve()) return false;
-	solver = llu;
+	solver->weights = weights;
 
 	return true;
 }
@@ -507,9 +594,12 @@ bool Single_Surface::convert_modified_kernel_to_rbf_kernel()
 void Single_Surface::eval_scalar_interpolant_at_point( Point &p )
 {
 	int n_ie = b_parameters.n_inequality;
-	int n_i = b_parameters.n_interface;
-	int n_p = b_parameters.n_planar;
-	int n_t = b_parameters.n_tangent;
+	std::vector<Interface> &itrface = _interface_centers();
+	std::vector<Planar> &planar = _planar_centers();
+	std::vector<Tangent> &tangent = _tangent_centers();
+	int n_i = (int)itrface.size();
+	int n_p = (int)planar.size();
+	int n_t = (int)tangent.size();
 
 	Kernel *kernel_j = kernel->clone();
 	double elemsum_1 = 0.0;
@@ -522,17 +612,17 @@ void Single_Surface::eval_scalar_interpolant_at_point( Point &p )
 		elemsum_1 += solver->weights[k] * kernel_j->basis_pt_pt();
 	}
 	for (int k = 0; k < n_i; k++ ){
-		kernel_j->set_points(p, b_input.itrface->at(k));
+		kernel_j->set_points(p, itrface.at(k));
 		elemsum_2 += solver->weights[n_ie + k] * kernel_j->basis_pt_pt();
 	}
 	for (int k = 0; k < n_p; k++ ){
-		kernel_j->set_points(p, b_input.planar->at(k));
+		kernel_j->set_points(p, planar.at(k));
 		elemsum_3 += solver->weights[n_ie + n_i + 3*k] * kernel_j->basis_pt_planar_x();
 		elemsum_3 += solver->weights[n_ie + n_i + 3*k + 1] * kernel_j->basis_pt_planar_y();
 		elemsum_3 += solver->weights[n_ie + n_i + 3*k + 2] * kernel_j->basis_pt_planar_z();
 	}
 	for (int k = 0; k < n_t; k++ ){
-		kernel_j->set_points(p, b_input.tangent->at(k));
+		kernel_j->set_points(p, tangent.at(k));
 		elemsum_4 += solver->weights[n_ie + n_i + 3*n_p + k] * kernel_j->basis_pt_tangent();
 	}
 	if (b_parameters.poly_term)
@@ -547,12 +637,48 @@ void Single_Surface::eval_scalar_interpolant_at_point( Point &p )
 	delete kernel_j;
 }
 
+Tiled_Evaluator *Single_Surface::get_tiled_evaluator()
+{
+	Tiled_Evaluator *evaluator = _new_tiled_evaluator();
+	if (evaluator == NULL) return NULL;
+
+	int n_ie = b_parameters.n_inequality;
+	std::vector<Interface> &itrface = _interface_centers();
+	std::vector<Planar> &planar = _planar_centers();
+	std::vector<Tangent> &tangent = _tangent_centers();
+	int n_i = (int)itrface.size();
+	int n_p = (int)planar.size();
+	int n_t = (int)tangent.size();
+
+	for (int k = 0; k < n_ie; k++ ) evaluator->add_point_center(b_input.inequality->at(k), solver->weights[k]);
+	for (int k = 0; k < n_i; k++ ) evaluator->add_point_center(itrface.at(k), solver->weights[n_ie + k]);
+	for (int k = 0; k < n_p; k++ ){
+		evaluator->add_derivative_center(planar.at(k), 1.0, 0.0, 0.0, solver->weights[n_ie + n_i + 3*k]);
+		evaluator->add_derivative_center(planar.at(k), 0.0, 1.0, 0.0, solver->weights[n_ie + n_i + 3*k + 1]);
+		evaluator->add_derivative_center(planar.at(k), 0.0, 0.0, 1.0, solver->weights[n_ie + n_i + 3*k + 2]);
+	}
+	for (int k = 0; k < n_t; k++ ){
+		Tangent &t = tangent.at(k);
+		evaluator->add_derivative_center(t, t.tx(), t.ty(), t.tz(), solver->weights[n_ie + n_i + 3*n_p + k]);
+	}
+	if (b_parameters.poly_term)
+	{
+		int n_c = n_ie + n_i + 3*n_p + n_t;
+		evaluator->set_polynomial(p_basis, solver->weights.tail(solver->weights.size() - n_c));
+	}
+	evaluator->pack();
+	return evaluator;
+}
+
 void Single_Surface::eval_vector_interpolant_at_point( Point &p )
 {
 	int n_ie = b_parameters.n_inequality;
-	int n_i = b_parameters.n_interface;
-	int n_p = b_parameters.n_planar;
-	int n_t = b_parameters.n_tangent;
+	std::vector<Interface> &itrface = _interface_centers();
+	std::vector<Planar> &planar = _planar_centers();
+	std::vector<Tangent> &tangent = _tangent_centers();
+	int n_i = (int)itrface.size();
+	int n_p = (int)planar.size();
+	int n_t = (int)tangent.size();
 
 	Kernel *kernel_j = kernel->clone();
 	double elemsum_1_x = 0.0;
@@ -569,37 +695,37 @@ void Single_Surface::eval_vector_interpolant_at_point( Point &p )
 	double poly_z = 0.0;
 	// inequality constraints
 	for (int k = 0; k < n_ie; k++ ){
-		kernel->set_points(p, b_input.inequality->at(k));
-		elemsum_1_x += solver->weights[k] * kernel->basis_planar_x_pt();
-		elemsum_1_y += solver->weights[k] * kernel->basis_planar_y_pt();
-		elemsum_1_z += solver->weights[k] * kernel->basis_planar_z_pt();
+		kernel_j->set_points(p, b_input.inequality->at(k));
+		elemsum_1_x += solver->weights[k] * kernel_j->basis_planar_x_pt();
+		elemsum_1_y += solver->weights[k] * kernel_j->basis_planar_y_pt();
+		elemsum_1_z += solver->weights[k] * kernel_j->basis_planar_z_pt();
 	}
 	// interface constraints 
 	for (int k = 0; k < n_i; k++ ){
-		kernel->set_points(p, b_input.itrface->at(k));
-		elemsum_1_x += solver->weights[n_ie + k] * kernel->basis_planar_x_pt();
-		elemsum_1_y += solver->weights[n_ie + k] * kernel->basis_planar_y_pt();
-		elemsum_1_z += solver->weights[n_ie + k] * kernel->basis_planar_z_pt();
+		kernel_j->set_points(p, itrface.at(k));
+		elemsum_1_x += solver->weights[n_ie + k] * kernel_j->basis_planar_x_pt();
+		elemsum_1_y += solver->weights[n_ie + k] * kernel_j->basis_planar_y_pt();
+		elemsum_1_z += solver->weights[n_ie + k] * kernel_j->basis_planar_z_pt();
 	}
 	// normal constraints
 	for (int k = 0; k < n_p; k++ ){
-		kernel->set_points(p, b_input.planar->at(k));
-		elemsum_2_x += solver->weights[n_ie + n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDX);
-		elemsum_2_x += solver->weights[n_ie + n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDY);
-		elemsum_2_x += solver->weights[n_ie + n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DXDZ);
-		elemsum_2_y += solver->weights[n_ie + n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDX);
-		elemsum_2_y += solver->weights[n_ie + n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDY);
-		elemsum_2_y += solver->weights[n_ie + n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DYDZ);
-		elemsum_2_z += solver->weights[n_ie + n_i + 0 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDX);
-		elemsum_2_z += solver->weights[n_ie + n_i + 1 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDY);
-		elemsum_2_z += solver->weights[n_ie + n_i + 2 + 3*k] * kernel->basis_planar_planar(Parameter_Types::DZDZ);
+		kernel_j->set_points(p, planar.at(k));
+		elemsum_2_x += solver->weights[n_ie + n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDX);
+		elemsum_2_x += solver->weights[n_ie + n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDY);
+		elemsum_2_x += solver->weights[n_ie + n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DXDZ);
+		elemsum_2_y += solver->weights[n_ie + n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDX);
+		elemsum_2_y += solver->weights[n_ie + n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDY);
+		elemsum_2_y += solver->weights[n_ie + n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DYDZ);
+		elemsum_2_z += solver->weights[n_ie + n_i + 0 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDX);
+		elemsum_2_z += solver->weights[n_ie + n_i + 1 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDY);
+		elemsum_2_z += solver->weights[n_ie + n_i + 2 + 3*k] * kernel_j->basis_planar_planar(Parameter_Types::DZDZ);
 	}
 	// tangent constraints
 	for (int k = 0; k < n_t; k++ ){
-		kernel->set_points(p, b_input.tangent->at(k));
-		elemsum_3_x += solver->weights[n_ie + n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DX);
-		elemsum_3_y += solver->weights[n_ie + n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DY);
-		elemsum_3_z += solver->weights[n_ie + n_i + 3*n_p + k] * kernel->basis_planar_tangent(Parameter_Types::DZ);
+		kernel_j->set_points(p, tangent.at(k));
+		elemsum_3_x += solver->weights[n_ie + n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DX);
+		elemsum_3_y += solver->weights[n_ie + n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DY);
+		elemsum_3_z += solver->weights[n_ie + n_i + 3*n_p + k] * kernel_j->basis_planar_tangent(Parameter_Types::DZ);
 	}
 	if (b_parameters.poly_term)
 	{
@@ -809,6 +935,273 @@ bool Single_Surface::process_input_data()
 	return true;
 }
 
+Single_Surface::Constraint_Kind Single_Surface::_get_constraint(const int &index, Point *&point, int &component)
+{
+	int n_ie = b_parameters.n_inequality;
+	int n_i = b_parameters.n_interface;
+	int n_p = b_parameters.n_planar;
+	int n_t = b_parameters.n_tangent;
+
+	// same constraint order as the interpolation matrix
+	component = 0;
+	point = NULL;
+	int j = index;
+	if (j < n_ie)
+	{
+		point = &b_input.inequality->at(j);
+		return Point_constraint;
+	}
+	j -= n_ie;
+	if (j < n_i)
+	{
+		point = &b_input.itrface->at(j);
+		return Point_constraint;
+	}
+	j -= n_i;
+	if (j < 3*n_p)
+	{
+		point = &b_input.planar->at(j/3);
+		component = j%3;
+		return Planar_constraint;
+	}
+	j -= 3*n_p;
+	if (j < n_t)
+	{
+		point = &b_input.tangent->at(j);
+		return Tangent_constraint;
+	}
+	return Polynomial_term;
+}
+
+double Single_Surface::_get_interpolation_matrix_entry(Kernel *kernel_j, const int &row, const int &column)
+{
+	Point *p_row = NULL;
+	Point *p_column = NULL;
+	int c_row = 0;
+	int c_column = 0;
+	Constraint_Kind row_kind = _get_constraint(row, p_row, c_row);
+	Constraint_Kind column_kind = _get_constraint(column, p_column, c_column);
+	kernel_j->set_points(*p_row, *p_column);
+
+	if (row_kind == Point_constraint)
+	{
+		if (column_kind == Point_constraint) return kernel_j->basis_pt_pt();
+		if (column_kind == Planar_constraint)
+		{
+			if (c_column == 0) return kernel_j->basis_pt_planar_x();
+			if (c_column == 1) return kernel_j->basis_pt_planar_y();
+			return kernel_j->basis_pt_planar_z();
+		}
+		return kernel_j->basis_pt_tangent();
+	}
+	if (row_kind == Planar_constraint)
+	{
+		if (column_kind == Point_constraint)
+		{
+			if (c_row == 0) return kernel_j->basis_planar_x_pt();
+			if (c_row == 1) return kernel_j->basis_planar_y_pt();
+			return kernel_j->basis_planar_z_pt();
+		}
+		if (column_kind == Planar_constraint) return kernel_j->basis_planar_planar((Parameter_Types::SecondDerivatives)(3*c_row + c_column));
+		return kernel_j->basis_planar_tangent((Parameter_Types::FirstDerivatives)c_row);
+	}
+	// tangent row
+	if (column_kind == Point_constraint) return kernel_j->basis_tangent_pt();
+	if (column_kind == Planar_constraint) return kernel_j->basis_tangent_planar((Parameter_Types::FirstDerivatives)c_column);
+	return kernel_j->basis_tangent_tangent();
+}
+
+bool Single_Surface::_get_radial_matrix_geometry(Radial_Matrix_Geometry &geometry)
+{
+	// the modified basis and anisotropic kernels are not functions of the distance alone
+	if (rbf_kernel == NULL || kernel != rbf_kernel) return false;
+	double r2 = 0.0;
+	double phi = 0.0;
+	double dphi = 0.0;
+	if (!rbf_kernel->radial_profile(1, &r2, &phi, &dphi)) return false;
+	// constraint rows of the leave one out system (linear problems)
+	int n = b_parameters.n_inequality + b_parameters.n_interface + 3*b_parameters.n_planar + b_parameters.n_tangent;
+	if (n != b_parameters.n_equality) return false;
+
+	MatrixXd positions(3, n);
+	geometry.directions = MatrixXd::Zero(3, n);
+	geometry.derivative.assign(n, false);
+	for (int j = 0; j < n; j++ ){
+		Point *point = NULL;
+		int component = 0;
+		Constraint_Kind kind = _get_constraint(j, point, component);
+		positions(0,j) = point->x();
+		positions(1,j) = point->y();
+		positions(2,j) = point->z();
+		if (kind == Planar_constraint)
+		{
+			geometry.directions(component,j) = 1.0;
+			geometry.derivative[j] = true;
+		}
+		else if (kind == Tangent_constraint)
+		{
+			Tangent *tangent = static_cast<Tangent*>(point);
+			geometry.directions(0,j) = tangent->tx();
+			geometry.directions(1,j) = tangent->ty();
+			geometry.directions(2,j) = tangent->tz();
+			geometry.derivative[j] = true;
+		}
+	}
+	geometry.r2.resize(n, n);
+	geometry.offsets.resize(n, n);
+	for (int j = 0; j < n; j++ ){
+		for (int i = 0; i < n; i++ ){
+			Vector3d d = positions.col(i) - positions.col(j);
+			geometry.r2(i,j) = d.squaredNorm();
+			geometry.offsets(i,j) = d.dot(geometry.directions.col(j));
+		}
+	}
+	return true;
+}
+
+void Single_Surface::_select_reduced_centers(const int &n_centers, std::vector<int> &interface_indices, std::vector<int> &planar_indices, std::vector<int> &tangent_indices)
+{
+	int n_i = b_parameters.n_interface;
+	int n_p = b_parameters.n_planar;
+	int n_t = b_parameters.n_tangent;
+	int n = n_i + n_p + n_t;
+
+	std::vector<Point> locations;
+	for (int j = 0; j < n_i; j++ ) locations.push_back(b_input.itrface->at(j));
+	for (int j = 0; j < n_p; j++ ) locations.push_back(b_input.planar->at(j));
+	for (int j = 0; j < n_t; j++ ) locations.push_back(b_input.tangent->at(j));
+
+	// farthest point sampling: each new center is the location farthest from the centers already chosen
+	std::vector<int> order;
+	std::vector<double> radius;
+	farthest_point_order(locations, n_centers, order, radius);
+	std::vector<bool> selected(n, false);
+	for (int k = 0; k < (int)order.size(); k++ ) selected[order[k]] = true;
+
+	interface_indices.clear();
+	planar_indices.clear();
+	tangent_indices.clear();
+	for (int j = 0; j < n; j++ ){
+		if (!selected[j]) continue;
+		if (j < n_i) interface_indices.push_back(j);
+		else if (j < n_i + n_p) planar_indices.push_back(j - n_i);
+		else tangent_indices.push_back(j - n_i - n_p);
+	}
+}
+
+bool Single_Surface::_setup_reduced_center_solver()
+{
+	int n_i = b_parameters.n_interface;
+	int n_p = b_parameters.n_planar;
+	int n_e = b_parameters.n_equality;
+	int n_c = b_parameters.n_constraints;
+	int n_poly = b_parameters.poly_term ? b_parameters.n_poly_terms : 0;
+
+	std::vector<int> interface_centers;
+	std::vector<int> planar_centers;
+	std::vector<int> tangent_centers;
+	_select_reduced_centers(m_parameters.reduced_centers, interface_centers, planar_centers, tangent_centers);
+
+	// interpolation matrix columns of the centers, in the usual constraint order
+	std::vector<int> columns;
+	for (int j = 0; j < (int)interface_centers.size(); j++ ) columns.push_back(interface_centers[j]);
+	for (int j = 0; j < (int)planar_centers.size(); j++ ){
+		for (int c = 0; c < 3; c++ ) columns.push_back(n_i + 3*planar_centers[j] + c);
+	}
+	for (int j = 0; j < (int)tangent_centers.size(); j++ ) columns.push_back(n_i + 3*n_p + tangent_centers[j]);
+	int m_k = (int)columns.size();
+	int m = m_k + n_poly;
+	if (n_e < m)
+	{
+		error_msg.append(" Fewer constraints than reduced centers.");
+		return false;
+	}
+
+	MatrixXd poly_matrix;
+	if (n_poly > 0)
+	{
+		poly_matrix.resize(n_poly, n_c);
+		if (!_get_polynomial_matrix_block(poly_matrix)) return false;
+	}
+	VectorXd equality_values(n_e + n_poly);
+	get_equality_values(equality_values);
+
+	// design matrix | A(:,centers)  PT | and side conditions | P(:,centers)  0 | w = 0
+	MatrixXd design_matrix(n_e, m);
+	MatrixXd side_conditions = MatrixXd::Zero(n_poly, m);
+	#pragma omp parallel
+	{
+		Kernel *kernel_j = kernel->clone();
+		#pragma omp for schedule(dynamic)
+		for (int k = 0; k < m_k; k++ ){
+			for (int row = 0; row < n_e; row++ ) design_matrix(row,k) = _get_interpolation_matrix_entry(kernel_j, row, columns[k]);
+		}
+		delete kernel_j;
+	}
+	for (int k = 0; k < n_poly; k++ ){
+		design_matrix.col(m_k + k) = poly_matrix.row(k).transpose();
+		for (int j = 0; j < m_k; j++ ) side_conditions(k,j) = poly_matrix(k,columns[j]);
+	}
+
+	Linear_Least_Squares *lls = new Linear_Least_Squares(design_matrix, equality_values.head(n_e), side_conditions, m_k, m_parameters.reduced_center_regularization);
+	if (!lls->solve())
+	{
+		error_msg.append(" Reduced center Least Squares Solver failure.");
+		delete lls;
+		return false;
+	}
+	int n_centers = (int)(interface_centers.size() + planar_centers.size() + tangent_centers.size());
+	cout<<" Linear solver: least squares on "<<n_centers<<" centers for "<<n_e<<" constraints, RMS residual = "<<lls->rms_residual()<<endl;
+
+	// from here on the interpolant is evaluated on the centers, b_input keeps all the constraints
+	_reduced_interface.clear();
+	_reduced_planar.clear();
+	_reduced_tangent.clear();
+	for (int j = 0; j < (int)interface_centers.size(); j++ ) _reduced_interface.push_back(b_input.itrface->at(interface_centers[j]));
+	for (int j = 0; j < (int)planar_centers.size(); j++ ) _reduced_planar.push_back(b_input.planar->at(planar_centers[j]));
+	for (int j = 0; j < (int)tangent_centers.size(); j++ ) _reduced_tangent.push_back(b_input.tangent->at(tangent_centers[j]));
+	_use_reduced_centers = true;
+	solver = lls;
+
+	return true;
+}
+
+bool Single_Surface::get_interpolation_matrix_columns( const int &first, const int &count, const MatrixXd &poly_matrix, MatrixXd &columns )
+{
+	int n_c = b_parameters.n_constraints;
+	int n_poly = b_parameters.poly_term ? b_parameters.n_poly_terms : 0;
+	int n = n_c + n_poly;
+	if (first < 0 || count < 0 || first + count > n) return false;
+	if (n_poly > 0 && ((int)poly_matrix.rows() != n_poly || (int)poly_matrix.cols() != n_c)) return false;
+
+	columns.resize(n, count);
+	#pragma omp parallel
+	{
+		Kernel *kernel_j = kernel->clone();
+		#pragma omp for schedule(dynamic)
+		for (int k = 0; k < count; k++ ){
+			int column = first + k;
+			if (column < n_c)
+			{
+				// | A  |
+				// | P  |
+				for (int row = 0; row < n_c; row++ ) columns(row,k) = _get_interpolation_matrix_entry(kernel_j, row, column);
+				if (n_poly > 0) columns.col(k).tail(n_poly) = poly_matrix.col(column);
+			}
+			else
+			{
+				// | PT |
+				// | 0  |
+				columns.col(k).head(n_c) = poly_matrix.row(column - n_c).transpose();
+				columns.col(k).tail(n_poly).setZero();
+			}
+		}
+		delete kernel_j;
+	}
+
+	return true;
+}
+
 bool Single_Surface::get_interpolation_matrix( MatrixXd &interpolation_matrix )
 {
 	int n_ie = b_parameters.n_inequality;
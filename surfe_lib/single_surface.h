@@ -37,11 +37,36 @@
 #include <surfe_lib_module.h> // macro for importing / exporting dll
 
 #include <modeling_methods.h>
+#include <out_of_core_solver.h>
 
 class SURFE_LIB_EXPORT Single_Surface : public GRBF_Modelling_Methods {
 private:
 	bool _get_polynomial_matrix_block(MatrixXd &poly_matrix);
 	bool _insert_polynomial_matrix_blocks_in_interpolation_matrix(const MatrixXd &poly_matrix, MatrixXd &interpolation_matrix);
+	// warm starting quadratic solves (e.g. between greedy iterations)
+	Quadratic_Predictor_Corrector *_last_qpc;
+	Quadratic_Predictor_Corrector_LOQO *_last_loqo;
+	basic_parameters _last_qp_parameters; // parameters of the last quadratic solve
+	// greedy linear solves update the previous system instead of factoring a new one
+	Linear_Updatable_Solver *_last_linear;
+	basic_parameters _last_linear_parameters;
+	bool _get_warm_start_map(const basic_parameters &previous, std::vector<int> &map);
+	// constraint type of a row/column of the interpolation matrix
+	enum Constraint_Kind {Point_constraint,Planar_constraint,Tangent_constraint,Polynomial_term};
+	Constraint_Kind _get_constraint(const int &index, Point *&point, int &component);
+	double _get_interpolation_matrix_entry(Kernel *kernel_j, const int &row, const int &column);
+	bool _get_radial_matrix_geometry(Radial_Matrix_Geometry &geometry);
+	// least squares fit with the weights of a subset of the constraint locations (model_parameters::reduced_centers)
+	void _select_reduced_centers(const int &n_centers, std::vector<int> &interface_indices, std::vector<int> &planar_indices, std::vector<int> &tangent_indices);
+	bool _setup_reduced_center_solver();
+	// centers of the reduced center fit: the interpolant is built on these instead of the b_input constraints
+	bool _use_reduced_centers;
+	std::vector<Interface> _reduced_interface;
+	std::vector<Planar> _reduced_planar;
+	std::vector<Tangent> _reduced_tangent;
+	std::vector<Interface> &_interface_centers() { return _use_reduced_centers ? _reduced_interface : *b_input.itrface; }
+	std::vector<Planar> &_planar_centers() { return _use_reduced_centers ? _reduced_planar : *b_input.planar; }
+	std::vector<Tangent> &_tangent_centers() { return _use_reduced_centers ? _reduced_tangent : *b_input.tangent; }
 public:
 	// Constructor/Destructor
 	Single_Surface(const model_parameters& m_p, const Basic_input& basic_i);
@@ -49,6 +74,8 @@ public:
 	// Methods
 	Polynomial_Basis *create_polynomial_basis(const int &poly_order);
 	bool get_interpolation_matrix(MatrixXd &interpolation_matrix);
+	// columns [first, first + count) of the interpolation matrix, for matrices too large to be assembled at once
+	bool get_interpolation_matrix_columns(const int &first, const int &count, const MatrixXd &poly_matrix, MatrixXd &columns);
 	bool get_equality_values(VectorXd &equality_values);
 	bool get_inequality_matrix(const MatrixXd &interpolation_matrix, MatrixXd &inequality_matrix);
 	bool get_inequality_values(VectorXd &inequality_values);
@@ -62,9 +89,27 @@ public:
 	bool measure_residuals(Basic_input &input);
 	bool append_greedy_input(Basic_input &input);
 	bool convert_modified_kernel_to_rbf_kernel();
-	GRBF_Modelling_Methods *clone() { return new Single_Surface(*this); }
+	Tiled_Evaluator *get_tiled_evaluator();
+	GRBF_Modelling_Methods *clone();
 	// Attributes
 	Polynomial_Basis *p_basis;
 };
 
+// Supplies the interpolation matrix of a Single_Surface to the out of core solver one column panel at a time
+class Single_Surface_Columns : public Matrix_Column_Assembler {
+private:
+	Single_Surface *_surface;
+	MatrixXd _poly_matrix;
+	int _size;
+public:
+	Single_Surface_Columns(Single_Surface *surface, const MatrixXd &poly_matrix, const int &size)
+	{
+		_surface = surface;
+		_poly_matrix = poly_matrix;
+		_size = size;
+	}
+	int size() const { return _size; }
+	bool get_columns(const int &first, const int &count, MatrixXd &columns) { return _surface->get_interpolation_matrix_columns(first, count, _poly_matrix, columns); }
+};
+
 #endif
@@ -73,6 +73,7 @@ public:
 	bool measure_residuals(Basic_input &input) { return true; } // TO implement
 	bool append_greedy_input(Basic_input &input) { return true; } // TO implement
 	bool convert_modified_kernel_to_rbf_kernel();
+	Tiled_Evaluator *get_tiled_evaluator();
 	GRBF_Modelling_Methods *clone() { return new Stratigraphic_Surfaces(*this); }
 	// Attributes
 	Polynomial_Basis *p_basis;
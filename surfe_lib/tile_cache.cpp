@@ -0,0 +1,272 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <tile_cache.h>
+#include <modeling_methods.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// floor(a / b) for b > 0
+static int _floor_div(const int &a, const int &b)
+{
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+bool Evaluation_Tile_Cache::Tile_Key::operator<(const Tile_Key &other) const
+{
+	if (level != other.level) return level < other.level;
+	for (int d = 2; d >= 0; d-- ) if (index[d] != other.index[d]) return index[d] < other.index[d];
+	return false;
+}
+
+Evaluation_Tile_Cache::Evaluation_Tile_Cache(GRBF_Modelling_Methods *method, Tiled_Evaluator *evaluator, const double origin[3], const double spacing[3],
+	const int &tile_size, const size_t &max_bytes, const int &n_prefetch_threads)
+{
+	_method = method;
+	_evaluator = evaluator;
+	for (int d = 0; d < 3; d++ )
+	{
+		_origin[d] = origin[d];
+		_spacing[d] = spacing[d];
+	}
+	_tile_size = std::max(1, tile_size);
+	_n_fields = method->n_scalar_fields();
+	_max_bytes = max_bytes;
+	_bytes = 0;
+	_hits = 0;
+	_misses = 0;
+	_stop = false;
+	for (int t = 0; t < n_prefetch_threads; t++ ) _workers.push_back(std::thread(&Evaluation_Tile_Cache::_prefetch_loop, this));
+}
+
+Evaluation_Tile_Cache::~Evaluation_Tile_Cache()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (int t = 0; t < (int)_workers.size(); t++ ) _workers[t].join();
+	if (_evaluator != NULL) delete _evaluator;
+}
+
+void Evaluation_Tile_Cache::_insert(const Tile_Key &key, std::promise<Tile_Values> &promise)
+{
+	Tile &tile = _tiles[key];
+	tile.values = promise.get_future().share();
+	_recent.push_front(key);
+	tile.recent = _recent.begin();
+	_bytes += _tile_bytes();
+	// a query holds the values of its tiles, evicting them only drops them from the cache
+	while (_bytes > _max_bytes && _recent.size() > 1)
+	{
+		_tiles.erase(_recent.back());
+		_recent.pop_back();
+		_bytes -= _tile_bytes();
+	}
+}
+
+void Evaluation_Tile_Cache::_touch(Tile &tile)
+{
+	_recent.splice(_recent.begin(), _recent, tile.recent);
+}
+
+Evaluation_Tile_Cache::Tile_Values Evaluation_Tile_Cache::_evaluate_tile(const Tile_Key &key, const bool &parallel) const
+{
+	double origin[3];
+	double spacing[3];
+	int dims[3] = { _tile_size, _tile_size, _tile_size };
+	for (int d = 0; d < 3; d++ )
+	{
+		spacing[d] = ldexp(_spacing[d], key.level);
+		origin[d] = _origin[d] + (double)key.index[d]*_tile_size*spacing[d];
+	}
+	int n = _tile_size*_tile_size*_tile_size;
+	std::shared_ptr<std::vector<float> > values(new std::vector<float>((size_t)n*_n_fields));
+	float *out = &(*values)[0];
+	int n_blocks = (n + Tiled_Evaluator::point_block - 1) / Tiled_Evaluator::point_block;
+	#pragma omp parallel for schedule(dynamic) if (parallel)
+	for (int b = 0; b < n_blocks; b++ ){
+		int begin = b*Tiled_Evaluator::point_block;
+		int end = std::min(n, begin + (int)Tiled_Evaluator::point_block);
+		if (_evaluator != NULL) _evaluator->evaluate_grid(origin, spacing, dims, NULL, begin, end, out);
+		else
+		{
+			for (int m = begin; m < end; m++ ){
+				Evaluation_Point p(origin[0] + (m % dims[0])*spacing[0], origin[1] + ((m / dims[0]) % dims[1])*spacing[1],
+					origin[2] + (m / (dims[0]*dims[1]))*spacing[2]);
+				_method->eval_scalar_interpolant_at_point(p);
+				if (_n_fields > 1) for (int f = 0; f < _n_fields; f++ ) out[(size_t)m*_n_fields + f] = (float)p.scalar_field(f);
+				else out[m] = (float)p.scalar_field();
+			}
+		}
+	}
+	return values;
+}
+
+void Evaluation_Tile_Cache::_prefetch_loop()
+{
+	while (true)
+	{
+		Tile_Key key;
+		std::promise<Tile_Values> promise;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [this] { return _stop || !_prefetch.empty(); });
+			if (_stop) return;
+			key = _prefetch.front();
+			_prefetch.pop_front();
+			if (_tiles.count(key) > 0) continue;
+			_insert(key, promise);
+		}
+		promise.set_value(_evaluate_tile(key, false));
+	}
+}
+
+bool Evaluation_Tile_Cache::query(const int &level, const int lower[3], const int dims[3], float *out, const bool &prefetch)
+{
+	if (dims[0] <= 0 || dims[1] <= 0 || dims[2] <= 0) return false;
+	int first[3];
+	int last[3];
+	for (int d = 0; d < 3; d++ )
+	{
+		first[d] = _floor_div(lower[d], _tile_size);
+		last[d] = _floor_div(lower[d] + dims[d] - 1, _tile_size);
+	}
+
+	// cached tiles, or entries for the missing ones
+	std::vector<Tile_Key> keys;
+	std::vector<std::shared_future<Tile_Values> > values;
+	std::vector<std::pair<Tile_Key, std::promise<Tile_Values> > > missing;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (int k = first[2]; k <= last[2]; k++ )
+			for (int j = first[1]; j <= last[1]; j++ )
+				for (int i = first[0]; i <= last[0]; i++ )
+				{
+					Tile_Key key = { level, { i, j, k } };
+					std::map<Tile_Key, Tile>::iterator found = _tiles.find(key);
+					if (found != _tiles.end())
+					{
+						_touch(found->second);
+						values.push_back(found->second.values);
+						_hits++;
+					}
+					else
+					{
+						missing.push_back(std::make_pair(key, std::promise<Tile_Values>()));
+						_insert(key, missing.back().second);
+						values.push_back(_tiles[key].values);
+						_misses++;
+					}
+					keys.push_back(key);
+				}
+	}
+	for (int t = 0; t < (int)missing.size(); t++ ) missing[t].second.set_value(_evaluate_tile(missing[t].first, true));
+
+	// overlap of each tile with the box, row by row
+	for (int t = 0; t < (int)keys.size(); t++ )
+	{
+		Tile_Values tile = values[t].get();
+		int begin[3];
+		int end[3];
+		for (int d = 0; d < 3; d++ )
+		{
+			begin[d] = std::max(lower[d], keys[t].index[d]*_tile_size);
+			end[d] = std::min(lower[d] + dims[d], (keys[t].index[d] + 1)*_tile_size);
+		}
+		size_t row = (size_t)(end[0] - begin[0])*_n_fields*sizeof(float);
+		for (int k = begin[2]; k < end[2]; k++ )
+			for (int j = begin[1]; j < end[1]; j++ )
+			{
+				size_t source = (size_t)(begin[0] - keys[t].index[0]*_tile_size) + _tile_size*((size_t)(j - keys[t].index[1]*_tile_size) +
+					_tile_size*(size_t)(k - keys[t].index[2]*_tile_size));
+				size_t target = (size_t)(begin[0] - lower[0]) + dims[0]*((size_t)(j - lower[1]) + dims[1]*(size_t)(k - lower[2]));
+				memcpy(out + target*_n_fields, &(*tile)[source*_n_fields], row);
+			}
+	}
+
+	if (prefetch && !_workers.empty())
+	{
+		// the ring of tiles around the box, faces first, as far as the cache holds it next to the box
+		std::vector<std::pair<int, Tile_Key> > ring;
+		for (int k = first[2] - 1; k <= last[2] + 1; k++ )
+			for (int j = first[1] - 1; j <= last[1] + 1; j++ )
+				for (int i = first[0] - 1; i <= last[0] + 1; i++ )
+				{
+					int outside = (i < first[0] || i > last[0]) + (j < first[1] || j > last[1]) + (k < first[2] || k > last[2]);
+					if (outside == 0) continue;
+					Tile_Key key = { level, { i, j, k } };
+					ring.push_back(std::make_pair(outside, key));
+				}
+		std::stable_sort(ring.begin(), ring.end(),
+			[](const std::pair<int, Tile_Key> &a, const std::pair<int, Tile_Key> &b) { return a.first < b.first; });
+		long long room = (long long)(_max_bytes / _tile_bytes()) - (long long)keys.size();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_prefetch.clear();
+			for (int r = 0; r < (int)ring.size() && r < room; r++ ) _prefetch.push_back(ring[r].second);
+		}
+		_wake.notify_all();
+	}
+	return true;
+}
+
+void Evaluation_Tile_Cache::clear()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_prefetch.clear();
+	_tiles.clear();
+	_recent.clear();
+	_bytes = 0;
+}
+
+size_t Evaluation_Tile_Cache::memory()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _bytes;
+}
+
+long long Evaluation_Tile_Cache::hits()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _hits;
+}
+
+long long Evaluation_Tile_Cache::misses()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _misses;
+}
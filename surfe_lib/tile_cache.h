@@ -0,0 +1,114 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef tile_cache_h
+#define tile_cache_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <tiled_evaluation.h>
+
+#include <vector>
+#include <list>
+#include <map>
+#include <deque>
+#include <memory>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+class GRBF_Modelling_Methods;
+
+// Scalar field(s) of a solved interpolant served in tiles for interactive queries, e.g. a viewer asking for overlapping
+// sub-volumes and slices while panning and zooming. The grid of level of detail l is origin + (i, j, k)*spacing*2^l,
+// cut into tiles of tile_size^3 nodes. A tile is evaluated as floats when first needed and kept in a least recently
+// used cache of at most max_bytes, so repeated and overlapping queries are copies. After a query, the tiles around the
+// queried box are evaluated on background threads. Thread safe.
+class SURFE_LIB_EXPORT Evaluation_Tile_Cache {
+private:
+	struct Tile_Key {
+		int level;
+		int index[3];
+		bool operator<(const Tile_Key &other) const;
+	};
+	typedef std::shared_ptr<const std::vector<float> > Tile_Values;
+	struct Tile {
+		std::shared_future<Tile_Values> values; // shared by the queries waiting on a tile being evaluated
+		std::list<Tile_Key>::iterator recent; // position in _recent
+	};
+	GRBF_Modelling_Methods *_method;
+	Tiled_Evaluator *_evaluator; // NULL: point by point through _method
+	double _origin[3];
+	double _spacing[3];
+	int _tile_size;
+	int _n_fields;
+	size_t _max_bytes;
+	size_t _bytes;
+	std::map<Tile_Key, Tile> _tiles;
+	std::list<Tile_Key> _recent; // most recently used first
+	long long _hits;
+	long long _misses;
+	std::mutex _mutex;
+	// background evaluation of the tiles around the last query
+	std::deque<Tile_Key> _prefetch;
+	std::vector<std::thread> _workers;
+	std::condition_variable _wake;
+	bool _stop;
+	size_t _tile_bytes() const { return (size_t)_tile_size*_tile_size*_tile_size*_n_fields*sizeof(float); }
+	// entry for a tile not cached yet, least recently used tiles evicted past max_bytes. Under _mutex
+	void _insert(const Tile_Key &key, std::promise<Tile_Values> &promise);
+	void _touch(Tile &tile);
+	Tile_Values _evaluate_tile(const Tile_Key &key, const bool &parallel) const;
+	void _prefetch_loop();
+public:
+	// evaluator (deleted with the cache) or NULL to evaluate point by point. See GRBF_Modelling_Methods::create_tile_cache
+	Evaluation_Tile_Cache(GRBF_Modelling_Methods *method, Tiled_Evaluator *evaluator, const double origin[3], const double spacing[3],
+		const int &tile_size, const size_t &max_bytes, const int &n_prefetch_threads);
+	// waits for the background evaluations in progress
+	~Evaluation_Tile_Cache();
+	// nodes lower + (i, j, k), 0 <= i < dims[0] ..., of the grid of level, written to out[(i + dims[0]*(j + dims[1]*k))*n_fields() + field].
+	// lower may be negative. The missing tiles are evaluated in parallel, then the ring of tiles around the box is
+	// queued for the background threads if prefetch
+	bool query(const int &level, const int lower[3], const int dims[3], float *out, const bool &prefetch = true);
+	void clear();
+	int n_fields() const { return _n_fields; }
+	int tile_size() const { return _tile_size; }
+	// bytes held by the cached tiles
+	size_t memory();
+	// tiles found in the cache (evaluated or being evaluated) and evaluated by the queries
+	long long hits();
+	long long misses();
+};
+
+#endif
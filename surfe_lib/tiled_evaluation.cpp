@@ -0,0 +1,616 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <tiled_evaluation.h>
+
+#include <algorithm>
+#include <map>
+#include <typeinfo>
+
+const int Tiled_Evaluator::point_block;
+const int Tiled_Evaluator::center_block;
+
+Tiled_Evaluator::Tiled_Evaluator(RBFKernel *kernel, const int &n_fields)
+{
+	_kernel = kernel->clone();
+	_p_basis = NULL;
+	_n_fields = n_fields;
+}
+
+Tiled_Evaluator::~Tiled_Evaluator()
+{
+	delete _kernel;
+	if (_p_basis != NULL) delete _p_basis;
+}
+
+bool Tiled_Evaluator::supported() const
+{
+	double r2 = 1.0;
+	double phi = 0.0;
+	double dphi = 0.0;
+	return _kernel->radial_profile(1, &r2, &phi, &dphi);
+}
+
+void Tiled_Evaluator::_add_center(const Point &p, const double &value, const double &dx, const double &dy, const double &dz, const double *w)
+{
+	_centers.x.push_back(p.x());
+	_centers.y.push_back(p.y());
+	_centers.z.push_back(p.z());
+	_centers.c.push_back(p.c());
+	_centers.value.push_back(value);
+	_centers.dx.push_back(dx);
+	_centers.dy.push_back(dy);
+	_centers.dz.push_back(dz);
+	for (int k = 0; k < _n_fields; k++ ) _center_weights.push_back(w[k]);
+}
+
+void Tiled_Evaluator::add_point_center(const Point &p, const double *w)
+{
+	_add_center(p, 1.0, 0.0, 0.0, 0.0, w);
+}
+
+void Tiled_Evaluator::add_derivative_center(const Point &p, const double &dx, const double &dy, const double &dz, const double *w)
+{
+	_add_center(p, 0.0, dx, dy, dz, w);
+}
+
+void Tiled_Evaluator::set_polynomial(Polynomial_Basis *p_basis, const MatrixXd &poly_weights)
+{
+	if (_p_basis != NULL) delete _p_basis;
+	_p_basis = p_basis->clone();
+	_poly_weights = poly_weights;
+}
+
+// polynomial bases of merged evaluators side by side
+class Stacked_Polynomial_Basis : public Polynomial_Basis {
+private:
+	std::vector<Polynomial_Basis *> _bases;
+	VectorXd _stack(const int &derivative)
+	{
+		std::vector<VectorXd> parts(_bases.size());
+		int n = 0;
+		for (int k = 0; k < (int)_bases.size(); k++ )
+		{
+			_bases[k]->set_point(*_p);
+			if (derivative == 0) parts[k] = _bases[k]->basis();
+			else if (derivative == 1) parts[k] = _bases[k]->dx();
+			else if (derivative == 2) parts[k] = _bases[k]->dy();
+			else parts[k] = _bases[k]->dz();
+			n += (int)parts[k].size();
+		}
+		VectorXd stacked(n);
+		n = 0;
+		for (int k = 0; k < (int)parts.size(); k++ )
+		{
+			stacked.segment(n, parts[k].size()) = parts[k];
+			n += (int)parts[k].size();
+		}
+		return stacked;
+	}
+public:
+	Stacked_Polynomial_Basis(const std::vector<Polynomial_Basis *> &bases)
+	{
+		for (int k = 0; k < (int)bases.size(); k++ ) _bases.push_back(bases[k]->clone());
+	}
+	~Stacked_Polynomial_Basis()
+	{
+		for (int k = 0; k < (int)_bases.size(); k++ ) delete _bases[k];
+	}
+	VectorXd basis() { return _stack(0); }
+	VectorXd dx() { return _stack(1); }
+	VectorXd dy() { return _stack(2); }
+	VectorXd dz() { return _stack(3); }
+	Stacked_Polynomial_Basis *clone() { return new Stacked_Polynomial_Basis(_bases); }
+};
+
+Tiled_Evaluator *Tiled_Evaluator::merge(const std::vector<const Tiled_Evaluator *> &evaluators)
+{
+	if (evaluators.empty()) return NULL;
+	// same kernel: same class and profile at a few radii (shape parameter)
+	const double r2[4] = { 0.01, 1.0, 30.0, 1000.0 };
+	double phi[4];
+	double dphi[4];
+	evaluators[0]->_kernel->radial_profile(4, r2, phi, dphi);
+	int n_fields = 0;
+	for (int e = 0; e < (int)evaluators.size(); e++ )
+	{
+		const Tiled_Evaluator *evaluator = evaluators[e];
+		if (typeid(*evaluator->_kernel) != typeid(*evaluators[0]->_kernel)) return NULL;
+		double phi_e[4];
+		double dphi_e[4];
+		evaluator->_kernel->radial_profile(4, r2, phi_e, dphi_e);
+		for (int k = 0; k < 4; k++ ) if (phi_e[k] != phi[k] || dphi_e[k] != dphi[k]) return NULL;
+		n_fields += evaluator->_n_fields;
+	}
+
+	Tiled_Evaluator *merged = new Tiled_Evaluator(evaluators[0]->_kernel, n_fields);
+	std::map<std::vector<double>, int> index; // center -> merged center
+	std::vector<double> key(8);
+	std::vector<double> zeros(n_fields, 0.0);
+	std::vector<Polynomial_Basis *> bases;
+	std::vector<int> poly_evaluators;
+	std::vector<int> poly_fields; // first field of each basis
+	int first = 0;
+	for (int e = 0; e < (int)evaluators.size(); e++ )
+	{
+		const Packed_Centers &centers = evaluators[e]->_centers;
+		for (int j = 0; j < centers.size(); j++ )
+		{
+			key[0] = centers.x[j];
+			key[1] = centers.y[j];
+			key[2] = centers.z[j];
+			key[3] = centers.c[j];
+			key[4] = centers.value[j];
+			key[5] = centers.dx[j];
+			key[6] = centers.dy[j];
+			key[7] = centers.dz[j];
+			std::map<std::vector<double>, int>::iterator it = index.find(key);
+			int m;
+			if (it != index.end()) m = it->second;
+			else
+			{
+				m = merged->n_centers();
+				index[key] = m;
+				Point p(centers.x[j], centers.y[j], centers.z[j], centers.c[j]);
+				merged->_add_center(p, centers.value[j], centers.dx[j], centers.dy[j], centers.dz[j], &zeros[0]);
+			}
+			for (int k = 0; k < evaluators[e]->_n_fields; k++ ) merged->_center_weights[m*n_fields + first + k] += centers.weights(j, k);
+		}
+		if (evaluators[e]->_p_basis != NULL)
+		{
+			bases.push_back(evaluators[e]->_p_basis);
+			poly_evaluators.push_back(e);
+			poly_fields.push_back(first);
+		}
+		first += evaluators[e]->_n_fields;
+	}
+	merged->pack();
+
+	// block diagonal polynomial weights: the terms of a basis only reach the fields of its interpolant
+	if (!bases.empty())
+	{
+		int n_terms = 0;
+		for (int k = 0; k < (int)bases.size(); k++ ) n_terms += (int)evaluators[poly_evaluators[k]]->_poly_weights.rows();
+		MatrixXd poly_weights = MatrixXd::Zero(n_terms, n_fields);
+		n_terms = 0;
+		for (int k = 0; k < (int)bases.size(); k++ )
+		{
+			const MatrixXd &w = evaluators[poly_evaluators[k]]->_poly_weights;
+			poly_weights.block(n_terms, poly_fields[k], w.rows(), w.cols()) = w;
+			n_terms += (int)w.rows();
+		}
+		Stacked_Polynomial_Basis stacked(bases);
+		merged->set_polynomial(&stacked, poly_weights);
+	}
+	return merged;
+}
+
+static void _permute(std::vector<double> &values, const std::vector<int> &order)
+{
+	std::vector<double> permuted(order.size());
+	for (int j = 0; j < (int)order.size(); j++ ) permuted[j] = values[order[j]];
+	values.swap(permuted);
+}
+
+void Tiled_Evaluator::pack()
+{
+	int n_c = n_centers();
+	// point centers first, then derivative centers
+	std::vector<int> order;
+	for (int j = 0; j < n_c; j++ ) if (_centers.value[j] != 0.0) order.push_back(j);
+	_centers.n_point_centers = (int)order.size();
+	for (int j = 0; j < n_c; j++ ) if (_centers.value[j] == 0.0) order.push_back(j);
+	_permute(_centers.x, order);
+	_permute(_centers.y, order);
+	_permute(_centers.z, order);
+	_permute(_centers.c, order);
+	_permute(_centers.value, order);
+	_permute(_centers.dx, order);
+	_permute(_centers.dy, order);
+	_permute(_centers.dz, order);
+	_centers.weights.resize(n_c, _n_fields);
+	for (int j = 0; j < n_c; j++ )
+		for (int k = 0; k < _n_fields; k++ ) _centers.weights(j, k) = _center_weights[order[j]*_n_fields + k];
+	std::vector<double>().swap(_center_weights);
+}
+
+double Tiled_Evaluator::hessian_bound(const double &r_max) const
+{
+	double point_weights = 0.0;
+	double derivative_weights = 0.0;
+	for (int j = 0; j < n_centers(); j++ )
+	{
+		double w = _centers.weights.row(j).cwiseAbs().maxCoeff();
+		point_weights += w*fabs(_centers.value[j]);
+		derivative_weights += w*sqrt(_centers.dx[j]*_centers.dx[j] + _centers.dy[j]*_centers.dy[j] + _centers.dz[j]*_centers.dz[j]);
+	}
+	double bound = 0.0;
+	if (point_weights > 0.0) bound += _kernel->hessian_bound(0.0, r_max)*point_weights;
+	if (derivative_weights > 0.0) bound += _kernel->third_derivative_bound(0.0, r_max)*derivative_weights;
+	if (_p_basis != NULL)
+	{
+		// the polynomial is at most quadratic: its Hessian is constant, column d the change of the gradient along axis d
+		Polynomial_Basis *p_basis_j = _p_basis->clone();
+		MatrixXd gradient[4];
+		for (int d = 0; d < 4; d++ )
+		{
+			Evaluation_Point p(d == 0 ? 1.0 : 0.0, d == 1 ? 1.0 : 0.0, d == 2 ? 1.0 : 0.0);
+			p_basis_j->set_point(p);
+			gradient[d].resize(3, _n_fields);
+			gradient[d].row(0) = p_basis_j->dx().transpose()*_poly_weights;
+			gradient[d].row(1) = p_basis_j->dy().transpose()*_poly_weights;
+			gradient[d].row(2) = p_basis_j->dz().transpose()*_poly_weights;
+		}
+		delete p_basis_j;
+		double polynomial = 0.0;
+		for (int f = 0; f < _n_fields; f++ )
+		{
+			// Frobenius norm, at least the spectral norm
+			double sum = 0.0;
+			for (int d = 0; d < 3; d++ ) sum += (gradient[d].col(f) - gradient[3].col(f)).squaredNorm();
+			polynomial = std::max(polynomial, sqrt(sum));
+		}
+		bound += polynomial;
+	}
+	return bound;
+}
+
+void Tiled_Evaluator::accumulate(const Packed_Centers &centers, const int &begin, const int &end, const double *px, const double *py, const double *pz,
+	const double *pc, const int &nb, Workspace &workspace, MatrixXd &fields) const
+{
+	double *tile = &workspace.tile[0];
+	double *dphi = &workspace.dphi[0];
+	double *proj = &workspace.proj[0];
+	for (int j0 = begin; j0 < end; j0 += center_block)
+	{
+		int mb = std::min((int)center_block, end - j0);
+		if (j0 + mb <= centers.n_point_centers)
+		{
+			for (int j = 0; j < mb; j++ )
+			{
+				double xj = centers.x[j0 + j];
+				double yj = centers.y[j0 + j];
+				double zj = centers.z[j0 + j];
+				double cj = centers.c[j0 + j];
+				double *r2_col = &tile[j*nb];
+				for (int i = 0; i < nb; i++ )
+				{
+					double ddx = px[i] - xj;
+					double ddy = py[i] - yj;
+					double ddz = pz[i] - zj;
+					double ddc = pc[i] - cj;
+					r2_col[i] = ddx*ddx + ddy*ddy + ddz*ddz + ddc*ddc;
+				}
+			}
+			_kernel->radial_profile(nb*mb, tile, tile, dphi);
+		}
+		else
+		{
+			for (int j = 0; j < mb; j++ )
+			{
+				double xj = centers.x[j0 + j];
+				double yj = centers.y[j0 + j];
+				double zj = centers.z[j0 + j];
+				double cj = centers.c[j0 + j];
+				double dxj = centers.dx[j0 + j];
+				double dyj = centers.dy[j0 + j];
+				double dzj = centers.dz[j0 + j];
+				double *r2_col = &tile[j*nb];
+				double *proj_col = &proj[j*nb];
+				for (int i = 0; i < nb; i++ )
+				{
+					double ddx = px[i] - xj;
+					double ddy = py[i] - yj;
+					double ddz = pz[i] - zj;
+					double ddc = pc[i] - cj;
+					r2_col[i] = ddx*ddx + ddy*ddy + ddz*ddz + ddc*ddc;
+					proj_col[i] = ddx*dxj + ddy*dyj + ddz*dzj;
+				}
+			}
+			_kernel->radial_profile(nb*mb, tile, tile, dphi);
+			for (int j = 0; j < mb; j++ )
+			{
+				double value = centers.value[j0 + j];
+				double *k_col = &tile[j*nb];
+				const double *dphi_col = &dphi[j*nb];
+				const double *proj_col = &proj[j*nb];
+				for (int i = 0; i < nb; i++ ) k_col[i] = value*k_col[i] - dphi_col[i]*proj_col[i];
+			}
+		}
+		Map<MatrixXd> K(tile, nb, mb);
+		fields.topRows(nb).noalias() += K*centers.weights.middleRows(j0, mb);
+	}
+}
+
+void Tiled_Evaluator::accumulate_gradient(const Packed_Centers &centers, const int &begin, const int &end, const double *px, const double *py,
+	const double *pz, const double *pc, const int &nb, Workspace &workspace, MatrixXd &fields, MatrixXd *gradients) const
+{
+	int tile_size = point_block*center_block;
+	if ((int)workspace.ddphi.size() < tile_size)
+	{
+		workspace.ddphi.resize(tile_size);
+		workspace.gradient.resize(3*tile_size);
+	}
+	double *tile = &workspace.tile[0];
+	double *dphi = &workspace.dphi[0];
+	double *ddphi = &workspace.ddphi[0];
+	double *proj = &workspace.proj[0];
+	double *g[3] = { &workspace.gradient[0], &workspace.gradient[tile_size], &workspace.gradient[2*tile_size] };
+	for (int j0 = begin; j0 < end; j0 += center_block)
+	{
+		int mb = std::min((int)center_block, end - j0);
+		// differences p - center in the gradient tiles until the kernel profile is known
+		for (int j = 0; j < mb; j++ )
+		{
+			double xj = centers.x[j0 + j];
+			double yj = centers.y[j0 + j];
+			double zj = centers.z[j0 + j];
+			double cj = centers.c[j0 + j];
+			double dxj = centers.dx[j0 + j];
+			double dyj = centers.dy[j0 + j];
+			double dzj = centers.dz[j0 + j];
+			for (int i = 0; i < nb; i++ )
+			{
+				int k = j*nb + i;
+				double ddx = px[i] - xj;
+				double ddy = py[i] - yj;
+				double ddz = pz[i] - zj;
+				double ddc = pc[i] - cj;
+				tile[k] = ddx*ddx + ddy*ddy + ddz*ddz + ddc*ddc;
+				proj[k] = ddx*dxj + ddy*dyj + ddz*dzj;
+				g[0][k] = ddx;
+				g[1][k] = ddy;
+				g[2][k] = ddz;
+			}
+		}
+		_kernel->radial_profile(nb*mb, tile, tile, dphi, ddphi);
+		// value: value*phi - dphi*(delta . d), its gradient w.r.t. p: dphi*(value*delta - d) - (delta . d)*ddphi*delta
+		for (int j = 0; j < mb; j++ )
+		{
+			double value = centers.value[j0 + j];
+			double d[3] = { centers.dx[j0 + j], centers.dy[j0 + j], centers.dz[j0 + j] };
+			for (int i = 0; i < nb; i++ )
+			{
+				int k = j*nb + i;
+				tile[k] = value*tile[k] - dphi[k]*proj[k];
+				double projected = proj[k]*ddphi[k];
+				for (int a = 0; a < 3; a++ ) g[a][k] = dphi[k]*(value*g[a][k] - d[a]) - projected*g[a][k];
+			}
+		}
+		Map<MatrixXd> K(tile, nb, mb);
+		fields.topRows(nb).noalias() += K*centers.weights.middleRows(j0, mb);
+		for (int a = 0; a < 3; a++ )
+		{
+			Map<MatrixXd> G(g[a], nb, mb);
+			gradients[a].topRows(nb).noalias() += G*centers.weights.middleRows(j0, mb);
+		}
+	}
+}
+
+void Tiled_Evaluator::set_fields(std::vector<Evaluation_Point> &pts, const int *indices, const int &nb, MatrixXd &fields, MatrixXd *gradients) const
+{
+	Polynomial_Basis *p_basis_j = NULL;
+	if (_p_basis != NULL) p_basis_j = _p_basis->clone();
+	for (int i = 0; i < nb; i++ )
+	{
+		Evaluation_Point &p = pts[indices[i]];
+		if (p_basis_j != NULL)
+		{
+			p_basis_j->set_point(p);
+			VectorXd b = p_basis_j->basis();
+			fields.row(i) += b.transpose()*_poly_weights;
+			if (gradients != NULL)
+			{
+				gradients[0].row(i) += p_basis_j->dx().transpose()*_poly_weights;
+				gradients[1].row(i) += p_basis_j->dy().transpose()*_poly_weights;
+				gradients[2].row(i) += p_basis_j->dz().transpose()*_poly_weights;
+			}
+		}
+		if (gradients != NULL) p.set_vector_field(gradients[0](i, 0), gradients[1](i, 0), gradients[2](i, 0));
+		if (_n_fields > 1)
+		{
+			std::vector<double> values(_n_fields);
+			for (int k = 0; k < _n_fields; k++ ) values[k] = fields(i, k);
+			p.set_scalar_fields(values);
+		}
+		p.set_scalar_field(fields(i, 0));
+	}
+	if (p_basis_j != NULL) delete p_basis_j;
+}
+
+void Tiled_Evaluator::evaluate(std::vector<Evaluation_Point> &pts, const int &begin, const int &end, const bool &gradient) const
+{
+	Workspace workspace;
+	double px[point_block];
+	double py[point_block];
+	double pz[point_block];
+	double pc[point_block];
+	int indices[point_block];
+	MatrixXd fields(point_block, _n_fields);
+	MatrixXd gradients[3];
+	for (int d = 0; d < 3 && gradient; d++ ) gradients[d].resize(point_block, _n_fields);
+
+	for (int i0 = begin; i0 < end; i0 += point_block)
+	{
+		int nb = std::min((int)point_block, end - i0);
+		for (int i = 0; i < nb; i++ )
+		{
+			indices[i] = i0 + i;
+			px[i] = pts[i0 + i].x();
+			py[i] = pts[i0 + i].y();
+			pz[i] = pts[i0 + i].z();
+			pc[i] = pts[i0 + i].c();
+		}
+		fields.setZero();
+		if (gradient)
+		{
+			for (int d = 0; d < 3; d++ ) gradients[d].setZero();
+			accumulate_gradient(_centers, 0, n_centers(), px, py, pz, pc, nb, workspace, fields, gradients);
+			set_fields(pts, indices, nb, fields, gradients);
+		}
+		else
+		{
+			accumulate(_centers, 0, n_centers(), px, py, pz, pc, nb, workspace, fields);
+			set_fields(pts, indices, nb, fields);
+		}
+	}
+}
+
+void Tiled_Evaluator::evaluate_points(const double *xyz, const int &begin, const int &end, double *out) const
+{
+	Workspace workspace;
+	double px[point_block];
+	double py[point_block];
+	double pz[point_block];
+	double pc[point_block];
+	MatrixXd fields(point_block, _n_fields);
+	for (int i = 0; i < point_block; i++ ) pc[i] = 0.0;
+	Polynomial_Basis *p_basis_j = NULL;
+	if (_p_basis != NULL) p_basis_j = _p_basis->clone();
+
+	for (int i0 = begin; i0 < end; i0 += point_block)
+	{
+		int nb = std::min((int)point_block, end - i0);
+		for (int i = 0; i < nb; i++ )
+		{
+			px[i] = xyz[3*(i0 + i)];
+			py[i] = xyz[3*(i0 + i) + 1];
+			pz[i] = xyz[3*(i0 + i) + 2];
+		}
+		fields.setZero();
+		accumulate(_centers, 0, n_centers(), px, py, pz, pc, nb, workspace, fields);
+		for (int i = 0; i < nb; i++ )
+		{
+			if (p_basis_j != NULL)
+			{
+				Point p(px[i], py[i], pz[i]);
+				p_basis_j->set_point(p);
+				fields.row(i) += p_basis_j->basis().transpose()*_poly_weights;
+			}
+			for (int f = 0; f < _n_fields; f++ ) out[(size_t)(i0 + i)*_n_fields + f] = fields(i, f);
+		}
+	}
+	if (p_basis_j != NULL) delete p_basis_j;
+}
+
+template <typename T>
+void Tiled_Evaluator::_evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes,
+	const long long &begin, const long long &end, T *out, T *gradients) const
+{
+	Workspace workspace;
+	double px[point_block];
+	double py[point_block];
+	double pz[point_block];
+	double pc[point_block];
+	long long node[point_block];
+	MatrixXd fields(point_block, _n_fields);
+	MatrixXd field_gradients[3];
+	for (int d = 0; d < 3; d++ ) field_gradients[d].resize(point_block, _n_fields);
+	for (int i = 0; i < point_block; i++ ) pc[i] = 0.0;
+
+	// the polynomial and its derivatives along a row of nodes (fixed j, k) are at most quadratic in i: a + i*(b + i*c),
+	// from three evaluations per row instead of one per node. Rows: value, d/dx, d/dy, d/dz
+	Polynomial_Basis *p_basis_j = NULL;
+	if (_p_basis != NULL) p_basis_j = _p_basis->clone();
+	int n_terms = (gradients != NULL) ? 4 : 1;
+	MatrixXd a = MatrixXd::Zero(n_terms, _n_fields);
+	MatrixXd b = MatrixXd::Zero(n_terms, _n_fields);
+	MatrixXd c = MatrixXd::Zero(n_terms, _n_fields);
+	long long row = -1;
+
+	for (long long n0 = begin; n0 < end; n0 += point_block)
+	{
+		int nb = (int)std::min((long long)point_block, end - n0);
+		for (int i = 0; i < nb; i++ )
+		{
+			long long n = (nodes != NULL) ? nodes[n0 + i] : n0 + i;
+			node[i] = n;
+			px[i] = origin[0] + (double)(n % dims[0])*spacing[0];
+			py[i] = origin[1] + (double)((n / dims[0]) % dims[1])*spacing[1];
+			pz[i] = origin[2] + (double)(n / ((long long)dims[0]*dims[1]))*spacing[2];
+		}
+		fields.setZero();
+		if (gradients != NULL)
+		{
+			for (int d = 0; d < 3; d++ ) field_gradients[d].setZero();
+			accumulate_gradient(_centers, 0, _centers.size(), px, py, pz, pc, nb, workspace, fields, field_gradients);
+		}
+		else accumulate(_centers, 0, _centers.size(), px, py, pz, pc, nb, workspace, fields);
+		for (int i = 0; i < nb; i++ )
+		{
+			long long n = node[i];
+			int t = (int)(n % dims[0]);
+			if (p_basis_j != NULL && n / dims[0] != row)
+			{
+				row = n / dims[0];
+				MatrixXd v[3];
+				for (int s = 0; s < 3; s++ )
+				{
+					Point q(origin[0] + s*spacing[0], py[i], pz[i]);
+					p_basis_j->set_point(q);
+					v[s].resize(n_terms, _n_fields);
+					v[s].row(0) = p_basis_j->basis().transpose()*_poly_weights;
+					if (gradients != NULL)
+					{
+						v[s].row(1) = p_basis_j->dx().transpose()*_poly_weights;
+						v[s].row(2) = p_basis_j->dy().transpose()*_poly_weights;
+						v[s].row(3) = p_basis_j->dz().transpose()*_poly_weights;
+					}
+				}
+				c = 0.5*(v[2] - 2.0*v[1] + v[0]);
+				b = v[1] - v[0] - c;
+				a = v[0];
+			}
+			for (int f = 0; f < _n_fields; f++ )
+			{
+				out[(size_t)n*_n_fields + f] = (T)(fields(i, f) + a(0, f) + t*(b(0, f) + t*c(0, f)));
+				if (gradients != NULL)
+					for (int d = 0; d < 3; d++ )
+						gradients[((size_t)n*_n_fields + f)*3 + d] = (T)(field_gradients[d](i, f) + a(d + 1, f) + t*(b(d + 1, f) + t*c(d + 1, f)));
+			}
+		}
+	}
+	if (p_basis_j != NULL) delete p_basis_j;
+}
+
+void Tiled_Evaluator::evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes, const long long &begin,
+	const long long &end, double *out, double *gradients) const
+{
+	_evaluate_grid(origin, spacing, dims, nodes, begin, end, out, gradients);
+}
+
+void Tiled_Evaluator::evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes, const long long &begin,
+	const long long &end, float *out, float *gradients) const
+{
+	_evaluate_grid(origin, spacing, dims, nodes, begin, end, out, gradients);
+}
@@ -0,0 +1,143 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef tiled_evaluation_h
+#define tiled_evaluation_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <modelling_input.h>
+#include <basis.h>
+
+#include <vector>
+#include <Eigen/Core>
+
+using namespace Eigen;
+
+// Centers packed as structure of arrays. Every center is a point evaluation (value = 1) and/or a directional
+// derivative along (dx, dy, dz) of the kernel w.r.t. its second argument, with one weight per scalar field
+struct SURFE_LIB_EXPORT Packed_Centers {
+	std::vector<double> x;
+	std::vector<double> y;
+	std::vector<double> z;
+	std::vector<double> c;
+	std::vector<double> value;
+	std::vector<double> dx;
+	std::vector<double> dy;
+	std::vector<double> dz;
+	MatrixXd weights; // n centers x n fields
+	int n_point_centers; // the first n_point_centers centers are plain point evaluations
+	Packed_Centers() : n_point_centers(0) {}
+	int size() const { return (int)x.size(); }
+};
+
+// Scalar interpolant evaluation in tiles: the centers of a solved interpolant are packed once as structure of arrays,
+// then a block of evaluation points x a block of centers forms a kernel matrix small enough to stay in cache and is
+// multiplied against the matching rows of the weights (one column per scalar field). Interface, increment pair
+// (two point centers), planar (three derivative centers) and tangent constraints are all covered.
+// Only isotropic kernels with a radial profile (RBFKernel::radial_profile) are supported.
+class SURFE_LIB_EXPORT Tiled_Evaluator {
+private:
+	RBFKernel *_kernel;
+	Polynomial_Basis *_p_basis;
+	int _n_fields;
+	Packed_Centers _centers;
+	std::vector<double> _center_weights; // _n_fields per center, until pack()
+	MatrixXd _poly_weights; // n poly terms x _n_fields
+	void _add_center(const Point &p, const double &value, const double &dx, const double &dy, const double &dz, const double *w);
+	template <typename T> void _evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes,
+		const long long &begin, const long long &end, T *out, T *gradients) const;
+public:
+	// tile sizes: # of evaluation points and # of centers of a kernel matrix
+	static const int point_block = 64;
+	static const int center_block = 128;
+	// tile buffers of one thread
+	struct Workspace {
+		std::vector<double> tile;
+		std::vector<double> dphi;
+		std::vector<double> proj;
+		std::vector<double> ddphi; // gradient evaluation only, sized on first use
+		std::vector<double> gradient;
+		Workspace() : tile(point_block*center_block), dphi(point_block*center_block), proj(point_block*center_block) {}
+	};
+	Tiled_Evaluator(RBFKernel *kernel, const int &n_fields = 1);
+	~Tiled_Evaluator();
+	// false if the kernel has no radial profile
+	bool supported() const;
+	// w: _n_fields weights
+	void add_point_center(const Point &p, const double *w);
+	void add_point_center(const Point &p, const double &w) { add_point_center(p, &w); }
+	// derivative along (dx, dy, dz) w.r.t. the kernel's second argument
+	void add_derivative_center(const Point &p, const double &dx, const double &dy, const double &dz, const double *w);
+	void add_derivative_center(const Point &p, const double &dx, const double &dy, const double &dz, const double &w) { add_derivative_center(p, dx, dy, dz, &w); }
+	// poly_weights: n poly terms x _n_fields
+	void set_polynomial(Polynomial_Basis *p_basis, const MatrixXd &poly_weights);
+	// after the last center is added
+	void pack();
+	int n_centers() const { return _centers.size(); }
+	int n_fields() const { return _n_fields; }
+	const Packed_Centers &centers() const { return _centers; }
+	const RBFKernel *kernel() const { return _kernel; }
+	// bound on the spectral norm of the Hessian of every scalar field at points within r_max of all the centers:
+	// the kernel's second (point centers) and third (derivative centers) derivative bounds times the weights, plus the
+	// polynomial's. Infinity if the kernel has no such bounds
+	double hessian_bound(const double &r_max) const;
+	// adds the sum of centers [begin, end) at nb (<= point_block) points to the first nb rows of fields
+	void accumulate(const Packed_Centers &centers, const int &begin, const int &end, const double *px, const double *py, const double *pz,
+		const double *pc, const int &nb, Workspace &workspace, MatrixXd &fields) const;
+	// accumulate, plus the gradients of the sums w.r.t. the evaluation point (gradients[0, 1, 2]: d/dx, d/dy, d/dz)
+	void accumulate_gradient(const Packed_Centers &centers, const int &begin, const int &end, const double *px, const double *py, const double *pz,
+		const double *pc, const int &nb, Workspace &workspace, MatrixXd &fields, MatrixXd *gradients) const;
+	// adds the polynomial to the kernel sums (rows of fields) and sets the scalar field(s) of pts[indices[i]], i < nb.
+	// With gradients, also their polynomial part and the vector field (gradient of the first field)
+	void set_fields(std::vector<Evaluation_Point> &pts, const int *indices, const int &nb, MatrixXd &fields, MatrixXd *gradients = NULL) const;
+	// scalar field(s) of the points [begin, end) of xyz (x, y, z per point) written to out[point*n_fields + field]. Thread safe
+	void evaluate_points(const double *xyz, const int &begin, const int &end, double *out) const;
+	// one evaluator for several solved interpolants with the same kernel (caller deletes): their fields side by side in
+	// order, centers at the same place, of the same type and direction packed once with a weight for every field.
+	// NULL if the kernels differ
+	static Tiled_Evaluator *merge(const std::vector<const Tiled_Evaluator *> &evaluators);
+	// scalar field(s) of the points [begin, end), and the vector field in the same pass if gradient.
+	// Thread safe, a call works on its own tiles
+	void evaluate(std::vector<Evaluation_Point> &pts, const int &begin, const int &end, const bool &gradient = false) const;
+	// scalar field(s) of the nodes nodes[begin, end) (nodes begin to end - 1 if nodes is NULL) of the regular grid
+	// origin + (i, j, k)*spacing, node index i + dims[0]*(j + dims[1]*k), written to out[node*n_fields + field].
+	// If gradients is not NULL, the gradient of each field is written to gradients[(node*n_fields + field)*3 + axis] in the
+	// same sweep over the centers. Thread safe. Nodes sorted by index share the polynomial set up of their row
+	void evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes, const long long &begin,
+		const long long &end, double *out, double *gradients = NULL) const;
+	void evaluate_grid(const double *origin, const double *spacing, const int *dims, const long long *nodes, const long long &begin,
+		const long long &end, float *out, float *gradients = NULL) const;
+};
+
+#endif
@@ -0,0 +1,585 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#include <treecode.h>
+
+#include <algorithm>
+#include <cmath>
+
+// Lagrange polynomials of the nodes s and their derivatives at x (product form, no division by x - s)
+static void _lagrange_1d(const std::vector<double> &s, const double &x, double *L, double *dL)
+{
+	int n = (int)s.size();
+	for (int a = 0; a < n; a++ )
+	{
+		double l = 1.0;
+		double d = 0.0;
+		for (int m = 0; m < n; m++ )
+		{
+			if (m == a) continue;
+			double f = 1.0 / (s[a] - s[m]);
+			d = (d*(x - s[m]) + l)*f;
+			l = l*(x - s[m])*f;
+		}
+		L[a] = l;
+		dL[a] = d;
+	}
+}
+
+// Chebyshev points of the second kind of [center - half_width, center + half_width]
+static void _chebyshev_points(const double &center, const double &half_width, const int &degree, std::vector<double> &s)
+{
+	const double pi = 3.14159265358979323846;
+	s.resize(degree + 1);
+	for (int i = 0; i <= degree; i++ ) s[i] = center + half_width*cos((pi*i) / degree);
+}
+
+// flat boxes (e.g. map data or a grid slice) still need a width to interpolate across
+static void _pad_box(double half_width[3])
+{
+	double max_half_width = std::max(half_width[0], std::max(half_width[1], half_width[2]));
+	for (int d = 0; d < 3; d++ ) half_width[d] = std::max(half_width[d], 1e-3*max_half_width);
+}
+
+Treecode_Evaluator::Treecode_Evaluator(const Tiled_Evaluator &evaluator, const double &theta, const int &leaf_size, const int &box_size)
+{
+	_evaluator = &evaluator;
+	_theta = theta;
+	_leaf_size = leaf_size;
+	_box_size = box_size;
+	_degree = 0;
+	_error_estimate = 0.0;
+	_build_tree(evaluator.centers());
+}
+
+bool Treecode_Evaluator::supported() const
+{
+	for (int j = 0; j < _centers.size(); j++ ) if (_centers.c[j] != 0.0) return false;
+	return true;
+}
+
+void Treecode_Evaluator::_build_tree(const Packed_Centers &centers)
+{
+	int n = centers.size();
+	std::vector<int> order(n);
+	for (int j = 0; j < n; j++ ) order[j] = j;
+
+	_clusters.clear();
+	Cluster root;
+	root.begin = 0;
+	root.end = n;
+	_clusters.push_back(root);
+	// breadth first, the children of a cluster are appended together
+	for (int k = 0; k < (int)_clusters.size(); k++ )
+	{
+		int begin = _clusters[k].begin;
+		int end = _clusters[k].end;
+		double lower[3] = { 0.0, 0.0, 0.0 };
+		double upper[3] = { 0.0, 0.0, 0.0 };
+		for (int j = begin; j < end; j++ )
+		{
+			double p[3] = { centers.x[order[j]], centers.y[order[j]], centers.z[order[j]] };
+			for (int d = 0; d < 3; d++ )
+			{
+				if (j == begin || p[d] < lower[d]) lower[d] = p[d];
+				if (j == begin || p[d] > upper[d]) upper[d] = p[d];
+			}
+		}
+		double max_half_width = 0.0;
+		for (int d = 0; d < 3; d++ )
+		{
+			_clusters[k].center[d] = 0.5*(lower[d] + upper[d]);
+			_clusters[k].half_width[d] = 0.5*(upper[d] - lower[d]);
+			max_half_width = std::max(max_half_width, _clusters[k].half_width[d]);
+		}
+		_pad_box(_clusters[k].half_width);
+		Cluster &cl = _clusters[k];
+		cl.radius = sqrt(cl.half_width[0]*cl.half_width[0] + cl.half_width[1]*cl.half_width[1] + cl.half_width[2]*cl.half_width[2]);
+		cl.first_child = -1;
+		cl.n_children = 0;
+		cl.proxy_begin = -1;
+		if (end - begin <= _leaf_size || max_half_width == 0.0) continue;
+
+		// octants of the box center
+		std::vector<int> octant_size(8, 0);
+		std::vector<int> octant(end - begin);
+		for (int j = begin; j < end; j++ )
+		{
+			int o = 0;
+			if (centers.x[order[j]] > cl.center[0]) o += 1;
+			if (centers.y[order[j]] > cl.center[1]) o += 2;
+			if (centers.z[order[j]] > cl.center[2]) o += 4;
+			octant[j - begin] = o;
+			octant_size[o]++;
+		}
+		std::vector<int> octant_begin(8, begin);
+		for (int o = 1; o < 8; o++ ) octant_begin[o] = octant_begin[o - 1] + octant_size[o - 1];
+		std::vector<int> sorted(end - begin);
+		std::vector<int> position(octant_begin);
+		for (int j = begin; j < end; j++ ) sorted[position[octant[j - begin]]++ - begin] = order[j];
+		std::copy(sorted.begin(), sorted.end(), order.begin() + begin);
+
+		int first_child = (int)_clusters.size();
+		int n_children = 0;
+		for (int o = 0; o < 8; o++ )
+		{
+			if (octant_size[o] == 0) continue;
+			Cluster child;
+			child.begin = octant_begin[o];
+			child.end = octant_begin[o] + octant_size[o];
+			_clusters.push_back(child);
+			n_children++;
+		}
+		_clusters[k].first_child = first_child;
+		_clusters[k].n_children = n_children;
+	}
+
+	// centers in tree order
+	_centers = Packed_Centers();
+	_centers.weights.resize(n, centers.weights.cols());
+	for (int j = 0; j < n; j++ )
+	{
+		int k = order[j];
+		_centers.x.push_back(centers.x[k]);
+		_centers.y.push_back(centers.y[k]);
+		_centers.z.push_back(centers.z[k]);
+		_centers.c.push_back(centers.c[k]);
+		_centers.value.push_back(centers.value[k]);
+		_centers.dx.push_back(centers.dx[k]);
+		_centers.dy.push_back(centers.dy[k]);
+		_centers.dz.push_back(centers.dz[k]);
+		_centers.weights.row(j) = centers.weights.row(k);
+	}
+}
+
+void Treecode_Evaluator::_compute_proxies(const int &degree)
+{
+	int n_1d = degree + 1;
+	int n_proxies = n_1d*n_1d*n_1d;
+	int n_fields = (int)_centers.weights.cols();
+
+	std::vector<int> approximated;
+	for (int k = 0; k < (int)_clusters.size(); k++ )
+	{
+		_clusters[k].proxy_begin = -1;
+		// only clusters with more centers than proxies, and a box
+		if (_clusters[k].end - _clusters[k].begin > n_proxies && _clusters[k].radius > 0.0)
+		{
+			_clusters[k].proxy_begin = (int)approximated.size()*n_proxies;
+			approximated.push_back(k);
+		}
+	}
+
+	int n_total = (int)approximated.size()*n_proxies;
+	_proxies = Packed_Centers();
+	_proxies.x.resize(n_total);
+	_proxies.y.resize(n_total);
+	_proxies.z.resize(n_total);
+	_proxies.c.assign(n_total, 0.0);
+	_proxies.value.assign(n_total, 1.0);
+	_proxies.dx.assign(n_total, 0.0);
+	_proxies.dy.assign(n_total, 0.0);
+	_proxies.dz.assign(n_total, 0.0);
+	_proxies.weights = MatrixXd::Zero(n_total, n_fields);
+	_proxies.n_point_centers = n_total;
+
+	#pragma omp parallel for schedule(dynamic)
+	for (int a = 0; a < (int)approximated.size(); a++ )
+	{
+		const Cluster &cl = _clusters[approximated[a]];
+		std::vector< std::vector<double> > s(3);
+		for (int d = 0; d < 3; d++ ) _chebyshev_points(cl.center[d], cl.half_width[d], degree, s[d]);
+		for (int i = 0; i < n_1d; i++ )
+			for (int j = 0; j < n_1d; j++ )
+				for (int k = 0; k < n_1d; k++ )
+				{
+					int p = cl.proxy_begin + (i*n_1d + j)*n_1d + k;
+					_proxies.x[p] = s[0][i];
+					_proxies.y[p] = s[1][j];
+					_proxies.z[p] = s[2][k];
+				}
+		// charges: the functionals of the centers applied to the Lagrange polynomials of the proxies
+		std::vector<double> Lx(n_1d), Ly(n_1d), Lz(n_1d), dLx(n_1d), dLy(n_1d), dLz(n_1d);
+		for (int c = cl.begin; c < cl.end; c++ )
+		{
+			_lagrange_1d(s[0], _centers.x[c], &Lx[0], &dLx[0]);
+			_lagrange_1d(s[1], _centers.y[c], &Ly[0], &dLy[0]);
+			_lagrange_1d(s[2], _centers.z[c], &Lz[0], &dLz[0]);
+			double value = _centers.value[c];
+			double dx = _centers.dx[c];
+			double dy = _centers.dy[c];
+			double dz = _centers.dz[c];
+			for (int i = 0; i < n_1d; i++ )
+				for (int j = 0; j < n_1d; j++ )
+				{
+					double xy = Lx[i]*Ly[j];
+					double a_xy = value*xy + dx*dLx[i]*Ly[j] + dy*Lx[i]*dLy[j]; // times Lz
+					double a_z = dz*xy; // times dLz
+					for (int k = 0; k < n_1d; k++ )
+					{
+						double q = a_xy*Lz[k] + a_z*dLz[k];
+						int p = cl.proxy_begin + (i*n_1d + j)*n_1d + k;
+						for (int f = 0; f < n_fields; f++ ) _proxies.weights(p, f) += q*_centers.weights(c, f);
+					}
+				}
+		}
+	}
+	_degree = degree;
+}
+
+void Treecode_Evaluator::_bisect(const std::vector<Evaluation_Point> &pts, int *indices, const int &n, int &axis) const
+{
+	// median of the longest side of the box of the points, the first half of indices below it
+	double lower[3] = { pts[indices[0]].x(), pts[indices[0]].y(), pts[indices[0]].z() };
+	double upper[3] = { lower[0], lower[1], lower[2] };
+	for (int j = 1; j < n; j++ )
+	{
+		double p[3] = { pts[indices[j]].x(), pts[indices[j]].y(), pts[indices[j]].z() };
+		for (int d = 0; d < 3; d++ )
+		{
+			lower[d] = std::min(lower[d], p[d]);
+			upper[d] = std::max(upper[d], p[d]);
+		}
+	}
+	axis = 0;
+	for (int d = 1; d < 3; d++ ) if (upper[d] - lower[d] > upper[axis] - lower[axis]) axis = d;
+	std::vector< std::pair<double, int> > keyed(n);
+	for (int j = 0; j < n; j++ )
+	{
+		const Evaluation_Point &p = pts[indices[j]];
+		keyed[j] = std::make_pair((axis == 0) ? p.x() : ((axis == 1) ? p.y() : p.z()), indices[j]);
+	}
+	std::nth_element(keyed.begin(), keyed.begin() + n / 2, keyed.end());
+	for (int j = 0; j < n; j++ ) indices[j] = keyed[j].second;
+}
+
+void Treecode_Evaluator::_evaluate_direct(std::vector<Evaluation_Point> &pts, const int *indices, const int &nb, Tiled_Evaluator::Workspace &workspace) const
+{
+	double px[Tiled_Evaluator::point_block];
+	double py[Tiled_Evaluator::point_block];
+	double pz[Tiled_Evaluator::point_block];
+	double pc[Tiled_Evaluator::point_block];
+	for (int i = 0; i < nb; i++ )
+	{
+		px[i] = pts[indices[i]].x();
+		py[i] = pts[indices[i]].y();
+		pz[i] = pts[indices[i]].z();
+		pc[i] = pts[indices[i]].c();
+	}
+	MatrixXd fields = MatrixXd::Zero(Tiled_Evaluator::point_block, _evaluator->n_fields());
+	_evaluator->accumulate(_centers, 0, _centers.size(), px, py, pz, pc, nb, workspace, fields);
+	_evaluator->set_fields(pts, indices, nb, fields);
+}
+
+// values on the tensor grid of nodes s_out (per dimension) of the tensor interpolant on the grid of nodes s_in
+static void _interpolate_tensor(const std::vector< std::vector<double> > &s_in, const std::vector< std::vector<double> > &s_out,
+	const MatrixXd &values, MatrixXd &interpolated)
+{
+	int n = (int)s_in[0].size();
+	std::vector<MatrixXd> A(3, MatrixXd(n, n)); // A[d](a, i): Lagrange polynomial i at output node a
+	std::vector<double> L(n);
+	std::vector<double> dL(n);
+	for (int d = 0; d < 3; d++ )
+		for (int a = 0; a < n; a++ )
+		{
+			_lagrange_1d(s_in[d], s_out[d][a], &L[0], &dL[0]);
+			for (int i = 0; i < n; i++ ) A[d](a, i) = L[i];
+		}
+	int n_fields = (int)values.cols();
+	MatrixXd t1(n*n*n, n_fields);
+	MatrixXd t2(n*n*n, n_fields);
+	interpolated.resize(n*n*n, n_fields);
+	// one dimension at a time, index (i*n + j)*n + k
+	t1.setZero();
+	for (int i = 0; i < n; i++ )
+		for (int j = 0; j < n; j++ )
+			for (int c = 0; c < n; c++ )
+				for (int k = 0; k < n; k++ ) t1.row((i*n + j)*n + c) += A[2](c, k)*values.row((i*n + j)*n + k);
+	t2.setZero();
+	for (int i = 0; i < n; i++ )
+		for (int b = 0; b < n; b++ )
+			for (int j = 0; j < n; j++ )
+				for (int c = 0; c < n; c++ ) t2.row((i*n + b)*n + c) += A[1](b, j)*t1.row((i*n + j)*n + c);
+	interpolated.setZero();
+	for (int a = 0; a < n; a++ )
+		for (int i = 0; i < n; i++ )
+			for (int b = 0; b < n; b++ )
+				for (int c = 0; c < n; c++ ) interpolated.row((a*n + b)*n + c) += A[0](a, i)*t2.row((i*n + b)*n + c);
+}
+
+void Treecode_Evaluator::_evaluate_node(std::vector<Evaluation_Point> &pts, int *indices, const int &n, const Target_Node *parent,
+	const std::vector<int> &pending, Tiled_Evaluator::Workspace &workspace) const
+{
+	int n_fields = _evaluator->n_fields();
+	int n_1d = _degree + 1;
+	int n_interpolation = n_1d*n_1d*n_1d;
+
+	Target_Node node;
+	double lower[3];
+	double upper[3];
+	for (int i = 0; i < n; i++ )
+	{
+		double q[3] = { pts[indices[i]].x(), pts[indices[i]].y(), pts[indices[i]].z() };
+		for (int d = 0; d < 3; d++ )
+		{
+			if (i == 0 || q[d] < lower[d]) lower[d] = q[d];
+			if (i == 0 || q[d] > upper[d]) upper[d] = q[d];
+		}
+	}
+	for (int d = 0; d < 3; d++ )
+	{
+		node.center[d] = 0.5*(lower[d] + upper[d]);
+		node.half_width[d] = 0.5*(upper[d] - lower[d]);
+	}
+	node.radius = sqrt(node.half_width[0]*node.half_width[0] + node.half_width[1]*node.half_width[1] + node.half_width[2]*node.half_width[2]);
+	_pad_box(node.half_width);
+	std::vector< std::vector<double> > s_parent(3);
+	if (parent != NULL)
+		for (int d = 0; d < 3; d++ ) _chebyshev_points(parent->center[d], parent->half_width[d], _degree, s_parent[d]);
+
+	if (n <= Tiled_Evaluator::point_block)
+	{
+		// batch: far field interpolated from the parent, then the pending clusters through their proxies or directly
+		double px[Tiled_Evaluator::point_block];
+		double py[Tiled_Evaluator::point_block];
+		double pz[Tiled_Evaluator::point_block];
+		double pc[Tiled_Evaluator::point_block];
+		for (int i = 0; i < n; i++ )
+		{
+			px[i] = pts[indices[i]].x();
+			py[i] = pts[indices[i]].y();
+			pz[i] = pts[indices[i]].z();
+			pc[i] = pts[indices[i]].c();
+		}
+		MatrixXd fields = MatrixXd::Zero(Tiled_Evaluator::point_block, n_fields);
+		if (parent != NULL && parent->has_far_field)
+		{
+			std::vector<double> Lx(n_1d), Ly(n_1d), Lz(n_1d), dL(n_1d);
+			VectorXd l(n_interpolation);
+			for (int i = 0; i < n; i++ )
+			{
+				_lagrange_1d(s_parent[0], px[i], &Lx[0], &dL[0]);
+				_lagrange_1d(s_parent[1], py[i], &Ly[0], &dL[0]);
+				_lagrange_1d(s_parent[2], pz[i], &Lz[0], &dL[0]);
+				for (int a = 0; a < n_1d; a++ )
+					for (int b = 0; b < n_1d; b++ )
+						for (int c = 0; c < n_1d; c++ ) l((a*n_1d + b)*n_1d + c) = Lx[a]*Ly[b]*Lz[c];
+				fields.row(i) += l.transpose()*parent->far_field;
+			}
+		}
+		std::vector<int> stack(pending);
+		while (!stack.empty())
+		{
+			const Cluster &cl = _clusters[stack.back()];
+			stack.pop_back();
+			if (cl.proxy_begin >= 0)
+			{
+				double dx = cl.center[0] - node.center[0];
+				double dy = cl.center[1] - node.center[1];
+				double dz = cl.center[2] - node.center[2];
+				if (node.radius + cl.radius < _theta*sqrt(dx*dx + dy*dy + dz*dz))
+				{
+					_evaluator->accumulate(_proxies, cl.proxy_begin, cl.proxy_begin + n_interpolation, px, py, pz, pc, n, workspace, fields);
+					continue;
+				}
+				if (cl.first_child >= 0)
+				{
+					for (int k = 0; k < cl.n_children; k++ ) stack.push_back(cl.first_child + k);
+					continue;
+				}
+			}
+			_evaluator->accumulate(_centers, cl.begin, cl.end, px, py, pz, pc, n, workspace, fields);
+		}
+		_evaluator->set_fields(pts, indices, n, fields);
+		return;
+	}
+
+	// far field of the node: inherited from the parent, plus the pending clusters far from the whole node.
+	// Interpolating costs n_interpolation per point, not worth it for nodes with few points
+	std::vector< std::vector<double> > s(3);
+	for (int d = 0; d < 3; d++ ) _chebyshev_points(node.center[d], node.half_width[d], _degree, s[d]);
+	node.has_far_field = false;
+	if (parent != NULL && parent->has_far_field)
+	{
+		_interpolate_tensor(s_parent, s, parent->far_field, node.far_field);
+		node.has_far_field = true;
+	}
+	bool interpolate = (n > 2*n_interpolation && node.radius > 0.0);
+	std::vector< std::pair<int, int> > far_proxies;
+	std::vector< std::pair<int, int> > far_centers;
+	std::vector<int> next;
+	std::vector<int> stack(pending);
+	while (!stack.empty())
+	{
+		int k = stack.back();
+		const Cluster &cl = _clusters[k];
+		stack.pop_back();
+		double dx = cl.center[0] - node.center[0];
+		double dy = cl.center[1] - node.center[1];
+		double dz = cl.center[2] - node.center[2];
+		if (interpolate && node.radius + cl.radius < _theta*sqrt(dx*dx + dy*dy + dz*dz))
+		{
+			if (cl.proxy_begin >= 0) far_proxies.push_back(std::make_pair(cl.proxy_begin, cl.proxy_begin + n_interpolation));
+			else far_centers.push_back(std::make_pair(cl.begin, cl.end));
+		}
+		else if (cl.radius > node.radius && cl.first_child >= 0) for (int c = 0; c < cl.n_children; c++ ) stack.push_back(cl.first_child + c);
+		else next.push_back(k);
+	}
+	if (!far_proxies.empty() || !far_centers.empty())
+	{
+		if (!node.has_far_field) node.far_field = MatrixXd::Zero(n_interpolation, n_fields);
+		node.has_far_field = true;
+		double px[Tiled_Evaluator::point_block];
+		double py[Tiled_Evaluator::point_block];
+		double pz[Tiled_Evaluator::point_block];
+		double pc[Tiled_Evaluator::point_block];
+		MatrixXd fields(Tiled_Evaluator::point_block, n_fields);
+		for (int i0 = 0; i0 < n_interpolation; i0 += Tiled_Evaluator::point_block)
+		{
+			int nb = std::min((int)Tiled_Evaluator::point_block, n_interpolation - i0);
+			for (int i = 0; i < nb; i++ )
+			{
+				int p = i0 + i;
+				px[i] = s[0][p / (n_1d*n_1d)];
+				py[i] = s[1][(p / n_1d) % n_1d];
+				pz[i] = s[2][p % n_1d];
+				pc[i] = 0.0;
+			}
+			fields.setZero();
+			for (int f = 0; f < (int)far_proxies.size(); f++ )
+				_evaluator->accumulate(_proxies, far_proxies[f].first, far_proxies[f].second, px, py, pz, pc, nb, workspace, fields);
+			for (int f = 0; f < (int)far_centers.size(); f++ )
+				_evaluator->accumulate(_centers, far_centers[f].first, far_centers[f].second, px, py, pz, pc, nb, workspace, fields);
+			node.far_field.middleRows(i0, nb) += fields.topRows(nb);
+		}
+	}
+
+	int axis = 0;
+	_bisect(pts, indices, n, axis);
+	_evaluate_node(pts, indices, n / 2, node.has_far_field ? &node : NULL, next, workspace);
+	_evaluate_node(pts, indices + n / 2, n - n / 2, node.has_far_field ? &node : NULL, next, workspace);
+}
+
+// field f of a point with n_fields scalar fields
+static double _field(const Evaluation_Point &p, const int &f, const int &n_fields)
+{
+	if (n_fields > 1) return p.scalar_field(f);
+	return p.scalar_field();
+}
+
+bool Treecode_Evaluator::evaluate(std::vector<Evaluation_Point> &pts, const double &tolerance, const int &max_degree)
+{
+	// boxes of evaluation points, each one the root of a tree of evaluation points
+	int n = (int)pts.size();
+	std::vector<int> order(n);
+	for (int j = 0; j < n; j++ ) order[j] = j;
+	std::vector<int> box_begin;
+	std::vector< std::pair<int, int> > segments;
+	if (n > 0) segments.push_back(std::make_pair(0, n));
+	while (!segments.empty())
+	{
+		int b = segments.back().first;
+		int e = segments.back().second;
+		segments.pop_back();
+		if (e - b <= _box_size)
+		{
+			box_begin.push_back(b);
+			continue;
+		}
+		int axis = 0;
+		_bisect(pts, &order[b], e - b, axis);
+		segments.push_back(std::make_pair(b, b + (e - b) / 2));
+		segments.push_back(std::make_pair(b + (e - b) / 2, e));
+	}
+	std::sort(box_begin.begin(), box_begin.end());
+	box_begin.push_back(n);
+	int n_boxes = (int)box_begin.size() - 1;
+	int n_fields = _evaluator->n_fields();
+	std::vector<int> root(1, 0);
+	if (_clusters.empty()) root.clear();
+
+	// points spread over sample boxes, summed directly and through the tree
+	int n_samples = std::min(n_boxes, 8);
+	std::vector<int> sample_box(n_samples);
+	std::vector< std::vector<int> > sample_points(n_samples);
+	std::vector<MatrixXd> exact(n_samples);
+	Tiled_Evaluator::Workspace workspace;
+	for (int s = 0; s < n_samples; s++ )
+	{
+		sample_box[s] = (s*n_boxes) / n_samples;
+		int b = sample_box[s];
+		int size = box_begin[b + 1] - box_begin[b];
+		int step = std::max(1, size / Tiled_Evaluator::point_block);
+		for (int j = 0; j < size && (int)sample_points[s].size() < Tiled_Evaluator::point_block; j += step ) sample_points[s].push_back(order[box_begin[b] + j]);
+		int nb = (int)sample_points[s].size();
+		_evaluate_direct(pts, &sample_points[s][0], nb, workspace);
+		exact[s].resize(nb, n_fields);
+		for (int i = 0; i < nb; i++ )
+			for (int f = 0; f < n_fields; f++ ) exact[s](i, f) = _field(pts[sample_points[s][i]], f, n_fields);
+	}
+	// the sample boxes are evaluated at the final degree on the way, only the others remain
+	int degree = std::min(4, max_degree);
+	std::vector<bool> done(n_boxes, false);
+	for (int s = 0; s < n_samples; s++ ) done[sample_box[s]] = true;
+	while (true)
+	{
+		_compute_proxies(degree);
+		std::vector<double> errors(n_samples, 0.0);
+		#pragma omp parallel
+		{
+			Tiled_Evaluator::Workspace box_workspace;
+			#pragma omp for schedule(dynamic)
+			for (int s = 0; s < n_samples; s++ )
+			{
+				int b = sample_box[s];
+				_evaluate_node(pts, &order[box_begin[b]], box_begin[b + 1] - box_begin[b], NULL, root, box_workspace);
+				for (int i = 0; i < (int)sample_points[s].size(); i++ )
+					for (int f = 0; f < n_fields; f++ )
+						errors[s] = std::max(errors[s], fabs(_field(pts[sample_points[s][i]], f, n_fields) - exact[s](i, f)));
+			}
+		}
+		_error_estimate = 0.0;
+		for (int s = 0; s < n_samples; s++ ) _error_estimate = std::max(_error_estimate, errors[s]);
+		if (_error_estimate <= tolerance || degree >= max_degree) break;
+		degree = std::min(degree + 2, max_degree);
+	}
+
+	#pragma omp parallel
+	{
+		Tiled_Evaluator::Workspace box_workspace;
+		#pragma omp for schedule(dynamic)
+		for (int b = 0; b < n_boxes; b++ )
+			if (!done[b]) _evaluate_node(pts, &order[box_begin[b]], box_begin[b + 1] - box_begin[b], NULL, root, box_workspace);
+	}
+	return _error_estimate <= tolerance;
+}
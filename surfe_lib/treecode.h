@@ -0,0 +1,104 @@
+// SURFace Estimator(SURFE) - Terms and Conditions of Use
+
+// Unless otherwise noted, computer program source code of the SURFace Estimator(SURFE)
+// is covered under Crown Copyright, Government of Canada, and is distributed under the MIT License.
+
+// The Canada wordmark and related graphics associated with this distribution are protected under 
+// trademark law and copyright law.No permission is granted to use them outside the parameters of 
+// the Government of Canada's corporate identity program. For more information, see
+// http://www.tbs-sct.gc.ca/fip-pcim/index-eng.asp
+
+// Copyright title to all 3rd party software distributed with the SURFace Estimator(SURFE) is held 
+// by the respective copyright holders as noted in those files.Users are asked to read the 3rd Party
+// Licenses referenced with those assets.
+
+// MIT License
+
+// Copyright(c) 2017 Government of Canada
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this software 
+// and associated documentation files(the "Software"), to deal in the Software without restriction,
+// including without limitation the rights to use, copy, modify, merge, publish, distribute, 
+// sublicense, and / or sell copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions :
+
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT
+// NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+// DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, 
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#ifndef treecode_h
+#define treecode_h
+
+#include <surfe_lib_module.h> // macro for importing / exporting dll
+
+#include <tiled_evaluation.h>
+
+#include <vector>
+#include <Eigen/Core>
+
+using namespace Eigen;
+
+// Approximate evaluation of a packed interpolant at many points (barycentric Lagrange dual tree treecode). The centers
+// are sorted in an octree. Far from a group of evaluation points, a cluster of centers is replaced by proxy point
+// centers on a tensor Chebyshev grid of its box, with charges from interpolating the kernel in its second argument:
+// q_k = sum_j w_j L_j(l_k), L_j the functional of center j (point evaluation or directional derivative) and l_k the
+// Lagrange polynomial of proxy k. The evaluation points are bisected into a tree whose leaves are batches. A cluster far
+// from a node of that tree is summed at the Chebyshev points of the node only, and passed down by interpolation, which
+// is what makes dense grids cheap. Near clusters reach the batches and are summed through their proxies or directly
+// in tiles. Only kernel values are needed (kernel independent). The interpolation degree is raised until the error
+// measured against a direct sum at sample points meets the tolerance.
+class SURFE_LIB_EXPORT Treecode_Evaluator {
+private:
+	struct Cluster {
+		double center[3];
+		double half_width[3];
+		double radius;
+		int begin; // centers [begin, end) in tree order
+		int end;
+		int first_child; // children are consecutive, -1 for a leaf
+		int n_children;
+		int proxy_begin; // -1 if cheaper to sum directly than through its proxies
+	};
+	// a node of the tree of evaluation points
+	struct Target_Node {
+		double center[3];
+		double half_width[3];
+		double radius;
+		bool has_far_field;
+		MatrixXd far_field; // at the Chebyshev points of the box (n points x n fields)
+	};
+	const Tiled_Evaluator *_evaluator;
+	double _theta;
+	int _leaf_size;
+	int _box_size;
+	int _degree;
+	double _error_estimate;
+	Packed_Centers _centers; // in tree order
+	std::vector<Cluster> _clusters;
+	Packed_Centers _proxies;
+	void _build_tree(const Packed_Centers &centers);
+	void _compute_proxies(const int &degree);
+	void _bisect(const std::vector<Evaluation_Point> &pts, int *indices, const int &n, int &axis) const;
+	void _evaluate_direct(std::vector<Evaluation_Point> &pts, const int *indices, const int &nb, Tiled_Evaluator::Workspace &workspace) const;
+	void _evaluate_node(std::vector<Evaluation_Point> &pts, int *indices, const int &n, const Target_Node *parent,
+		const std::vector<int> &pending, Tiled_Evaluator::Workspace &workspace) const;
+public:
+	// theta: a cluster is approximated at a group of points if (group radius + cluster radius) < theta * distance.
+	// leaf_size: # of centers of the octree leaves, box_size: # of evaluation points of a box
+	Treecode_Evaluator(const Tiled_Evaluator &evaluator, const double &theta = 0.7, const int &leaf_size = 64, const int &box_size = 4096);
+	// false if the centers use the fourth coordinate c
+	bool supported() const;
+	// scalar field(s) of pts with an absolute error target. False if the tolerance is not met at the highest degree
+	// (the field is still evaluated)
+	bool evaluate(std::vector<Evaluation_Point> &pts, const double &tolerance, const int &max_degree = 12);
+	// largest error measured on the sample batches at the last degree used
+	double error_estimate() const { return _error_estimate; }
+	int degree() const { return _degree; }
+};
+
+#endif
@@ -122,9 +122,9 @@ bool Vector_Field::setup_system_solver()
 	MatrixXd interpolation_matrix(n, n);
 	if (!get_interpolation_matrix(interpolation_matrix)) return false;
 
-	Linear_LU_decomposition llu(interpolation_matrix,equality_values);
-	if (!llu.solve()) return false;
-	solver = &llu;
+	System_Solver *llu = Linear_Solver_Selector::create(interpolation_matrix,equality_values,m_parameters,b_parameters);
+	if (!llu->solve()) return false;
+	solver = llu;
 
 	return true;
 }